@@ -0,0 +1,872 @@
+// src/bench/Benchmark.cpp
+
+/*
+    Microbenchmarks dos kernels usados na extração e na busca.
+    Uso: analise_bench [secao...]   (sem argumentos executa todas as seções)
+ */
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/DistanceTile.h"
+#include "core/Epoch.h"
+#include "core/FeatureStore.h"
+#include "core/HalfStore.h"
+#include "core/Histogram.h"
+#include "core/Metric.h"
+#include "core/QuantizedStore.h"
+#include "core/Vector.h"
+#include "core/ThreadPool.h"
+#include "core/Timer.h"
+#include "structure/HashTable.h"
+#include "structure/LSH.h"
+#include "structure/List.h"
+#include "structure/MTree.h"
+#include "structure/PQ.h"
+
+using namespace std;
+
+namespace
+{
+
+// Executa fn repetidamente por pelo menos minMs e retorna o tempo médio em ms
+double measure(const function<void()> &fn, double minMs = 200.0)
+{
+    fn(); // aquecimento
+    Timer timer;
+    int runs = 0;
+    do
+    {
+        fn();
+        runs++;
+    } while (timer.elapsed_milliseconds() < minMs);
+    return timer.elapsed_milliseconds() / runs;
+}
+
+// Imagem RGB sintética: "ruido" espalha os acessos, "suave" imita fotos reais,
+// com longas sequências de pixels no mesmo bin
+vector<unsigned char> syntheticImage(size_t pixels, bool noise)
+{
+    vector<unsigned char> rgb(pixels * 3);
+    mt19937 gen(7);
+    uniform_int_distribution<int> byte(0, 255);
+    for (size_t i = 0; i < pixels; i++)
+    {
+        if (noise)
+        {
+            rgb[i * 3 + 0] = static_cast<unsigned char>(byte(gen));
+            rgb[i * 3 + 1] = static_cast<unsigned char>(byte(gen));
+            rgb[i * 3 + 2] = static_cast<unsigned char>(byte(gen));
+        }
+        else
+        {
+            const size_t x = i % 4000, y = i / 4000;
+            rgb[i * 3 + 0] = static_cast<unsigned char>(x / 16);
+            rgb[i * 3 + 1] = static_cast<unsigned char>(y / 12);
+            rgb[i * 3 + 2] = static_cast<unsigned char>((x + y) / 32);
+        }
+    }
+    return rgb;
+}
+
+void benchHistogram()
+{
+    cout << "\n=== Histograma de cores (ms por megapixel) ===" << endl;
+
+    const size_t pixels = 12000000; // foto de 12 MP
+    const double megapixels = pixels / 1e6;
+    const HistogramKernel kernels[] = {HistogramKernel::Reference, HistogramKernel::Scalar,
+                                       HistogramKernel::SSSE3, HistogramKernel::AVX2};
+
+    for (bool noise : {false, true})
+    {
+        const vector<unsigned char> rgb = syntheticImage(pixels, noise);
+        for (int bins : {4, 8, 16})
+        {
+            const size_t size = static_cast<size_t>(bins) * bins * bins;
+            vector<uint32_t> expected(size), counts(size);
+            computeColorHistogram(rgb.data(), pixels, bins, expected.data(), HistogramKernel::Reference);
+
+            cout << (noise ? "ruido" : "suave") << " bins=" << setw(2) << bins << ":";
+            double referenceMs = 0.0;
+            for (HistogramKernel kernel : kernels)
+            {
+                if (!isHistogramKernelSupported(kernel))
+                    continue;
+
+                const double ms = measure([&]
+                                          { computeColorHistogram(rgb.data(), pixels, bins, counts.data(), kernel); });
+                if (kernel == HistogramKernel::Reference)
+                    referenceMs = ms;
+
+                const bool ok = counts == expected;
+                cout << "  " << histogramKernelName(kernel) << " " << fixed << setprecision(3) << ms / megapixels
+                     << (ok ? "" : " (DIVERGE!)");
+                if (kernel != HistogramKernel::Reference)
+                    cout << " (" << setprecision(1) << referenceMs / ms << "x)";
+            }
+            cout << endl;
+        }
+    }
+}
+
+void benchDistance()
+{
+    cout << "\n=== Distancia euclidiana (ns por distancia) ===" << endl;
+
+    const DistanceKernel kernels[] = {DistanceKernel::Reference, DistanceKernel::SSE2, DistanceKernel::AVX2,
+                                      DistanceKernel::AVX512};
+    mt19937 gen(11);
+    uniform_real_distribution<float> value(0.0f, 1.0f);
+
+    for (size_t dim : {64, 512, 4096})
+    {
+        // Base de ~8 MB (maior que o cache L2) comparada com uma consulta fixa
+        const size_t count = max<size_t>(256, (8u << 20) / (dim * sizeof(float)));
+        vector<float> base(count * dim), query(dim);
+        for (float &v : base)
+            v = value(gen);
+        for (float &v : query)
+            v = value(gen);
+
+        vector<double> expected(count), distances(count);
+        for (size_t i = 0; i < count; i++)
+            expected[i] = euclideanDistance(query.data(), base.data() + i * dim, dim, DistanceKernel::Reference);
+
+        cout << "dim=" << setw(4) << dim << ":";
+        double referenceNs = 0.0;
+        for (DistanceKernel kernel : kernels)
+        {
+            if (!isDistanceKernelSupported(kernel))
+                continue;
+
+            const double ms = measure([&]
+                                      {
+                for (size_t i = 0; i < count; i++)
+                    distances[i] = euclideanDistance(query.data(), base.data() + i * dim, dim, kernel); });
+            const double ns = ms * 1e6 / count;
+            if (kernel == DistanceKernel::Reference)
+                referenceNs = ns;
+
+            double maxError = 0.0;
+            for (size_t i = 0; i < count; i++)
+                maxError = max(maxError, fabs(distances[i] - expected[i]) / expected[i]);
+
+            cout << "  " << distanceKernelName(kernel) << " " << fixed << setprecision(1) << ns
+                 << (maxError < 1e-5 ? "" : " (DIVERGE!)");
+            if (kernel != DistanceKernel::Reference)
+                cout << " (" << referenceNs / ns << "x)";
+        }
+
+        // Melhor kernel com a dimensão como constante de compilação (quando especializada)
+        dispatchDimension(dim, [&](auto fixedDim)
+                          {
+            constexpr size_t Dim = decltype(fixedDim)::value;
+            if (Dim == DYNAMIC_DIMENSION)
+                return;
+            const double ms = measure([&]
+                                      {
+                for (size_t i = 0; i < count; i++)
+                    distances[i] = sqrt(squaredEuclideanDistance<Dim>(query.data(), base.data() + i * dim, dim)); });
+            cout << "  fixo " << ms * 1e6 / count; });
+        cout << endl;
+    }
+}
+
+// Histogramas sintéticos normalizados, agrupados em torno de 64 protótipos
+// (fotos parecidas têm histogramas parecidos); poucos bins concentram a massa
+vector<float> syntheticHistograms(size_t count, size_t dim, unsigned seed)
+{
+    mt19937 prototypeGen(1);
+    mt19937 gen(seed);
+    exponential_distribution<float> mass(1.0f);
+    uniform_int_distribution<size_t> bin(0, dim - 1);
+
+    const size_t prototypes = 64;
+    vector<float> prototype(prototypes * dim);
+    for (size_t p = 0; p < prototypes; p++)
+    {
+        for (int k = 0; k < 32; k++)
+            prototype[p * dim + bin(prototypeGen)] += mass(prototypeGen);
+    }
+
+    vector<float> data(count * dim);
+    uniform_int_distribution<size_t> pick(0, prototypes - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        float *h = data.data() + i * dim;
+        const float *p = prototype.data() + pick(gen) * dim;
+        copy(p, p + dim, h);
+        for (int k = 0; k < 8; k++)
+            h[bin(gen)] += 0.2f * mass(gen);
+
+        float total = 0.0f;
+        for (size_t d = 0; d < dim; d++)
+            total += h[d];
+        for (size_t d = 0; d < dim; d++)
+            h[d] /= total;
+    }
+    return data;
+}
+
+void benchMetric()
+{
+    cout << "\n=== Metricas entre histogramas (ns por distancia, dim=512) ===" << endl;
+
+    const DistanceKernel kernels[] = {DistanceKernel::Reference, DistanceKernel::SSE2, DistanceKernel::AVX2,
+                                      DistanceKernel::AVX512};
+    const MetricKind metrics[] = {MetricKind::Euclidean, MetricKind::L1, MetricKind::ChiSquare,
+                                  MetricKind::Intersection, MetricKind::Hellinger, MetricKind::Cosine};
+    const size_t dim = 512;
+    const size_t count = (8u << 20) / (dim * sizeof(float));
+    const vector<float> base = syntheticHistograms(count, dim, 3);
+    const vector<float> query = syntheticHistograms(1, dim, 5);
+
+    for (MetricKind metric : metrics)
+    {
+        vector<double> expected(count), scores(count);
+        for (size_t i = 0; i < count; i++)
+            expected[i] = metricScore(metric, query.data(), base.data() + i * dim, dim, DistanceKernel::Reference);
+
+        cout << setw(11) << metricName(metric) << ":";
+        double referenceNs = 0.0;
+        for (DistanceKernel kernel : kernels)
+        {
+            if (!isDistanceKernelSupported(kernel))
+                continue;
+
+            const double ms = measure([&]
+                                      {
+                for (size_t i = 0; i < count; i++)
+                    scores[i] = metricScore(metric, query.data(), base.data() + i * dim, dim, kernel); });
+            const double ns = ms * 1e6 / count;
+            if (kernel == DistanceKernel::Reference)
+                referenceNs = ns;
+
+            double maxError = 0.0;
+            for (size_t i = 0; i < count; i++)
+                maxError = max(maxError, fabs(scores[i] - expected[i]) / max(fabs(expected[i]), 1e-6));
+
+            cout << "  " << distanceKernelName(kernel) << " " << fixed << setprecision(1) << ns
+                 << (maxError < 1e-4 ? "" : " (DIVERGE!)");
+            if (kernel != DistanceKernel::Reference)
+                cout << " (" << referenceNs / ns << "x)";
+        }
+        cout << endl;
+    }
+}
+
+void benchEarlyAbandon()
+{
+    cout << "\n=== Busca linear: distancia completa x abandono antecipado (ms por consulta) ===" << endl;
+
+    for (size_t dim : {64, 512, 4096})
+    {
+        const size_t count = max<size_t>(1000, (16u << 20) / (dim * sizeof(float)));
+        const vector<float> base = syntheticHistograms(count, dim, 3);
+        const vector<float> queries = syntheticHistograms(16, dim, 5);
+
+        auto scan = [&](bool bounded, vector<size_t> &nearest)
+        {
+            for (size_t q = 0; q < 16; q++)
+            {
+                const float *query = queries.data() + q * dim;
+                double best = numeric_limits<double>::infinity();
+                for (size_t i = 0; i < count; i++)
+                {
+                    const double d = squaredEuclideanDistance(query, base.data() + i * dim, dim,
+                                                              bounded ? best : numeric_limits<double>::infinity());
+                    if (d < best)
+                    {
+                        best = d;
+                        nearest[q] = i;
+                    }
+                }
+            }
+        };
+
+        vector<size_t> full(16), bounded(16);
+        const double fullMs = measure([&]
+                                      { scan(false, full); }) / 16;
+        const double boundedMs = measure([&]
+                                         { scan(true, bounded); }) / 16;
+
+        cout << "dim=" << setw(4) << dim << " (" << count << " vetores):  completa " << fixed << setprecision(3)
+             << fullMs << "  abandono " << boundedMs << " (" << setprecision(1) << fullMs / boundedMs << "x)"
+             << (full == bounded ? "" : " (DIVERGE!)") << endl;
+    }
+}
+
+void benchTile()
+{
+    cout << "\n=== Busca linear: par a par (abandono) x blocos com normas (ms por consulta) ===" << endl;
+
+    // Base no L2 (256 KiB) e na memória principal (16 MiB)
+    for (size_t bytes : {256u << 10, 16u << 20})
+    for (size_t dim : {64, 512, 4096})
+    {
+        const size_t count = bytes / (dim * sizeof(float));
+        const vector<float> base = syntheticHistograms(count, dim, 3);
+        const vector<float> queries = syntheticHistograms(16, dim, 5);
+
+        FeatureStore store;
+        store.reserve(count, dim);
+        for (size_t i = 0; i < count; i++)
+            store.add("", base.data() + i * dim, dim, 0.0);
+
+        vector<size_t> pairwise(16), tiled(16);
+        const double pairMs = measure([&]
+                                      {
+            for (size_t q = 0; q < 16; q++)
+            {
+                const float *query = queries.data() + q * dim;
+                double best = numeric_limits<double>::infinity();
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const double d = squaredEuclideanDistance(query, store.features(i), dim, best);
+                    if (d < best)
+                    {
+                        best = d;
+                        pairwise[q] = i;
+                    }
+                }
+            } }) / 16;
+
+        const double tileMs = measure([&]
+                                      {
+            for (size_t q = 0; q < 16; q++)
+            {
+                const float *query = queries.data() + q * dim;
+                double best = numeric_limits<double>::infinity();
+                tiled[q] = store.nearestAmong<DYNAMIC_DIMENSION>(query, squaredNorm(query, dim), nullptr, 0, count, -1, best);
+            } }) / 16;
+
+        const double gbPerS = count * dim * sizeof(float) / (tileMs * 1e6);
+        cout << "dim=" << setw(4) << dim << " (" << count << " vetores, bloco de " << distanceTileRows(store.stride())
+             << "):  par a par " << fixed << setprecision(3) << pairMs << "  blocos " << tileMs << " ("
+             << setprecision(1) << pairMs / tileMs << "x, " << gbPerS << " GB/s)"
+             << (pairwise == tiled ? "" : " (DIVERGE!)") << endl;
+    }
+}
+
+void benchParallel()
+{
+    cout << "\n=== Busca exata: em serie x paralela por fatias (ms por consulta) ===" << endl;
+
+    const size_t queryCount = 16;
+    const size_t hardware = max<size_t>(1, thread::hardware_concurrency());
+    for (size_t dim : {64, 512, 4096})
+    {
+        // Base de 128 MiB: bem maior que o cache, limitada pela banda de memória
+        const size_t count = (128u << 20) / (dim * sizeof(float));
+        const vector<float> base = syntheticHistograms(count, dim, 3);
+        const vector<float> queryData = syntheticHistograms(queryCount, dim, 5);
+
+        FeatureStore store;
+        store.reserve(count, dim);
+        for (size_t i = 0; i < count; i++)
+            store.add("", base.data() + i * dim, dim, 0.0);
+
+        ImageList list(store);
+        for (uint32_t id = 0; id < count; id++)
+            list.addImage(id);
+
+        vector<FeatureVector> queries;
+        for (size_t q = 0; q < queryCount; q++)
+            queries.emplace_back(queryData.data() + q * dim, queryData.data() + (q + 1) * dim);
+
+        auto run = [&](ThreadPool *pool, vector<int> &nearest)
+        {
+            for (size_t q = 0; q < queryCount; q++)
+                nearest[q] = list.findNearest(queries[q], -1, pool);
+        };
+
+        vector<int> serial(queryCount);
+        const double serialMs = measure([&]
+                                        { run(nullptr, serial); }) / queryCount;
+        cout << "dim=" << setw(4) << dim << " (" << count << " vetores):  serie " << fixed << setprecision(3)
+             << serialMs;
+
+        for (size_t threads = 2; threads <= hardware; threads *= 2)
+        {
+            ThreadPool pool(threads);
+            vector<int> parallel(queryCount);
+            const double parallelMs = measure([&]
+                                              { run(&pool, parallel); }) / queryCount;
+            cout << "  " << threads << "t " << setprecision(3) << parallelMs << " (" << setprecision(1)
+                 << serialMs / parallelMs << "x)" << (parallel == serial ? "" : " (DIVERGE!)");
+        }
+        cout << endl;
+    }
+}
+
+void benchKNearest()
+{
+    cout << "\n=== Top-k: varredura da lista x M-Tree com poda pelo k-esimo (ms por consulta) ===" << endl;
+
+    const size_t queryCount = 64;
+    const size_t dim = 64;
+    const size_t count = 20000;
+    const vector<float> base = syntheticHistograms(count, dim, 3);
+    const vector<float> queryData = syntheticHistograms(queryCount, dim, 5);
+
+    FeatureStore store;
+    store.reserve(count, dim);
+    for (size_t i = 0; i < count; i++)
+        store.add("", base.data() + i * dim, dim, 0.0);
+
+    ImageList list(store);
+    MTree tree(store);
+    vector<uint32_t> ids(count);
+    for (uint32_t id = 0; id < count; id++)
+    {
+        list.addImage(id);
+        ids[id] = id;
+    }
+    tree.insertBatch(ids.data(), ids.size());
+
+    vector<FeatureVector> queries;
+    for (size_t q = 0; q < queryCount; q++)
+        queries.emplace_back(queryData.data() + q * dim, queryData.data() + (q + 1) * dim);
+
+    // O mesmo vetor de resultados é reaproveitado entre as consultas
+    vector<Neighbor> listOut, treeOut;
+    for (size_t k : {1, 10, 50})
+    {
+        bool same = true;
+        const double listMs = measure([&]
+                                      {
+            for (const FeatureVector &query : queries)
+                list.findKNearest(query, k, listOut); }) / queryCount;
+        const double treeMs = measure([&]
+                                      {
+            for (const FeatureVector &query : queries)
+                tree.findKNearest(query, k, treeOut); }) / queryCount;
+        for (const FeatureVector &query : queries)
+        {
+            list.findKNearest(query, k, listOut);
+            tree.findKNearest(query, k, treeOut);
+            for (size_t i = 0; i < listOut.size(); i++)
+                same = same && i < treeOut.size() && listOut[i].id == treeOut[i].id;
+        }
+        cout << "k=" << setw(2) << k << " (" << count << " vetores, dim=" << dim << "):  lista " << fixed
+             << setprecision(3) << listMs << "  M-Tree " << treeMs << " (" << setprecision(1) << listMs / treeMs
+             << "x)" << (same ? "" : " (DIVERGE!)") << endl;
+    }
+}
+
+void benchIngestion()
+{
+    cout << "\n=== Ingestao concorrente: Lista + LSH + M-Tree com leitores por epocas ===" << endl;
+
+    const size_t dim = 64;
+    const size_t count = 50000;
+    const size_t readerCount = 2;
+    const vector<float> base = syntheticHistograms(count, dim, 3);
+    const vector<float> queryData = syntheticHistograms(64, dim, 5);
+
+    vector<FeatureVector> queries;
+    for (size_t q = 0; q < 64; q++)
+        queries.emplace_back(queryData.data() + q * dim, queryData.data() + (q + 1) * dim);
+
+    // Mesma sequência de inserções, primeiro sem leitores e depois com eles
+    for (size_t readers : {size_t(0), readerCount})
+    {
+        FeatureStore store;
+        ImageList list(store);
+        LSH lsh(store, static_cast<int>(dim), 5, 12);
+        MTree tree(store);
+
+        atomic<bool> done(false);
+        atomic<size_t> answered(0);
+        vector<thread> threads;
+        for (size_t r = 0; r < readers; r++)
+        {
+            threads.emplace_back([&, r]()
+                                 {
+                vector<Neighbor> top;
+                int comparisons = 0;
+                for (size_t q = r; !done.load(memory_order_acquire); q++)
+                {
+                    const FeatureVector &query = queries[q % queries.size()];
+                    tree.findKNearest(query, 10, top);
+                    lsh.findNearest(query, -1, &comparisons);
+                    answered.fetch_add(1, memory_order_relaxed);
+                } });
+        }
+
+        Timer timer;
+        timer.start();
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint32_t id = store.add("", base.data() + i * dim, dim, 0.0);
+            list.addImage(id);
+            lsh.addImage(id);
+            tree.insert(id);
+        }
+        const double ingestMs = timer.elapsed_milliseconds();
+        done.store(true, memory_order_release);
+        for (thread &t : threads)
+            t.join();
+
+        // Depois da ingestão os índices devem responder como se montados sem leitores
+        bool same = true;
+        vector<Neighbor> listTop, treeTop;
+        for (const FeatureVector &query : queries)
+        {
+            list.findKNearest(query, 10, listTop);
+            tree.findKNearest(query, 10, treeTop);
+            for (size_t i = 0; i < listTop.size(); i++)
+                same = same && i < treeTop.size() && listTop[i].id == treeTop[i].id;
+        }
+
+        cout << readers << " leitores: " << count << " insercoes em " << fixed << setprecision(1) << ingestMs
+             << " ms (" << setprecision(2) << 1000.0 * ingestMs / count << " us cada)";
+        if (readers > 0)
+            cout << ", " << answered.load() << " consultas top-10 + LSH durante a carga ("
+                 << setprecision(0) << answered.load() / (ingestMs / 1000.0) << "/s)";
+        cout << ", fila de epocas " << defaultEpochDomain().pending() << (same ? "" : " (DIVERGE!)") << endl;
+        defaultEpochDomain().reclaim();
+    }
+}
+
+void benchPathLookup()
+{
+    cout << "\n=== HashTable: insercao e busca por caminho (enderecamento aberto) ===" << endl;
+
+    const float feature = 0.0f;
+    for (size_t count : {size_t(10000), size_t(100000), size_t(1000000), size_t(4000000)})
+    {
+        FeatureStore store;
+        store.reserve(count, 1);
+        vector<string> names(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            names[i] = "img_" + to_string(i * 2654435761u % 1000000007u) + ".jpg";
+            store.add("dataset/classe_" + to_string(i % 10) + "/" + names[i], &feature, 1, 0.0);
+        }
+
+        // Começa pela capacidade padrão: o tempo inclui todos os rehashes
+        HashTable table(store);
+        Timer timer;
+        timer.start();
+        for (size_t i = 0; i < count; i++)
+            table.addImage(static_cast<uint32_t>(i));
+        const double insertMs = timer.elapsed_milliseconds();
+
+        // Ordem embaralhada para não favorecer a cache
+        const size_t lookups = 1000000;
+        mt19937 gen(11);
+        uniform_int_distribution<size_t> pick(0, count - 1);
+        vector<uint32_t> order(lookups);
+        for (uint32_t &id : order)
+            id = static_cast<uint32_t>(pick(gen));
+
+        bool same = true;
+        timer.start();
+        for (uint32_t id : order)
+            same = same && table.findByPath(names[id]) == static_cast<int>(id);
+        const double lookupMs = timer.elapsed_milliseconds();
+        same = same && !table.contains("ausente.jpg");
+
+        cout << setw(8) << count << " imagens: insercao " << fixed << setprecision(1) << 1e6 * insertMs / count
+             << " ns cada, busca por nome " << 1e6 * lookupMs / lookups << " ns" << (same ? "" : " (DIVERGE!)")
+             << endl;
+    }
+}
+
+void benchBatch()
+{
+    cout << "\n=== Busca em lote: consultas uma a uma x findNearestBatch (ms por lote) ===" << endl;
+
+    const size_t queryCount = 256;
+    for (size_t dim : {64, 512})
+    {
+        const size_t count = (16u << 20) / (dim * sizeof(float));
+        const vector<float> base = syntheticHistograms(count, dim, 3);
+        const vector<float> queryData = syntheticHistograms(queryCount, dim, 5);
+
+        FeatureStore store, queries;
+        store.reserve(count, dim);
+        for (size_t i = 0; i < count; i++)
+            store.add("", base.data() + i * dim, dim, 0.0);
+        for (size_t q = 0; q < queryCount; q++)
+            queries.add("", queryData.data() + q * dim, dim, 0.0);
+
+        ImageList list(store);
+        for (uint32_t id = 0; id < count; id++)
+            list.addImage(id);
+
+        vector<int> single(queryCount), batch;
+        const double singleMs = measure([&]
+                                        {
+            for (uint32_t q = 0; q < queryCount; q++)
+                single[q] = list.findNearest(queries.copyFeatures(q), -1); });
+        const double batchMs = measure([&]
+                                       { batch = list.findNearestBatch(queries); });
+
+        // Distâncias que divergem só por arredondamento contam como iguais
+        size_t differ = 0;
+        for (uint32_t q = 0; q < queryCount; q++)
+        {
+            if (single[q] != batch[q] &&
+                fabs(squaredEuclideanDistance(queries.features(q), store.features(single[q]), dim) -
+                     squaredEuclideanDistance(queries.features(q), store.features(batch[q]), dim)) > 1e-6)
+                differ++;
+        }
+
+        const double gflops = 2.0 * dim * count * queryCount / (batchMs * 1e6);
+        cout << "dim=" << setw(4) << dim << " (" << count << " vetores x " << queryCount << " consultas):  uma a uma "
+             << fixed << setprecision(1) << singleMs << "  lote " << batchMs << " (" << singleMs / batchMs << "x, "
+             << gflops << " GFLOP/s)" << (differ == 0 ? "" : " (DIVERGE!)") << endl;
+    }
+}
+
+void benchQuantized()
+{
+    cout << "\n=== Busca linear: floats x codigos de 8 bits + reordenacao (ms por consulta) ===" << endl;
+
+    const size_t queryCount = 64;
+    for (size_t dim : {64, 512})
+    {
+        const size_t count = (16u << 20) / (dim * sizeof(float));
+        const vector<float> base = syntheticHistograms(count, dim, 3);
+        const vector<float> queryData = syntheticHistograms(queryCount, dim, 5);
+
+        FeatureStore store;
+        store.reserve(count, dim);
+        for (size_t i = 0; i < count; i++)
+            store.add("", base.data() + i * dim, dim, 0.0);
+
+        ImageList list(store);
+        for (uint32_t id = 0; id < count; id++)
+            list.addImage(id);
+
+        vector<FeatureVector> queries;
+        for (size_t q = 0; q < queryCount; q++)
+            queries.emplace_back(queryData.data() + q * dim, queryData.data() + (q + 1) * dim);
+
+        auto run = [&](vector<int> &nearest)
+        {
+            for (size_t q = 0; q < queryCount; q++)
+                nearest[q] = list.findNearest(queries[q], -1);
+        };
+
+        vector<int> exact(queryCount);
+        const double exactMs = measure([&]
+                                       { run(exact); }) / queryCount;
+        cout << "dim=" << setw(4) << dim << " (" << count << " vetores, " << store.memoryBytes() / (1 << 20)
+             << " MiB):  floats " << fixed << setprecision(3) << exactMs << endl;
+
+        for (QuantizationRange range : {QuantizationRange::Global, QuantizationRange::PerDimension})
+        {
+            const QuantizedStore quantized(store, range);
+            for (size_t shortlist : {8, 32})
+            {
+                list.useQuantized(&quantized, shortlist);
+                vector<int> approx(queryCount);
+                const double quantMs = measure([&]
+                                               { run(approx); }) / queryCount;
+
+                size_t hits = 0;
+                for (size_t q = 0; q < queryCount; q++)
+                    hits += approx[q] == exact[q];
+
+                cout << "  8 bits " << (range == QuantizationRange::Global ? "global" : "por dim") << ", lista "
+                     << setw(2) << shortlist << " (" << quantized.memoryBytes() / (1 << 20) << " MiB):  "
+                     << setprecision(3) << quantMs << " (" << setprecision(1) << exactMs / quantMs
+                     << "x, acerto " << 100.0 * hits / queryCount << "%)" << endl;
+            }
+        }
+        list.useQuantized(nullptr);
+    }
+}
+
+void benchHalf()
+{
+    cout << "\n=== Busca linear: floats x 16 bits (fp16/bf16) (ms por consulta) ===" << endl;
+
+    const size_t queryCount = 64;
+    for (size_t dim : {64, 512, 4096})
+    {
+        const size_t count = (32u << 20) / (dim * sizeof(float));
+        const vector<float> base = syntheticHistograms(count, dim, 3);
+        const vector<float> queryData = syntheticHistograms(queryCount, dim, 5);
+
+        FeatureStore store;
+        store.reserve(count, dim);
+        for (size_t i = 0; i < count; i++)
+            store.add("", base.data() + i * dim, dim, 0.0);
+
+        ImageList list(store);
+        for (uint32_t id = 0; id < count; id++)
+            list.addImage(id);
+
+        vector<FeatureVector> queries;
+        for (size_t q = 0; q < queryCount; q++)
+            queries.emplace_back(queryData.data() + q * dim, queryData.data() + (q + 1) * dim);
+
+        auto run = [&](vector<int> &nearest)
+        {
+            for (size_t q = 0; q < queryCount; q++)
+                nearest[q] = list.findNearest(queries[q], -1);
+        };
+
+        vector<int> exact(queryCount);
+        const double exactMs = measure([&]
+                                       { run(exact); }) / queryCount;
+        cout << "dim=" << setw(4) << dim << " (" << count << " vetores, " << store.memoryBytes() / (1 << 20)
+             << " MiB):  floats " << fixed << setprecision(3) << exactMs << endl;
+
+        for (HalfFormat format : {HalfFormat::FP16, HalfFormat::BF16})
+        {
+            const HalfStore half(store, format);
+
+            // Todos os kernels devem dar a mesma distância (a menos da ordem das somas)
+            bool diverge = false;
+            for (size_t q = 0; q < 4; q++)
+            {
+                const double reference = squaredHalfDistance(format, queries[q].data(), half.features(0), dim,
+                                                             DistanceKernel::Reference);
+                for (DistanceKernel kernel : {DistanceKernel::AVX2, DistanceKernel::AVX512})
+                {
+                    const double d = squaredHalfDistance(format, queries[q].data(), half.features(0), dim, kernel);
+                    diverge = diverge || fabs(d - reference) > 1e-4 * reference;
+                }
+            }
+
+            list.useHalf(&half);
+            vector<int> approx(queryCount);
+            const double halfMs = measure([&]
+                                          { run(approx); }) / queryCount;
+
+            // Deriva: vizinhos diferentes e quanto o escolhido está mais longe que o exato
+            size_t hits = 0;
+            double worstExcess = 0.0;
+            for (size_t q = 0; q < queryCount; q++)
+            {
+                hits += approx[q] == exact[q];
+                const double exactDistance = euclideanDistance(queries[q].data(), store.features(exact[q]), dim);
+                const double foundDistance = euclideanDistance(queries[q].data(), store.features(approx[q]), dim);
+                worstExcess = max(worstExcess, (foundDistance - exactDistance) / exactDistance);
+            }
+
+            cout << "  " << halfFormatName(format) << " (" << half.memoryBytes() / (1 << 20) << " MiB):  "
+                 << setprecision(3) << halfMs << " (" << setprecision(1) << exactMs / halfMs << "x, acerto "
+                 << 100.0 * hits / queryCount << "%, vizinho ate " << setprecision(3) << 100.0 * worstExcess
+                 << "% mais distante)" << (diverge ? " (DIVERGE!)" : "") << endl;
+        }
+        list.useHalf(nullptr);
+    }
+}
+
+void benchPQ()
+{
+    cout << "\n=== PQ: busca exata x ADC (8 bits) x fast-scan (4 bits) (ms por consulta) ===" << endl;
+
+    const size_t queryCount = 64;
+    for (size_t dim : {64, 512})
+    {
+        const size_t count = (16u << 20) / (dim * sizeof(float));
+        const vector<float> base = syntheticHistograms(count, dim, 3);
+        const vector<float> queryData = syntheticHistograms(queryCount, dim, 5);
+
+        FeatureStore store;
+        store.reserve(count, dim);
+        for (size_t i = 0; i < count; i++)
+            store.add("", base.data() + i * dim, dim, 0.0);
+
+        ImageList list(store);
+        for (uint32_t id = 0; id < count; id++)
+            list.addImage(id);
+
+        vector<FeatureVector> queries;
+        for (size_t q = 0; q < queryCount; q++)
+            queries.emplace_back(queryData.data() + q * dim, queryData.data() + (q + 1) * dim);
+
+        vector<int> exact(queryCount);
+        const double exactMs = measure([&]
+                                       {
+            for (size_t q = 0; q < queryCount; q++)
+                exact[q] = list.findNearest(queries[q], -1); }) / queryCount;
+        cout << "dim=" << setw(4) << dim << " (" << count << " vetores, " << dim * sizeof(float)
+             << " bytes por imagem):  exata " << fixed << setprecision(3) << exactMs << endl;
+
+        const pair<int, int> configs[] = {{8, 8}, {16, 8}, {16, 4}, {32, 4}};
+        for (const auto &config : configs)
+        {
+            Timer trainTimer;
+            PQ pq(store, config.first, config.second);
+            pq.train();
+            for (uint32_t id = 0; id < count; id++)
+                pq.addImage(id);
+            const double buildMs = trainTimer.elapsed_milliseconds();
+
+            vector<int> approx(queryCount);
+            const double pqMs = measure([&]
+                                        {
+                for (size_t q = 0; q < queryCount; q++)
+                    approx[q] = pq.findNearest(queries[q]); }) / queryCount;
+
+            size_t hits = 0;
+            for (size_t q = 0; q < queryCount; q++)
+                hits += approx[q] == exact[q];
+
+            cout << "  M=" << setw(2) << config.first << " " << config.second << " bits (" << setprecision(1)
+                 << static_cast<double>(pq.codeBytes()) / count << " bytes, treino " << setprecision(0) << buildMs
+                 << " ms):  " << setprecision(3) << pqMs << " (" << setprecision(1) << exactMs / pqMs
+                 << "x, recall@1 " << 100.0 * hits / queryCount << "%)" << endl;
+        }
+    }
+}
+
+struct Section
+{
+    const char *name;
+    void (*run)();
+};
+
+const Section kSections[] = {
+    {"histograma", benchHistogram},
+    {"distancia", benchDistance},
+    {"metrica", benchMetric},
+    {"abandono", benchEarlyAbandon},
+    {"bloco", benchTile},
+    {"paralela", benchParallel},
+    {"topk", benchKNearest},
+    {"ingestao", benchIngestion},
+    {"caminho", benchPathLookup},
+    {"lote", benchBatch},
+    {"quant", benchQuantized},
+    {"meia", benchHalf},
+    {"pq", benchPQ},
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    for (const Section &section : kSections)
+    {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++)
+        {
+            selected = selected || strcmp(argv[i], section.name) == 0;
+        }
+        if (selected)
+        {
+            section.run();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+// src/core/AppendArray.h
+
+#ifndef APPEND_ARRAY_H
+#define APPEND_ARRAY_H
+
+#include "Epoch.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+/**
+ * @brief Vetor só de acréscimos com um escritor e leitores sem trava.
+ *
+ * O escritor grava os elementos novos além do tamanho publicado e só então
+ * publica o tamanho (release), então um leitor que lê size() e depois data()
+ * (acquire) enxerga um prefixo completo. Os elementos publicados nunca são
+ * alterados. Ao crescer, o conteúdo é copiado para um bloco novo, que é
+ * publicado antes do tamanho; o antigo vai para defaultEpochDomain() e só é
+ * liberado quando nenhum leitor que possa tê-lo carregado estiver ativo.
+ *
+ * Os leitores devem manter um EpochGuard enquanto usam data(). Mover, copiar
+ * e destruir não são seguros com leitores ativos.
+ */
+template <typename T, size_t Alignment = alignof(T)>
+class AppendArray {
+    static_assert(std::is_trivially_copyable_v<T>, "AppendArray copia os elementos com memcpy");
+
+public:
+    AppendArray() = default;
+    ~AppendArray() { release(data_.load(std::memory_order_relaxed)); }
+
+    AppendArray(const AppendArray& other) { append(other.data(), other.size()); }
+    AppendArray& operator=(const AppendArray& other) {
+        if (this != &other) {
+            clear();
+            append(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    AppendArray(AppendArray&& other) noexcept { swap(other); }
+    AppendArray& operator=(AppendArray&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * @brief Garante espaço para `count` elementos sem novas realocações.
+     */
+    void reserve(size_t count) {
+        if (count > capacity_) grow(count);
+    }
+
+    /**
+     * @brief Espaço para `count` elementos depois do tamanho publicado (ainda
+     * invisíveis aos leitores); commit(count) os publica.
+     */
+    T* prepare(size_t count) {
+        const size_t used = size_.load(std::memory_order_relaxed);
+        if (used + count > capacity_) grow(std::max(used + count, capacity_ * 2));
+        return data_.load(std::memory_order_relaxed) + used;
+    }
+
+    void commit(size_t count) { size_.store(size_.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+
+    void append(const T* values, size_t count) {
+        if (count == 0) return;
+        std::memcpy(static_cast<void*>(prepare(count)), values, count * sizeof(T));
+        commit(count);
+    }
+
+    void push_back(const T& value) { append(&value, 1); }
+
+    /**
+     * @brief Esvazia sem liberar o bloco (só com leitores parados).
+     */
+    void clear() { size_.store(0, std::memory_order_release); }
+
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return capacity_; }
+
+    const T* data() const { return data_.load(std::memory_order_acquire); }
+    const T& operator[](size_t index) const { return data()[index]; }
+    const T& back() const { return data()[size() - 1]; }
+
+private:
+    std::atomic<T*> data_{nullptr};
+    std::atomic<size_t> size_{0};
+    size_t capacity_ = 0; // só o escritor lê
+
+    static void release(void* block) { ::operator delete(block, std::align_val_t(Alignment)); }
+
+    void grow(size_t capacity) {
+        capacity = std::max<size_t>(capacity, 16);
+        T* block = static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t(Alignment)));
+        T* old = data_.load(std::memory_order_relaxed);
+        if (old) std::memcpy(static_cast<void*>(block), old, size_.load(std::memory_order_relaxed) * sizeof(T));
+
+        data_.store(block, std::memory_order_release);
+        capacity_ = capacity;
+        if (old) defaultEpochDomain().retire(old, release);
+    }
+
+    void swap(AppendArray& other) noexcept {
+        T* data = data_.load(std::memory_order_relaxed);
+        data_.store(other.data_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.data_.store(data, std::memory_order_relaxed);
+        const size_t size = size_.load(std::memory_order_relaxed);
+        size_.store(other.size_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.size_.store(size, std::memory_order_relaxed);
+        std::swap(capacity_, other.capacity_);
+    }
+};
+
+#endif // APPEND_ARRAY_H
@@ -0,0 +1,86 @@
+// src/core/Avx512.h
+
+#ifndef AVX512_H
+#define AVX512_H
+
+#include "CpuFeatures.h"
+
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+
+/**
+ * Variantes zero-mascaradas dos intrínsecos AVX-512 usados nos kernels.
+ *
+ * No GCC 12 as formas sem máscara (e _mm512_reduce_add_ps, que é montada
+ * sobre elas) passam _mm512_undefined_*() como origem da máscara, o que gera
+ * avisos -Wmaybe-uninitialized em cada ponto inlinado. Com máscara cheia e
+ * origem zero o compilador emite a mesma instrução, sem o aviso.
+ */
+namespace avx512 {
+
+ANALISE_TARGET("avx512f")
+inline __m256 lowHalf(__m512 v) {
+    return _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, _mm512_castps_pd(v), 0));
+}
+
+ANALISE_TARGET("avx512f")
+inline __m256 highHalf(__m512 v) {
+    return _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, _mm512_castps_pd(v), 1));
+}
+
+ANALISE_TARGET("avx512f")
+inline __m256i lowHalf(__m512i v) {
+    return _mm512_maskz_extracti64x4_epi64(0xFF, v, 0);
+}
+
+ANALISE_TARGET("avx512f")
+inline __m256i highHalf(__m512i v) {
+    return _mm512_maskz_extracti64x4_epi64(0xFF, v, 1);
+}
+
+// Soma das duas metades de 256 bits
+ANALISE_TARGET("avx512f")
+inline __m256 foldHalves(__m512 v) {
+    return _mm256_add_ps(lowHalf(v), highHalf(v));
+}
+
+ANALISE_TARGET("avx512f")
+inline __m256i foldHalves(__m512i v) {
+    return _mm256_add_epi32(lowHalf(v), highHalf(v));
+}
+
+// Soma horizontal das 16 lanes, no lugar de _mm512_reduce_add_ps
+ANALISE_TARGET("avx512f")
+inline float reduceAdd(__m512 v) {
+    const __m256 h8 = foldHalves(v);
+    const __m128 h4 = _mm_add_ps(_mm256_castps256_ps128(h8), _mm256_extractf128_ps(h8, 1));
+    const __m128 h2 = _mm_add_ps(h4, _mm_movehl_ps(h4, h4));
+    return _mm_cvtss_f32(_mm_add_ss(h2, _mm_shuffle_ps(h2, h2, 1)));
+}
+
+ANALISE_TARGET("avx512f")
+inline __m512 max(__m512 a, __m512 b) { return _mm512_maskz_max_ps(0xFFFF, a, b); }
+
+ANALISE_TARGET("avx512f")
+inline __m512 min(__m512 a, __m512 b) { return _mm512_maskz_min_ps(0xFFFF, a, b); }
+
+ANALISE_TARGET("avx512f")
+inline __m512 sqrt(__m512 v) { return _mm512_maskz_sqrt_ps(0xFFFF, v); }
+
+ANALISE_TARGET("avx512f")
+inline __m512d cvtps(__m256 v) { return _mm512_maskz_cvtps_pd(0xFF, v); }
+
+ANALISE_TARGET("avx512f")
+inline __m512 cvtph(__m256i v) { return _mm512_maskz_cvtph_ps(0xFFFF, v); }
+
+ANALISE_TARGET("avx512f")
+inline __m512i cvtepu16(__m256i v) { return _mm512_maskz_cvtepu16_epi32(0xFFFF, v); }
+
+ANALISE_TARGET("avx512f")
+inline __m512i slli32(__m512i v, unsigned int count) { return _mm512_maskz_slli_epi32(0xFFFF, v, count); }
+
+} // namespace avx512
+
+#endif // ANALISE_X86_DISPATCH
+
+#endif // AVX512_H
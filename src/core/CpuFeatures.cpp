@@ -0,0 +1,67 @@
+// src/core/CpuFeatures.cpp
+
+#include "CpuFeatures.h"
+
+#if ANALISE_X86_DISPATCH
+#include <cpuid.h>
+
+namespace {
+
+unsigned long long readXcr0() {
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures f;
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return f;
+
+    f.sse2 = (edx >> 26) & 1;
+    f.ssse3 = (ecx >> 9) & 1;
+    f.sse41 = (ecx >> 19) & 1;
+    f.fma = (ecx >> 12) & 1;
+    f.f16c = (ecx >> 29) & 1;
+
+    // AVX exige que o SO salve os registradores YMM (OSXSAVE + XCR0)
+    const bool osxsave = (ecx >> 27) & 1;
+    const bool cpuAvx = (ecx >> 28) & 1;
+    const unsigned long long xcr0 = osxsave ? readXcr0() : 0;
+    const bool osYmm = (xcr0 & 0x6) == 0x6;
+    const bool osZmm = (xcr0 & 0xE6) == 0xE6;
+
+    f.avx = cpuAvx && osYmm;
+    f.fma = f.fma && f.avx;
+    f.f16c = f.f16c && f.avx;
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        f.avx2 = f.avx && ((ebx >> 5) & 1);
+        f.avx512f = osZmm && ((ebx >> 16) & 1);
+        f.avx512bw = f.avx512f && ((ebx >> 30) & 1);
+        f.avx512vnni = f.avx512f && ((ecx >> 11) & 1);
+    }
+
+    if (f.avx512f && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+        f.avx512bf16 = (eax >> 5) & 1;
+    }
+
+    return f;
+}
+
+} // namespace
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+#else
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features;
+    return features;
+}
+
+#endif
@@ -0,0 +1,38 @@
+// src/core/CpuFeatures.h
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Kernels x86 com atributo target() só são compilados com GCC/Clang (inclui MinGW)
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ANALISE_X86_DISPATCH 1
+#define ANALISE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ANALISE_X86_DISPATCH 0
+#define ANALISE_TARGET(isa)
+#endif
+
+/**
+ * @brief Extensões de instrução suportadas pela CPU (e habilitadas pelo SO).
+ * Detectadas uma única vez via CPUID/XGETBV.
+ */
+struct CpuFeatures {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vnni = false;
+    bool avx512bf16 = false;
+};
+
+/**
+ * @brief Retorna as extensões detectadas na CPU atual.
+ */
+const CpuFeatures& cpuFeatures();
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,112 @@
+// src/core/DecodeArena.cpp
+
+#include "DecodeArena.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+// Cada alocação é precedida por um cabeçalho com o seu tamanho (necessário
+// para realloc); 16 bytes mantêm o alinhamento do malloc
+const size_t kHeader = 16;
+const size_t kAlignment = 16;
+const size_t kMinBlock = 1 << 20;
+
+size_t alignUp(size_t value) {
+    return (value + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace
+
+size_t DecodeArena::allocationSize(const void* ptr) {
+    size_t size;
+    std::memcpy(&size, static_cast<const unsigned char*>(ptr) - kHeader, sizeof(size));
+    return size;
+}
+
+void* DecodeArena::allocate(size_t size) {
+    const size_t needed = kHeader + alignUp(size);
+
+    if (blocks_.empty() || blocks_.back().size - blocks_.back().used < needed) {
+        size_t blockSize = std::max(kMinBlock, needed);
+        if (!blocks_.empty()) blockSize = std::max(blockSize, blocks_.back().size * 2);
+
+        Block block;
+        block.memory.reset(new (std::nothrow) unsigned char[blockSize]);
+        if (!block.memory) return nullptr;
+        block.size = blockSize;
+        block.used = 0;
+        blocks_.push_back(std::move(block));
+    }
+
+    Block& block = blocks_.back();
+    unsigned char* base = block.memory.get() + block.used;
+    std::memcpy(base, &size, sizeof(size));
+    block.used += needed;
+
+    last_ = base + kHeader;
+    return last_;
+}
+
+void* DecodeArena::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+
+    const size_t oldSize = allocationSize(ptr);
+
+    // A última alocação cresce no lugar se ainda couber no bloco
+    if (ptr == last_) {
+        Block& block = blocks_.back();
+        const size_t oldNeeded = alignUp(oldSize);
+        const size_t newNeeded = alignUp(newSize);
+        if (newNeeded <= oldNeeded || block.size - block.used >= newNeeded - oldNeeded) {
+            block.used = block.used - oldNeeded + newNeeded;
+            std::memcpy(static_cast<unsigned char*>(ptr) - kHeader, &newSize, sizeof(newSize));
+            return ptr;
+        }
+    }
+
+    void* fresh = allocate(newSize);
+    if (fresh) std::memcpy(fresh, ptr, std::min(oldSize, newSize));
+    return fresh;
+}
+
+void DecodeArena::release(void* ptr) {
+    if (!ptr || ptr != last_) return;
+
+    Block& block = blocks_.back();
+    const size_t needed = kHeader + alignUp(allocationSize(ptr));
+    block.used -= needed;
+    last_ = nullptr;
+}
+
+void DecodeArena::reset() {
+    if (blocks_.size() > 1) {
+        // Substitui os blocos por um único com a soma das capacidades
+        size_t total = 0;
+        for (const Block& b : blocks_) total += b.size;
+        blocks_.clear();
+
+        Block block;
+        block.memory.reset(new (std::nothrow) unsigned char[total]);
+        if (block.memory) {
+            block.size = total;
+            block.used = 0;
+            blocks_.push_back(std::move(block));
+        }
+    } else if (!blocks_.empty()) {
+        blocks_.back().used = 0;
+    }
+    last_ = nullptr;
+}
+
+size_t DecodeArena::capacity() const {
+    size_t total = 0;
+    for (const Block& b : blocks_) total += b.size;
+    return total;
+}
+
+DecodeArena& DecodeArena::local() {
+    thread_local DecodeArena arena;
+    return arena;
+}
@@ -0,0 +1,57 @@
+// src/core/DecodeArena.h
+
+#ifndef DECODE_ARENA_H
+#define DECODE_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Alocador por região (bump allocator) para os buffers de decodificação.
+ *
+ * Cada thread tem a sua arena (DecodeArena::local()), que é zerada com reset()
+ * no início de cada imagem e mantém a memória entre imagens. Depois das
+ * primeiras imagens, a arena já tem o tamanho do pico de uso e a decodificação
+ * não chama mais o alocador global nem toca páginas novas.
+ *
+ * release() só devolve memória se o bloco for a última alocação; os demais
+ * blocos são recuperados no próximo reset().
+ */
+class DecodeArena {
+public:
+    DecodeArena() = default;
+    DecodeArena(const DecodeArena&) = delete;
+    DecodeArena& operator=(const DecodeArena&) = delete;
+
+    void* allocate(size_t size);
+    void* reallocate(void* ptr, size_t newSize);
+    void release(void* ptr);
+
+    /**
+     * @brief Invalida todas as alocações. Se a imagem anterior precisou de mais
+     * de um bloco, eles são unidos em um único bloco do tamanho do pico.
+     */
+    void reset();
+
+    size_t capacity() const;
+
+    /**
+     * @brief Arena da thread atual (persistente enquanto a thread existir).
+     */
+    static DecodeArena& local();
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> blocks_;
+    void* last_ = nullptr; // última alocação (pode crescer ou ser desfeita no lugar)
+
+    static size_t allocationSize(const void* ptr);
+};
+
+#endif // DECODE_ARENA_H
@@ -0,0 +1,561 @@
+// src/core/DistanceTile.cpp
+
+#include "DistanceTile.h"
+#include "Avx512.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Linhas cujo produto escalar é calculado junto (consulta lida uma vez por grupo)
+const size_t kGroupRows = 8;
+const size_t kTileBytes = 16 * 1024;
+
+using TileFn = size_t (*)(const float*, float, const DistanceTile&, size_t, double&);
+
+// Busca em lote: consultas por micro-bloco (6 x 2 vetores = 12 acumuladores) e
+// tamanho do bloco empacotado da base
+const size_t kBatchQueries = 6;
+const size_t kBatchBlockBytes = 256 * 1024;
+
+using BatchFn = void (*)(const DistanceTile&, const DistanceTile&, size_t, double*, size_t*);
+using PackBuffer = std::vector<float, AlignedAllocator<float>>;
+
+inline size_t tileIndex(const DistanceTile& tile, size_t i) {
+    return tile.ids ? tile.ids[i] : i;
+}
+
+inline const float* tileRow(const DistanceTile& tile, size_t i) {
+    return tile.base + tileIndex(tile, i) * tile.stride;
+}
+
+// Margem relativa do filtro: |(||x||² + ||q||² - 2·q·x) - squaredEuclideanDistance|
+// <= tileSlack(n) * (||x||² + ||q||²). Cobre o erro do produto escalar em float
+// (n·u), das normas guardadas em float, da montagem da expansão e o do próprio
+// kernel par a par (u = 2^-24), com folga.
+inline double tileSlack(size_t n) {
+    return static_cast<double>(4 * n + 32) * std::ldexp(1.0, -24);
+}
+
+// Linha que passou no filtro: a distância é recalculada pelo mesmo kernel da
+// varredura par a par (com abandono em bestSquared), então o vencedor, o seu
+// bestSquared e os empates são exatamente os de squaredEuclideanDistance
+template <size_t Dim>
+inline void confirmRow(const float* query, const DistanceTile& tile, size_t i, size_t n, double& bestSquared,
+                       size_t& best) {
+    const double squared = squaredEuclideanDistance<Dim>(query, tileRow(tile, i), n, bestSquared);
+    if (squared < bestSquared) {
+        bestSquared = squared;
+        best = i;
+    }
+}
+
+// Filtro pela expansão ||x||² + ||q||² - 2·q·x menos a margem de erro: nenhuma
+// linha mais próxima que bestSquared é descartada; as que passam são confirmadas
+template <size_t Dim>
+inline void considerRow(const float* query, const DistanceTile& tile, size_t i, size_t n, double dot,
+                        float queryNorm, double keep, double& bestSquared, size_t& best) {
+    const double lower = (static_cast<double>(tile.norms[tileIndex(tile, i)]) + queryNorm) * keep - 2.0 * dot;
+    if (lower < bestSquared) confirmRow<Dim>(query, tile, i, n, bestSquared, best);
+}
+
+template <size_t Dim>
+size_t tileReference(const float* query, float queryNorm, const DistanceTile& tile, size_t n,
+                     double& bestSquared) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    const double keep = 1.0 - tileSlack(n);
+    size_t best = TILE_NO_CANDIDATE;
+    for (size_t i = 0; i < tile.count; ++i) {
+        const float* row = tileRow(tile, i);
+        double dot = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            dot += static_cast<double>(query[j]) * row[j];
+        }
+        considerRow<Dim>(query, tile, i, n, dot, queryNorm, keep, bestSquared, best);
+    }
+    return best;
+}
+
+// Busca em lote sem micro-kernel próprio: um bloco por consulta
+template <TileFn Tile>
+void batchByQuery(const DistanceTile& queries, const DistanceTile& block, size_t n, double* bestSquared,
+                  size_t* best) {
+    for (size_t q = 0; q < queries.count; ++q) {
+        const size_t pos = Tile(tileRow(queries, q), queries.norms[tileIndex(queries, q)], block, n, bestSquared[q]);
+        if (pos != TILE_NO_CANDIDATE) best[q] = pos;
+    }
+}
+
+// Painéis de `width` linhas, transpostos: packed[(p * n + k) * width + w] é o
+// elemento k da linha p * width + w. Linhas além do bloco ficam com zeros e
+// norma infinita, então nunca são escolhidas.
+void packPanels(const DistanceTile& block, size_t n, size_t width, PackBuffer& packed, PackBuffer& norms) {
+    const size_t panels = (block.count + width - 1) / width;
+    packed.resize(panels * n * width);
+    norms.resize(panels * width);
+    for (size_t p = 0; p < panels; ++p) {
+        float* panel = packed.data() + p * n * width;
+        for (size_t w = 0; w < width; ++w) {
+            const size_t r = p * width + w;
+            if (r < block.count) {
+                const float* row = tileRow(block, r);
+                for (size_t k = 0; k < n; ++k) panel[k * width + w] = row[k];
+                norms[r] = block.norms[tileIndex(block, r)];
+            } else {
+                for (size_t k = 0; k < n; ++k) panel[k * width + w] = 0.0f;
+                norms[r] = std::numeric_limits<float>::infinity();
+            }
+        }
+    }
+}
+
+// Ponteiros e normas do micro-bloco de consultas que começa em q0; as posições
+// além do lote repetem a primeira consulta (calculadas, mas descartadas)
+inline size_t batchQueries(const DistanceTile& queries, size_t q0, const float* rows[kBatchQueries],
+                           float norms[kBatchQueries]) {
+    const size_t count = std::min(kBatchQueries, queries.count - q0);
+    for (size_t i = 0; i < kBatchQueries; ++i) {
+        const size_t q = q0 + (i < count ? i : 0);
+        rows[i] = tileRow(queries, q);
+        norms[i] = queries.norms[tileIndex(queries, q)];
+    }
+    return count;
+}
+
+// Lanes que passaram no filtro vetorial (bit l de `mask`) são confirmadas em
+// ordem; as de preenchimento do último painel não existem no bloco
+inline void considerLanes(unsigned mask, size_t lanes, const float* query, const DistanceTile& block, size_t n,
+                          size_t firstRow, double& bestSquared, size_t& best) {
+    for (size_t l = 0; l < lanes && firstRow + l < block.count; ++l) {
+        if (mask & (1u << l)) confirmRow<DYNAMIC_DIMENSION>(query, block, firstRow + l, n, bestSquared, best);
+    }
+}
+
+#if ANALISE_X86_DISPATCH
+
+// SSE2 (sem hadd): transpõe 4 acumuladores e soma as colunas, lane k = soma de v[k]
+ANALISE_TARGET("sse2")
+inline __m128 reduceFour(__m128 v0, __m128 v1, __m128 v2, __m128 v3) {
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    return _mm_add_ps(_mm_add_ps(v0, v1), _mm_add_ps(v2, v3));
+}
+
+template <size_t Dim>
+ANALISE_TARGET("sse2")
+size_t tileSse2(const float* query, float queryNorm, const DistanceTile& tile, size_t n, double& bestSquared) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    const double keep = 1.0 - tileSlack(n);
+    const size_t full = n / 4 * 4;
+    size_t best = TILE_NO_CANDIDATE;
+    size_t i = 0;
+
+    for (; i + kGroupRows <= tile.count; i += kGroupRows) {
+        const float* rows[kGroupRows];
+        __m128 acc[kGroupRows];
+        for (size_t k = 0; k < kGroupRows; ++k) {
+            rows[k] = tileRow(tile, i + k);
+            acc[k] = _mm_setzero_ps();
+        }
+        for (size_t j = 0; j < full; j += 4) {
+            const __m128 q = _mm_loadu_ps(query + j);
+            for (size_t k = 0; k < kGroupRows; ++k) {
+                acc[k] = _mm_add_ps(acc[k], _mm_mul_ps(q, _mm_loadu_ps(rows[k] + j)));
+            }
+        }
+
+        alignas(16) float dots[kGroupRows];
+        _mm_store_ps(dots, reduceFour(acc[0], acc[1], acc[2], acc[3]));
+        _mm_store_ps(dots + 4, reduceFour(acc[4], acc[5], acc[6], acc[7]));
+        for (size_t k = 0; k < kGroupRows; ++k) {
+            for (size_t j = full; j < n; ++j) dots[k] += query[j] * rows[k][j];
+            considerRow<Dim>(query, tile, i + k, n, dots[k], queryNorm, keep, bestSquared, best);
+        }
+    }
+
+    for (; i < tile.count; ++i) {
+        const float* row = tileRow(tile, i);
+        __m128 acc = _mm_setzero_ps();
+        for (size_t j = 0; j < full; j += 4) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(query + j), _mm_loadu_ps(row + j)));
+        }
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        float dot = _mm_cvtss_f32(_mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1)));
+        for (size_t j = full; j < n; ++j) dot += query[j] * row[j];
+        considerRow<Dim>(query, tile, i, n, dot, queryNorm, keep, bestSquared, best);
+    }
+    return best;
+}
+
+// Soma horizontal de 8 acumuladores de uma vez: lane k do resultado = soma de v[k]
+ANALISE_TARGET("avx")
+inline __m256 reduceEight(const __m256 v[8]) {
+    __m256 s01 = _mm256_hadd_ps(v[0], v[1]);
+    __m256 s23 = _mm256_hadd_ps(v[2], v[3]);
+    __m256 s45 = _mm256_hadd_ps(v[4], v[5]);
+    __m256 s67 = _mm256_hadd_ps(v[6], v[7]);
+    __m256 s0123 = _mm256_hadd_ps(s01, s23);
+    __m256 s4567 = _mm256_hadd_ps(s45, s67);
+    return _mm256_add_ps(_mm256_permute2f128_ps(s0123, s4567, 0x20),
+                         _mm256_permute2f128_ps(s0123, s4567, 0x31));
+}
+
+ANALISE_TARGET("avx")
+inline float reduceOne(__m256 v) {
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+
+// Normas das 8 linhas do grupo que começa em i
+inline void groupNorms(const DistanceTile& tile, size_t i, float* norms) {
+    for (size_t k = 0; k < kGroupRows; ++k) norms[k] = tile.norms[tileIndex(tile, i + k)];
+}
+
+// Versão vetorial de considerRow para as 8 linhas do grupo: o filtro é aplicado
+// às 8 de uma vez e só as que passam são confirmadas, em ordem
+template <size_t Dim>
+ANALISE_TARGET("avx2,fma")
+inline void considerGroupAvx2(const float* query, const DistanceTile& tile, size_t i, size_t dimension,
+                              __m256 dots, float queryNorm, double keep, double& bestSquared, size_t& best) {
+    alignas(32) float norms[kGroupRows];
+    groupNorms(tile, i, norms);
+    const __m256 n = _mm256_load_ps(norms);
+    const __m256d q = _mm256_set1_pd(queryNorm);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d scale = _mm256_set1_pd(keep);
+    const __m256d lo = _mm256_sub_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(n)), q), scale),
+                                     _mm256_mul_pd(two, _mm256_cvtps_pd(_mm256_castps256_ps128(dots))));
+    const __m256d hi = _mm256_sub_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(n, 1)), q), scale),
+                                     _mm256_mul_pd(two, _mm256_cvtps_pd(_mm256_extractf128_ps(dots, 1))));
+
+    const __m256d bound = _mm256_set1_pd(bestSquared);
+    const int mask = _mm256_movemask_pd(_mm256_cmp_pd(lo, bound, _CMP_LT_OQ)) |
+                     (_mm256_movemask_pd(_mm256_cmp_pd(hi, bound, _CMP_LT_OQ)) << 4);
+    for (size_t k = 0; k < kGroupRows; ++k) {
+        if (mask & (1 << k)) confirmRow<Dim>(query, tile, i + k, dimension, bestSquared, best);
+    }
+}
+
+template <size_t Dim>
+ANALISE_TARGET("avx2,fma")
+size_t tileAvx2(const float* query, float queryNorm, const DistanceTile& tile, size_t n, double& bestSquared) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    const double keep = 1.0 - tileSlack(n);
+    const size_t full = n / 8 * 8;
+    size_t best = TILE_NO_CANDIDATE;
+    size_t i = 0;
+
+    for (; i + kGroupRows <= tile.count; i += kGroupRows) {
+        const float* rows[kGroupRows];
+        __m256 acc[kGroupRows];
+        for (size_t k = 0; k < kGroupRows; ++k) {
+            rows[k] = tileRow(tile, i + k);
+            acc[k] = _mm256_setzero_ps();
+        }
+        for (size_t j = 0; j < full; j += 8) {
+            const __m256 q = _mm256_loadu_ps(query + j);
+            for (size_t k = 0; k < kGroupRows; ++k) {
+                acc[k] = _mm256_fmadd_ps(q, _mm256_loadu_ps(rows[k] + j), acc[k]);
+            }
+        }
+
+        __m256 dots = reduceEight(acc);
+        if (full < n) {
+            alignas(32) float tail[kGroupRows];
+            _mm256_store_ps(tail, dots);
+            for (size_t k = 0; k < kGroupRows; ++k) {
+                for (size_t j = full; j < n; ++j) tail[k] += query[j] * rows[k][j];
+            }
+            dots = _mm256_load_ps(tail);
+        }
+        considerGroupAvx2<Dim>(query, tile, i, n, dots, queryNorm, keep, bestSquared, best);
+    }
+
+    for (; i < tile.count; ++i) {
+        const float* row = tileRow(tile, i);
+        __m256 acc = _mm256_setzero_ps();
+        for (size_t j = 0; j < full; j += 8) {
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(query + j), _mm256_loadu_ps(row + j), acc);
+        }
+        float dot = reduceOne(acc);
+        for (size_t j = full; j < n; ++j) dot += query[j] * row[j];
+        considerRow<Dim>(query, tile, i, n, dot, queryNorm, keep, bestSquared, best);
+    }
+    return best;
+}
+
+template <size_t Dim>
+ANALISE_TARGET("avx512f")
+inline void considerGroupAvx512(const float* query, const DistanceTile& tile, size_t i, size_t dimension,
+                                __m256 dots, float queryNorm, double keep, double& bestSquared, size_t& best) {
+    alignas(32) float norms[kGroupRows];
+    groupNorms(tile, i, norms);
+    const __m512d lower = _mm512_sub_pd(
+        _mm512_mul_pd(_mm512_add_pd(avx512::cvtps(_mm256_load_ps(norms)), _mm512_set1_pd(queryNorm)),
+                      _mm512_set1_pd(keep)),
+        _mm512_mul_pd(_mm512_set1_pd(2.0), avx512::cvtps(dots)));
+
+    const __mmask8 mask = _mm512_cmp_pd_mask(lower, _mm512_set1_pd(bestSquared), _CMP_LT_OQ);
+    for (size_t k = 0; k < kGroupRows; ++k) {
+        if (mask & (1u << k)) confirmRow<Dim>(query, tile, i + k, dimension, bestSquared, best);
+    }
+}
+
+template <size_t Dim>
+ANALISE_TARGET("avx512f")
+size_t tileAvx512(const float* query, float queryNorm, const DistanceTile& tile, size_t n, double& bestSquared) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    const size_t full = n / 16 * 16;
+    // Final com máscara: lanes fora do vetor são carregadas como zero
+    const __mmask16 tail = static_cast<__mmask16>((1u << (n - full)) - 1);
+    const double keep = 1.0 - tileSlack(n);
+    size_t best = TILE_NO_CANDIDATE;
+    size_t i = 0;
+
+    for (; i + kGroupRows <= tile.count; i += kGroupRows) {
+        const float* rows[kGroupRows];
+        __m512 acc[kGroupRows];
+        for (size_t k = 0; k < kGroupRows; ++k) {
+            rows[k] = tileRow(tile, i + k);
+            acc[k] = _mm512_setzero_ps();
+        }
+        for (size_t j = 0; j < full; j += 16) {
+            const __m512 q = _mm512_loadu_ps(query + j);
+            for (size_t k = 0; k < kGroupRows; ++k) {
+                acc[k] = _mm512_fmadd_ps(q, _mm512_loadu_ps(rows[k] + j), acc[k]);
+            }
+        }
+        if (tail) {
+            const __m512 q = _mm512_maskz_loadu_ps(tail, query + full);
+            for (size_t k = 0; k < kGroupRows; ++k) {
+                acc[k] = _mm512_fmadd_ps(q, _mm512_maskz_loadu_ps(tail, rows[k] + full), acc[k]);
+            }
+        }
+
+        __m256 folded[kGroupRows];
+        for (size_t k = 0; k < kGroupRows; ++k) folded[k] = avx512::foldHalves(acc[k]);
+        considerGroupAvx512<Dim>(query, tile, i, n, reduceEight(folded), queryNorm, keep, bestSquared, best);
+    }
+
+    for (; i < tile.count; ++i) {
+        const float* row = tileRow(tile, i);
+        __m512 acc = _mm512_setzero_ps();
+        for (size_t j = 0; j < full; j += 16) {
+            acc = _mm512_fmadd_ps(_mm512_loadu_ps(query + j), _mm512_loadu_ps(row + j), acc);
+        }
+        if (tail) {
+            acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, query + full),
+                                  _mm512_maskz_loadu_ps(tail, row + full), acc);
+        }
+        considerRow<Dim>(query, tile, i, n, avx512::reduceAdd(acc), queryNorm, keep, bestSquared, best);
+    }
+    return best;
+}
+
+// Filtro de considerRow em float (||x||² + ||q||²)·keep - 2·q·x; usa <= para não
+// perder candidatos por causa do arredondamento de bestSquared para float
+ANALISE_TARGET("avx2,fma")
+inline void considerBatchAvx2(const float* query, const DistanceTile& block, size_t n, __m256 dots, __m256 norms,
+                              float queryNorm, float keep, size_t firstRow, double& bestSquared, size_t& best) {
+    const __m256 lower = _mm256_fnmadd_ps(
+        _mm256_set1_ps(2.0f), dots, _mm256_mul_ps(_mm256_add_ps(norms, _mm256_set1_ps(queryNorm)), _mm256_set1_ps(keep)));
+    const __m256 bound = _mm256_set1_ps(static_cast<float>(bestSquared));
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(lower, bound, _CMP_LE_OQ)));
+    if (mask) considerLanes(mask, 8, query, block, n, firstRow, bestSquared, best);
+}
+
+ANALISE_TARGET("avx2,fma")
+void batchAvx2(const DistanceTile& queries, const DistanceTile& block, size_t n, double* bestSquared, size_t* best) {
+    const float keep = static_cast<float>(1.0 - tileSlack(n));
+    const size_t width = 16; // 2 vetores de 8 linhas por painel
+    thread_local PackBuffer packed, norms;
+    packPanels(block, n, width, packed, norms);
+    const size_t panels = (block.count + width - 1) / width;
+
+    for (size_t q0 = 0; q0 < queries.count; q0 += kBatchQueries) {
+        const float* q[kBatchQueries];
+        float qn[kBatchQueries];
+        const size_t count = batchQueries(queries, q0, q, qn);
+
+        for (size_t p = 0; p < panels; ++p) {
+            const float* panel = packed.data() + p * n * width;
+            __m256 acc0[kBatchQueries], acc1[kBatchQueries];
+            for (size_t i = 0; i < kBatchQueries; ++i) {
+                acc0[i] = _mm256_setzero_ps();
+                acc1[i] = _mm256_setzero_ps();
+            }
+            for (size_t k = 0; k < n; ++k) {
+                const __m256 x0 = _mm256_load_ps(panel + k * width);
+                const __m256 x1 = _mm256_load_ps(panel + k * width + 8);
+                for (size_t i = 0; i < kBatchQueries; ++i) {
+                    const __m256 b = _mm256_broadcast_ss(q[i] + k);
+                    acc0[i] = _mm256_fmadd_ps(b, x0, acc0[i]);
+                    acc1[i] = _mm256_fmadd_ps(b, x1, acc1[i]);
+                }
+            }
+
+            const __m256 n0 = _mm256_load_ps(norms.data() + p * width);
+            const __m256 n1 = _mm256_load_ps(norms.data() + p * width + 8);
+            // Cópia com índices constantes: os acumuladores ficam em registradores
+            // no laço acima em vez de irem para a pilha a cada iteração
+            __m256 dots[2 * kBatchQueries];
+            for (size_t i = 0; i < kBatchQueries; ++i) {
+                dots[2 * i] = acc0[i];
+                dots[2 * i + 1] = acc1[i];
+            }
+            for (size_t i = 0; i < count; ++i) {
+                considerBatchAvx2(q[i], block, n, dots[2 * i], n0, qn[i], keep, p * width, bestSquared[q0 + i],
+                                  best[q0 + i]);
+                considerBatchAvx2(q[i], block, n, dots[2 * i + 1], n1, qn[i], keep, p * width + 8,
+                                  bestSquared[q0 + i], best[q0 + i]);
+            }
+        }
+    }
+}
+
+ANALISE_TARGET("avx512f")
+inline void considerBatchAvx512(const float* query, const DistanceTile& block, size_t n, __m512 dots, __m512 norms,
+                                float queryNorm, float keep, size_t firstRow, double& bestSquared, size_t& best) {
+    const __m512 lower = _mm512_fnmadd_ps(
+        _mm512_set1_ps(2.0f), dots, _mm512_mul_ps(_mm512_add_ps(norms, _mm512_set1_ps(queryNorm)), _mm512_set1_ps(keep)));
+    const __m512 bound = _mm512_set1_ps(static_cast<float>(bestSquared));
+    const unsigned mask = _mm512_cmp_ps_mask(lower, bound, _CMP_LE_OQ);
+    if (mask) considerLanes(mask, 16, query, block, n, firstRow, bestSquared, best);
+}
+
+ANALISE_TARGET("avx512f")
+void batchAvx512(const DistanceTile& queries, const DistanceTile& block, size_t n, double* bestSquared,
+                 size_t* best) {
+    const float keep = static_cast<float>(1.0 - tileSlack(n));
+    const size_t width = 32; // 2 vetores de 16 linhas por painel
+    thread_local PackBuffer packed, norms;
+    packPanels(block, n, width, packed, norms);
+    const size_t panels = (block.count + width - 1) / width;
+
+    for (size_t q0 = 0; q0 < queries.count; q0 += kBatchQueries) {
+        const float* q[kBatchQueries];
+        float qn[kBatchQueries];
+        const size_t count = batchQueries(queries, q0, q, qn);
+
+        for (size_t p = 0; p < panels; ++p) {
+            const float* panel = packed.data() + p * n * width;
+            __m512 acc0[kBatchQueries], acc1[kBatchQueries];
+            for (size_t i = 0; i < kBatchQueries; ++i) {
+                acc0[i] = _mm512_setzero_ps();
+                acc1[i] = _mm512_setzero_ps();
+            }
+            for (size_t k = 0; k < n; ++k) {
+                const __m512 x0 = _mm512_load_ps(panel + k * width);
+                const __m512 x1 = _mm512_load_ps(panel + k * width + 16);
+                for (size_t i = 0; i < kBatchQueries; ++i) {
+                    const __m512 b = _mm512_set1_ps(q[i][k]);
+                    acc0[i] = _mm512_fmadd_ps(b, x0, acc0[i]);
+                    acc1[i] = _mm512_fmadd_ps(b, x1, acc1[i]);
+                }
+            }
+
+            const __m512 n0 = _mm512_load_ps(norms.data() + p * width);
+            const __m512 n1 = _mm512_load_ps(norms.data() + p * width + 16);
+            // Cópia com índices constantes: os acumuladores ficam em registradores
+            // no laço acima em vez de irem para a pilha a cada iteração
+            __m512 dots[2 * kBatchQueries];
+            for (size_t i = 0; i < kBatchQueries; ++i) {
+                dots[2 * i] = acc0[i];
+                dots[2 * i + 1] = acc1[i];
+            }
+            for (size_t i = 0; i < count; ++i) {
+                considerBatchAvx512(q[i], block, n, dots[2 * i], n0, qn[i], keep, p * width, bestSquared[q0 + i],
+                                    best[q0 + i]);
+                considerBatchAvx512(q[i], block, n, dots[2 * i + 1], n1, qn[i], keep, p * width + 16,
+                                    bestSquared[q0 + i], best[q0 + i]);
+            }
+        }
+    }
+}
+
+#endif // ANALISE_X86_DISPATCH
+
+BatchFn batchFn(DistanceKernel kernel) {
+    switch (kernel) {
+#if ANALISE_X86_DISPATCH
+        case DistanceKernel::SSE2: return batchByQuery<tileSse2<DYNAMIC_DIMENSION>>;
+        case DistanceKernel::AVX2: return batchAvx2;
+        case DistanceKernel::AVX512: return batchAvx512;
+#endif
+        default: return batchByQuery<tileReference<DYNAMIC_DIMENSION>>;
+    }
+}
+
+template <size_t Dim>
+TileFn tileFn(DistanceKernel kernel) {
+    switch (kernel) {
+#if ANALISE_X86_DISPATCH
+        case DistanceKernel::SSE2: return tileSse2<Dim>;
+        case DistanceKernel::AVX2: return tileAvx2<Dim>;
+        case DistanceKernel::AVX512: return tileAvx512<Dim>;
+#endif
+        default: return tileReference<Dim>;
+    }
+}
+
+template <size_t Dim>
+TileFn bestTileFn() {
+    static const TileFn fn = tileFn<Dim>(bestDistanceKernel());
+    return fn;
+}
+
+} // namespace
+
+size_t distanceTileRows(size_t stride) {
+    const size_t rows = kTileBytes / (std::max<size_t>(stride, 1) * sizeof(float));
+    return std::max(kGroupRows, rows / kGroupRows * kGroupRows);
+}
+
+float squaredNorm(const float* v, size_t dimension) {
+    double sum = 0.0;
+    for (size_t i = 0; i < dimension; ++i) {
+        sum += static_cast<double>(v[i]) * v[i];
+    }
+    return static_cast<float>(sum);
+}
+
+template <size_t Dim>
+size_t nearestInTile(const float* query, float queryNorm, const DistanceTile& tile, size_t dimension,
+                     double& bestSquared) {
+    return bestTileFn<Dim>()(query, queryNorm, tile, dimension, bestSquared);
+}
+
+template size_t nearestInTile<DYNAMIC_DIMENSION>(const float*, float, const DistanceTile&, size_t, double&);
+template size_t nearestInTile<8>(const float*, float, const DistanceTile&, size_t, double&);
+template size_t nearestInTile<64>(const float*, float, const DistanceTile&, size_t, double&);
+template size_t nearestInTile<512>(const float*, float, const DistanceTile&, size_t, double&);
+
+size_t nearestInTile(const float* query, float queryNorm, const DistanceTile& tile, size_t dimension,
+                     double& bestSquared, DistanceKernel kernel) {
+    if (kernel == DistanceKernel::Auto || !isDistanceKernelSupported(kernel)) {
+        return bestTileFn<DYNAMIC_DIMENSION>()(query, queryNorm, tile, dimension, bestSquared);
+    }
+    return tileFn<DYNAMIC_DIMENSION>(kernel)(query, queryNorm, tile, dimension, bestSquared);
+}
+
+size_t distanceBatchBlockRows(size_t stride) {
+    const size_t width = 32; // maior painel (AVX-512)
+    const size_t rows = kBatchBlockBytes / (std::max<size_t>(stride, 1) * sizeof(float));
+    return std::max(width, rows / width * width);
+}
+
+void nearestInTileBatch(const DistanceTile& queries, const DistanceTile& block, size_t dimension,
+                        double* bestSquared, size_t* best, DistanceKernel kernel) {
+    static const BatchFn bestFn = batchFn(bestDistanceKernel());
+    const BatchFn fn = (kernel == DistanceKernel::Auto || !isDistanceKernelSupported(kernel)) ? bestFn
+                                                                                            : batchFn(kernel);
+    fn(queries, block, dimension, bestSquared, best);
+}
@@ -0,0 +1,105 @@
+// src/core/DistanceTile.h
+
+#ifndef DISTANCE_TILE_H
+#define DISTANCE_TILE_H
+
+#include "Vector.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Bloco de vetores armazenados comparado de uma vez com uma consulta.
+ *
+ * Com `ids == nullptr` são `count` linhas consecutivas a partir de `base`;
+ * caso contrário, a linha i é base + ids[i] * stride (ids de um FeatureStore).
+ * `norms` traz ||x||² de cada linha, indexado da mesma forma que as linhas.
+ */
+struct DistanceTile {
+    const float* base;
+    size_t stride;
+    const float* norms;
+    const uint32_t* ids;
+    size_t count;
+};
+
+/**
+ * @brief Retorno de nearestInTile quando nenhuma linha melhora o limite.
+ */
+const size_t TILE_NO_CANDIDATE = static_cast<size_t>(-1);
+
+/**
+ * @brief Indica se a varredura em blocos compensa para esta dimensão.
+ *
+ * Até DISTANCE_BLOCK floats o abandono antecipado de squaredEuclideanDistance
+ * nunca interrompe uma distância, então todos os vetores são lidos por inteiro
+ * e os blocos ganham (menos latência por vetor). Acima disso o abandono lê só
+ * o começo da maioria dos candidatos e a varredura par a par lê menos memória.
+ */
+inline bool preferTileScan(size_t dimension) {
+    return dimension <= DISTANCE_BLOCK;
+}
+
+/**
+ * @brief Linhas por bloco para que o bloco caiba em metade do L1 (16 KiB);
+ * múltiplo de 8 e no mínimo 8 (vetores muito longos ficam no L2).
+ */
+size_t distanceTileRows(size_t stride);
+
+/**
+ * @brief ||v||², acumulado em double (norma guardada no store e da consulta).
+ */
+float squaredNorm(const float* v, size_t dimension);
+
+/**
+ * @brief Vizinho mais próximo de `query` dentro do bloco.
+ *
+ * Usa ||x||² + ||q||² - 2·q·x com as normas pré-calculadas: só o produto
+ * escalar percorre os vetores, 8 linhas por vez com a consulta carregada uma
+ * única vez, então a varredura fica limitada pela banda de memória e não pela
+ * latência de cada distância. Retorna a posição no bloco (0..count-1) da
+ * melhor linha com distância ao quadrado < bestSquared, atualizando
+ * bestSquared, ou TILE_NO_CANDIDATE. Empates ficam com a primeira linha.
+ *
+ * A expansão sofre cancelamento em float, então ela só filtra: uma linha é
+ * descartada quando nem descontando o erro máximo da expansão ela bate
+ * bestSquared, e as que sobram têm a distância recalculada com
+ * squaredEuclideanDistance<Dim>. O vencedor e bestSquared são os mesmos da
+ * varredura par a par, inclusive em quase empates.
+ */
+template <size_t Dim>
+size_t nearestInTile(const float* query, float queryNorm, const DistanceTile& tile, size_t dimension,
+                     double& bestSquared);
+
+/**
+ * @brief Versão com kernel explícito (benchmarks).
+ */
+size_t nearestInTile(const float* query, float queryNorm, const DistanceTile& tile, size_t dimension,
+                     double& bestSquared, DistanceKernel kernel);
+
+/**
+ * @brief Linhas da base por bloco na busca em lote: o bloco empacotado ocupa
+ * ~256 KiB (fica no L2 enquanto todas as consultas passam por ele).
+ */
+size_t distanceBatchBlockRows(size_t stride);
+
+/**
+ * @brief Vizinho mais próximo de cada consulta de `queries` dentro de `block`,
+ * organizado como um produto de matrizes em blocos (GEMM).
+ *
+ * O bloco da base é empacotado em painéis transpostos (dimensão por dimensão,
+ * várias linhas lado a lado) e cada passo do micro-kernel multiplica um
+ * elemento de várias consultas por dois vetores de linhas: cada carga da base
+ * serve a várias consultas, então a base é lida uma vez por bloco e não uma
+ * vez por consulta. `queries.norms` e `block.norms` trazem ||·||².
+ *
+ * Para cada consulta q, se alguma linha tiver distância ao quadrado <
+ * bestSquared[q], atualiza bestSquared[q] e grava em best[q] a posição da
+ * linha no bloco (best[q] não é tocado caso contrário). Empates ficam com a
+ * primeira linha. As distâncias montadas em float só filtram, como em
+ * nearestInTile: as linhas que passam são confirmadas com
+ * squaredEuclideanDistance, então o resultado é o da varredura par a par.
+ */
+void nearestInTileBatch(const DistanceTile& queries, const DistanceTile& block, size_t dimension,
+                        double* bestSquared, size_t* best, DistanceKernel kernel = DistanceKernel::Auto);
+
+#endif // DISTANCE_TILE_H
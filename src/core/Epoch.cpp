@@ -0,0 +1,83 @@
+// src/core/Epoch.cpp
+
+#include "Epoch.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+
+EpochDomain::~EpochDomain() {
+    for (const Retired& item : retired_) {
+        item.deleter(item.pointer);
+    }
+}
+
+size_t EpochDomain::pin() {
+    // Começa em um slot que depende da thread para espalhar os CAS
+    const size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % SLOTS;
+    for (;;) {
+        const uint64_t epoch = epoch_.load();
+        for (size_t i = 0; i < SLOTS; ++i) {
+            const size_t slot = (start + i) % SLOTS;
+            uint64_t expected = 0;
+            if (slots_[slot].epoch.compare_exchange_strong(expected, epoch)) {
+                // Par da barreira de reclaim(): ou o escritor vê este slot, ou
+                // as leituras a seguir já veem o ponteiro novo
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                return slot;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void EpochDomain::unpin(size_t slot) {
+    slots_[slot].epoch.store(0, std::memory_order_release);
+}
+
+void EpochDomain::retire(void* pointer, void (*deleter)(void*)) {
+    // A versão nova já foi publicada: leitores que entrarem depois de R não a veem mais
+    const uint64_t epoch = epoch_.fetch_add(1);
+
+    std::lock_guard<std::mutex> lock(retiredMutex_);
+    retired_.push_back({pointer, deleter, epoch});
+    if (retired_.size() >= reclaimAt_) {
+        reclaimLocked();
+        reclaimAt_ = std::max(RECLAIM_THRESHOLD, 2 * retired_.size());
+    }
+}
+
+size_t EpochDomain::reclaim() {
+    std::lock_guard<std::mutex> lock(retiredMutex_);
+    return reclaimLocked();
+}
+
+size_t EpochDomain::reclaimLocked() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const Slot& slot : slots_) {
+        const uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+        if (epoch != 0) oldest = std::min(oldest, epoch);
+    }
+
+    // Um leitor na época E pode ter o ponteiro de tudo que foi aposentado em E ou depois
+    auto reclaimable = std::stable_partition(retired_.begin(), retired_.end(),
+                                             [oldest](const Retired& item) { return item.epoch >= oldest; });
+    const size_t freed = static_cast<size_t>(retired_.end() - reclaimable);
+    for (auto it = reclaimable; it != retired_.end(); ++it) {
+        it->deleter(it->pointer);
+    }
+    retired_.erase(reclaimable, retired_.end());
+    return freed;
+}
+
+size_t EpochDomain::pending() const {
+    std::lock_guard<std::mutex> lock(retiredMutex_);
+    return retired_.size();
+}
+
+EpochDomain& defaultEpochDomain() {
+    static EpochDomain domain;
+    return domain;
+}
@@ -0,0 +1,123 @@
+// src/core/Epoch.h
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Recuperação de memória por épocas para leitores sem trava.
+ *
+ * As estruturas que aceitam inserções durante as consultas (FeatureStore,
+ * ImageList, LSH, MTree) nunca alteram memória que um leitor possa estar
+ * vendo: publicam uma versão nova (um bloco maior, uma raiz nova) e entregam
+ * a antiga a retire(). Um leitor anuncia a época global ao entrar (pin) e
+ * sai ao terminar; um bloco aposentado na época R só é liberado quando todos
+ * os leitores ativos entraram depois de R, ou seja, quando nenhum deles pode
+ * ter carregado o ponteiro antigo.
+ *
+ * Leitores só fazem um CAS em um slot livre e uma barreira, sem trava e sem
+ * esperar os escritores. retire() e reclaim() usam uma trava interna (vários
+ * escritores podem compartilhar o domínio), mas nunca esperam os leitores:
+ * o que ainda está em uso fica na fila para a próxima tentativa.
+ */
+class EpochDomain {
+public:
+    /**
+     * @brief Leitores simultâneos (guardas ativas) suportados; além disso
+     * pin() espera um slot ser liberado.
+     */
+    static constexpr size_t SLOTS = 128;
+
+    /**
+     * @brief Itens na fila que disparam uma tentativa de reclaim() em retire();
+     * se sobrar muita coisa (leitores longos), a próxima tentativa espera a
+     * fila dobrar, então o custo por retire() continua constante.
+     */
+    static constexpr size_t RECLAIM_THRESHOLD = 64;
+
+    EpochDomain() = default;
+    ~EpochDomain(); // libera tudo que ainda estiver na fila
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    /**
+     * @brief Entra como leitor; devolve o slot a passar para unpin().
+     */
+    size_t pin();
+    void unpin(size_t slot);
+
+    /**
+     * @brief Agenda deleter(pointer) para quando nenhum leitor ativo puder
+     * mais enxergar `pointer`. Deve ser chamado depois de publicar a versão
+     * que o substitui.
+     */
+    void retire(void* pointer, void (*deleter)(void*));
+
+    template <typename T>
+    void retireObject(T* object) {
+        retire(object, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    /**
+     * @brief Libera os itens que nenhum leitor ativo pode estar usando e
+     * devolve quantos foram liberados.
+     */
+    size_t reclaim();
+
+    /**
+     * @brief Itens aposentados ainda não liberados.
+     */
+    size_t pending() const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0}; // 0 = livre
+    };
+
+    struct Retired {
+        void* pointer;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    Slot slots_[SLOTS];
+    alignas(64) std::atomic<uint64_t> epoch_{1};
+
+    mutable std::mutex retiredMutex_;
+    std::vector<Retired> retired_;
+    size_t reclaimAt_ = RECLAIM_THRESHOLD;
+
+    size_t reclaimLocked();
+};
+
+/**
+ * @brief Domínio usado pelas estruturas do projeto.
+ */
+EpochDomain& defaultEpochDomain();
+
+/**
+ * @brief Guarda RAII de leitura: enquanto existir, nenhum bloco visível no
+ * momento da construção é liberado. Cada consulta das estruturas abre a sua;
+ * quem guarda ponteiros além da chamada (ImageRef, features()) durante
+ * inserções concorrentes deve manter uma aberta enquanto os usa.
+ */
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochDomain& domain = defaultEpochDomain()) : domain_(domain), slot_(domain.pin()) {}
+    ~EpochGuard() { domain_.unpin(slot_); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+private:
+    EpochDomain& domain_;
+    size_t slot_;
+};
+
+#endif // EPOCH_H
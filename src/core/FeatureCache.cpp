@@ -0,0 +1,187 @@
+// src/core/FeatureCache.cpp
+
+#include "FeatureCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+const char kMagic[8] = {'P', 'A', 'A', 'F', 'E', 'A', 'T', 'S'};
+const uint32_t kVersion = 1;
+const uint64_t kMatrixAlignment = 64;
+
+struct FeatureCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dimension;
+    uint64_t configKey;
+    uint64_t count;
+    uint64_t matrixOffset;
+    uint64_t entriesOffset;
+    uint64_t pathsOffset;
+    uint64_t pathsSize;
+};
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Verifica se `count` elementos de `elementSize` bytes a partir de `offset`
+// cabem em `size` sem calcular offset + count * elementSize, que pode dar a
+// volta com um cabeçalho corrompido
+bool fitsIn(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size) {
+    return offset <= size && count <= (size - offset) / elementSize;
+}
+
+} // namespace
+
+FeatureCache::FeatureCache(std::string cachePath, uint64_t configKey)
+    : cachePath_(std::move(cachePath)), configKey_(configKey), dimension_(0),
+      matrix_(nullptr), entries_(nullptr) {}
+
+bool FeatureCache::load() {
+    index_.clear();
+    matrix_ = nullptr;
+    entries_ = nullptr;
+
+    if (!file_.open(cachePath_)) return false;
+
+    const unsigned char* base = file_.data();
+    const uint64_t fileSize = file_.size();
+    if (fileSize < sizeof(FeatureCacheHeader)) return false;
+
+    FeatureCacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion || header.configKey != configKey_ ||
+        header.dimension == 0) {
+        file_.close();
+        return false;
+    }
+
+    // Valida os limites de cada seção antes de confiar nos ponteiros
+    if (header.matrixOffset % kMatrixAlignment != 0 ||
+        !fitsIn(header.matrixOffset, header.count,
+                uint64_t(header.dimension) * sizeof(float), fileSize) ||
+        header.entriesOffset % alignof(Entry) != 0 ||
+        !fitsIn(header.entriesOffset, header.count, sizeof(Entry), fileSize) ||
+        !fitsIn(header.pathsOffset, header.pathsSize, 1, fileSize)) {
+        file_.close();
+        return false;
+    }
+
+    dimension_ = header.dimension;
+    matrix_ = reinterpret_cast<const float*>(base + header.matrixOffset);
+    entries_ = reinterpret_cast<const Entry*>(base + header.entriesOffset);
+
+    const char* paths = reinterpret_cast<const char*>(base + header.pathsOffset);
+    index_.reserve(header.count);
+    for (uint64_t i = 0; i < header.count; ++i) {
+        const Entry& e = entries_[i];
+        if (!fitsIn(e.pathOffset, e.pathLength, 1, header.pathsSize)) {
+            index_.clear();
+            file_.close();
+            return false;
+        }
+        index_.emplace(std::string(paths + e.pathOffset, e.pathLength), static_cast<uint32_t>(i));
+    }
+
+    return true;
+}
+
+const float* FeatureCache::lookup(const std::string& path, uint64_t fileSize, int64_t mtime,
+                                  double* extractionTime) const {
+    auto it = index_.find(path);
+    if (it == index_.end()) return nullptr;
+
+    const Entry& e = entries_[it->second];
+    if (e.fileSize != fileSize || e.mtime != mtime) return nullptr;
+
+    if (extractionTime) *extractionTime = e.extractionTime;
+    return matrix_ + static_cast<size_t>(it->second) * dimension_;
+}
+
+void FeatureCache::add(const std::string& path, uint64_t fileSize, int64_t mtime,
+                       const float* features, size_t dimension, double extractionTime) {
+    if (pendingEntries_.empty()) {
+        dimension_ = dimension;
+    } else if (dimension != dimension_) {
+        throw std::invalid_argument("Dimensao inconsistente no cache de caracteristicas: " + path);
+    }
+
+    uint64_t offset = 0;
+    if (!pendingEntries_.empty()) {
+        const Entry& last = pendingEntries_.back();
+        offset = last.pathOffset + last.pathLength;
+    }
+
+    pendingEntries_.push_back({fileSize, mtime, extractionTime, offset, path.size()});
+    pendingPaths_.push_back(path);
+    pendingMatrix_.insert(pendingMatrix_.end(), features, features + dimension);
+}
+
+void FeatureCache::save() const {
+    FeatureCacheHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.dimension = static_cast<uint32_t>(dimension_);
+    header.configKey = configKey_;
+    header.count = pendingEntries_.size();
+    header.matrixOffset = alignUp(sizeof(header), kMatrixAlignment);
+    header.entriesOffset = alignUp(header.matrixOffset + pendingMatrix_.size() * sizeof(float), alignof(Entry));
+    header.pathsOffset = header.entriesOffset + pendingEntries_.size() * sizeof(Entry);
+    header.pathsSize = 0;
+    for (const std::string& p : pendingPaths_) header.pathsSize += p.size();
+
+    const std::string tmpPath = cachePath_ + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Falha ao criar o cache de caracteristicas: " + tmpPath);
+        }
+
+        auto pad = [&out](uint64_t target) {
+            static const char zeros[kMatrixAlignment] = {};
+            uint64_t pos = static_cast<uint64_t>(out.tellp());
+            if (target > pos) out.write(zeros, static_cast<std::streamsize>(target - pos));
+        };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad(header.matrixOffset);
+        out.write(reinterpret_cast<const char*>(pendingMatrix_.data()),
+                  static_cast<std::streamsize>(pendingMatrix_.size() * sizeof(float)));
+        pad(header.entriesOffset);
+        out.write(reinterpret_cast<const char*>(pendingEntries_.data()),
+                  static_cast<std::streamsize>(pendingEntries_.size() * sizeof(Entry)));
+        for (const std::string& p : pendingPaths_) {
+            out.write(p.data(), static_cast<std::streamsize>(p.size()));
+        }
+
+        if (!out) {
+            throw std::runtime_error("Falha ao gravar o cache de caracteristicas: " + tmpPath);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath_, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        throw std::runtime_error("Falha ao substituir o cache de caracteristicas: " + cachePath_);
+    }
+}
+
+bool FeatureCache::fileStamp(const std::string& path, uint64_t& fileSize, int64_t& mtime) {
+    std::error_code ec;
+    fileSize = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+
+    mtime = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
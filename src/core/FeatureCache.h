@@ -0,0 +1,88 @@
+// src/core/FeatureCache.h
+
+#ifndef FEATURE_CACHE_H
+#define FEATURE_CACHE_H
+
+#include "MappedFile.h"
+#include "Vector.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Cache persistente de vetores de características em disco.
+ *
+ * Formato do arquivo (binário, endianness nativa):
+ *   - cabeçalho (FeatureCacheHeader)
+ *   - matriz de floats contígua, uma linha de `dimension` floats por imagem
+ *   - tabela de entradas (tamanho, mtime, tempo de extração, posição do caminho)
+ *   - bloco com os caminhos concatenados
+ *
+ * O arquivo é mapeado em memória na carga; uma entrada só é reaproveitada se o
+ * tamanho e o mtime do arquivo de imagem forem os mesmos de quando foi extraída.
+ * `configKey` identifica os parâmetros de extração: se mudar, o cache inteiro é
+ * descartado.
+ */
+class FeatureCache {
+public:
+    FeatureCache(std::string cachePath, uint64_t configKey);
+
+    /**
+     * @brief Mapeia o arquivo de cache. Retorna false se ele não existir ou for inválido.
+     */
+    bool load();
+
+    /**
+     * @brief Busca as características de uma imagem.
+     * @return Ponteiro para `dimension()` floats dentro do mapeamento, ou nullptr
+     *         se a imagem não estiver no cache ou tiver sido modificada.
+     */
+    const float* lookup(const std::string& path, uint64_t fileSize, int64_t mtime,
+                        double* extractionTime = nullptr) const;
+
+    /**
+     * @brief Registra uma imagem para a próxima gravação do cache.
+     */
+    void add(const std::string& path, uint64_t fileSize, int64_t mtime,
+             const float* features, size_t dimension, double extractionTime);
+
+    /**
+     * @brief Grava as entradas registradas com add() (escrita atômica via rename).
+     */
+    void save() const;
+
+    size_t dimension() const { return dimension_; }
+    size_t loadedCount() const { return index_.size(); }
+
+    /**
+     * @brief Lê tamanho e mtime de um arquivo no formato usado como chave do cache.
+     */
+    static bool fileStamp(const std::string& path, uint64_t& fileSize, int64_t& mtime);
+
+private:
+    struct Entry {
+        uint64_t fileSize;
+        int64_t mtime;
+        double extractionTime;
+        uint64_t pathOffset;
+        uint64_t pathLength;
+    };
+
+    std::string cachePath_;
+    uint64_t configKey_;
+    size_t dimension_;
+
+    // Cache carregado do disco
+    MappedFile file_;
+    const float* matrix_;
+    const Entry* entries_;
+    std::unordered_map<std::string, uint32_t> index_;
+
+    // Entradas pendentes para gravação
+    std::vector<std::string> pendingPaths_;
+    std::vector<Entry> pendingEntries_;
+    std::vector<float> pendingMatrix_;
+};
+
+#endif // FEATURE_CACHE_H
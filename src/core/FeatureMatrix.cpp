@@ -0,0 +1,34 @@
+// src/core/FeatureMatrix.cpp
+
+#include "FeatureMatrix.h"
+#include <cstring>
+#include <new>
+
+namespace {
+
+const size_t kFloatsPerLine = FeatureMatrix::kAlignment / sizeof(float);
+
+} // namespace
+
+void FeatureMatrix::AlignedDelete::operator()(float* p) const {
+    ::operator delete(p, std::align_val_t(kAlignment));
+}
+
+FeatureMatrix::FeatureMatrix(size_t rows, size_t cols) {
+    resize(rows, cols);
+}
+
+void FeatureMatrix::resize(size_t rows, size_t cols) {
+    const size_t stride = (cols + kFloatsPerLine - 1) / kFloatsPerLine * kFloatsPerLine;
+    const size_t needed = rows * stride;
+
+    if (needed > capacity_) {
+        data_.reset(static_cast<float*>(::operator new(needed * sizeof(float), std::align_val_t(kAlignment))));
+        capacity_ = needed;
+    }
+
+    rows_ = rows;
+    cols_ = cols;
+    stride_ = stride;
+    if (needed > 0) std::memset(data_.get(), 0, needed * sizeof(float));
+}
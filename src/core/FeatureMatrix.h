@@ -0,0 +1,53 @@
+// src/core/FeatureMatrix.h
+
+#ifndef FEATURE_MATRIX_H
+#define FEATURE_MATRIX_H
+
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief Matriz de características em ordem de linhas (uma linha por imagem).
+ *
+ * O bloco é alinhado a 64 bytes e cada linha ocupa stride() floats, múltiplo
+ * de 16, então toda linha começa em uma linha de cache e pode ser lida com
+ * cargas SIMD alinhadas. As colunas de preenchimento são sempre zero.
+ */
+class FeatureMatrix {
+public:
+    static const size_t kAlignment = 64;
+
+    FeatureMatrix() = default;
+    FeatureMatrix(size_t rows, size_t cols);
+
+    FeatureMatrix(FeatureMatrix&&) = default;
+    FeatureMatrix& operator=(FeatureMatrix&&) = default;
+
+    /**
+     * @brief Redimensiona e zera a matriz (reaproveita o bloco se ele for grande o suficiente).
+     */
+    void resize(size_t rows, size_t cols);
+
+    float* row(size_t i) { return data_.get() + i * stride_; }
+    const float* row(size_t i) const { return data_.get() + i * stride_; }
+
+    float* data() { return data_.get(); }
+    const float* data() const { return data_.get(); }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+
+private:
+    struct AlignedDelete {
+        void operator()(float* p) const;
+    };
+
+    std::unique_ptr<float[], AlignedDelete> data_;
+    size_t capacity_ = 0; // floats alocados
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t stride_ = 0;
+};
+
+#endif // FEATURE_MATRIX_H
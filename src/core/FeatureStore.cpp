@@ -0,0 +1,116 @@
+// src/core/FeatureStore.cpp
+
+#include "FeatureStore.h"
+#include "DistanceTile.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Mesmo preenchimento de FeatureMatrix: cada linha começa em uma linha de cache
+const size_t kFloatsPerLine = 64 / sizeof(float);
+
+size_t strideFor(size_t dimension) {
+    return (dimension + kFloatsPerLine - 1) / kFloatsPerLine * kFloatsPerLine;
+}
+
+} // namespace
+
+void FeatureStore::reserve(size_t images, size_t dimension, size_t pathBytes) {
+    data_.reserve(images * strideFor(dimension));
+    paths_.reserve(pathBytes);
+    pathOffsets_.reserve(images + 1);
+    extractionTimes_.reserve(images);
+    norms_.reserve(images);
+}
+
+uint32_t FeatureStore::add(std::string_view path, const float* features, size_t dimension, double extractionTime) {
+    if (empty()) {
+        dimension_ = dimension;
+        stride_ = strideFor(dimension);
+    } else if (dimension != dimension_) {
+        throw std::invalid_argument("Dimensão incompatível com as demais imagens do FeatureStore.");
+    }
+    if (size() >= std::numeric_limits<uint32_t>::max() ||
+        paths_.size() + path.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("FeatureStore cheio: ids e caminhos são limitados a 32 bits.");
+    }
+
+    const uint32_t id = static_cast<uint32_t>(size());
+
+    // A linha nova é zerada antes da cópia, então o preenchimento fica sempre em zero
+    float* row = data_.prepare(stride_);
+    std::fill(row + dimension, row + stride_, 0.0f);
+    std::copy(features, features + dimension, row);
+    data_.commit(stride_);
+
+    paths_.append(path.data(), path.size());
+    pathOffsets_.push_back(static_cast<uint32_t>(paths_.size()));
+    norms_.push_back(::squaredNorm(features, dimension));
+
+    // Por último: publica a imagem para os leitores concorrentes (veja size())
+    extractionTimes_.push_back(extractionTime);
+    return id;
+}
+
+ImageRef FeatureStore::image(uint32_t id) const {
+    if (id >= size()) {
+        throw std::out_of_range("Id inválido em FeatureStore::image");
+    }
+    return ImageRef{id, path(id), features(id), dimension_, extractionTimes_[id]};
+}
+
+FeatureVector FeatureStore::copyFeatures(uint32_t id) const {
+    const float* f = image(id).features;
+    return FeatureVector(f, f + dimension_);
+}
+
+template <size_t Dim>
+int FeatureStore::nearestAmong(const float* query, float queryNorm, const uint32_t* ids, uint32_t first,
+                               size_t count, int ignoreId, double& bestSquared) const {
+    // Divide o intervalo em volta da imagem ignorada
+    size_t skip = count;
+    if (ignoreId >= 0) {
+        if (ids) {
+            skip = std::find(ids, ids + count, static_cast<uint32_t>(ignoreId)) - ids;
+        } else if (static_cast<uint32_t>(ignoreId) >= first && static_cast<uint32_t>(ignoreId) - first < count) {
+            skip = static_cast<uint32_t>(ignoreId) - first;
+        }
+    }
+
+    const size_t tileRows = distanceTileRows(stride_);
+    int best = -1;
+    const size_t ranges[2][2] = {{0, skip}, {std::min(skip + 1, count), count}};
+    for (const auto& range : ranges) {
+        for (size_t start = range[0]; start < range[1]; start += tileRows) {
+            const size_t rows = std::min(tileRows, range[1] - start);
+            DistanceTile tile;
+            tile.stride = stride_;
+            tile.ids = ids ? ids + start : nullptr;
+            tile.count = rows;
+            tile.base = ids ? data_.data() : features(static_cast<uint32_t>(first + start));
+            tile.norms = ids ? norms_.data() : norms_.data() + first + start;
+
+            const size_t pos = nearestInTile<Dim>(query, queryNorm, tile, dimension_, bestSquared);
+            if (pos != TILE_NO_CANDIDATE) {
+                best = static_cast<int>(ids ? ids[start + pos] : first + start + pos);
+            }
+        }
+    }
+    return best;
+}
+
+template int FeatureStore::nearestAmong<DYNAMIC_DIMENSION>(const float*, float, const uint32_t*, uint32_t, size_t,
+                                                           int, double&) const;
+template int FeatureStore::nearestAmong<8>(const float*, float, const uint32_t*, uint32_t, size_t, int,
+                                           double&) const;
+template int FeatureStore::nearestAmong<64>(const float*, float, const uint32_t*, uint32_t, size_t, int,
+                                            double&) const;
+template int FeatureStore::nearestAmong<512>(const float*, float, const uint32_t*, uint32_t, size_t, int,
+                                             double&) const;
+
+size_t FeatureStore::memoryBytes() const {
+    return data_.capacity() * sizeof(float) + paths_.capacity() + pathOffsets_.capacity() * sizeof(uint32_t) +
+           extractionTimes_.capacity() * sizeof(double) + norms_.capacity() * sizeof(float);
+}
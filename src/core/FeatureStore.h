@@ -0,0 +1,127 @@
+// src/core/FeatureStore.h
+
+#ifndef FEATURE_STORE_H
+#define FEATURE_STORE_H
+
+#include "AppendArray.h"
+#include "Vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Visão de uma imagem do FeatureStore (não copia caminho nem características).
+ * Válida enquanto o store existir e não receber novas imagens (ou, com
+ * inserções concorrentes, enquanto quem a obteve mantiver um EpochGuard).
+ */
+struct ImageRef {
+    uint32_t id;
+    std::string_view path;
+    const float* features;
+    size_t dimension;
+    double extraction_time;
+};
+
+/**
+ * @brief Armazenamento colunar e compartilhado do conjunto de imagens.
+ *
+ * Guarda uma única cópia de cada imagem: as características em um bloco
+ * contíguo alinhado a 64 bytes (uma linha de stride() floats por imagem, como
+ * FeatureMatrix), os caminhos concatenados em um único bloco de texto e os
+ * metadados em vetores paralelos. Cada imagem é identificada pelo id de 32
+ * bits devolvido por add(), na ordem de inserção.
+ *
+ * Os índices (ImageList, HashTable, QuadTree, LSH, MTree) guardam só ids e
+ * uma referência ao store, que deve viver mais que eles. Um add() pode
+ * realocar os blocos, então ponteiros devolvidos por features() só valem até
+ * a próxima inserção; os ids não mudam.
+ *
+ * Uma thread pode chamar add() enquanto outras leem: os blocos são
+ * AppendArray e size() só cresce depois que todos os dados da imagem nova
+ * estão gravados, então leitores que consultam ids < size() veem imagens
+ * completas. Os blocos antigos são liberados por épocas: um leitor
+ * concorrente mantém um EpochGuard enquanto usa os ponteiros (as consultas
+ * de ImageList, LSH e MTree já abrem o seu). reserve() e add() continuam
+ * restritos a uma thread por vez.
+ */
+class FeatureStore {
+public:
+    FeatureStore() { pathOffsets_.push_back(0); }
+
+    FeatureStore(FeatureStore&&) = default;
+    FeatureStore& operator=(FeatureStore&&) = default;
+
+    /**
+     * @brief Reserva espaço para `images` imagens de `dimension` floats e
+     * `pathBytes` bytes de caminhos (evita realocações durante a carga).
+     */
+    void reserve(size_t images, size_t dimension, size_t pathBytes = 0);
+
+    /**
+     * @brief Acrescenta uma imagem e devolve o seu id.
+     * A primeira imagem fixa a dimensão; as seguintes devem ter a mesma
+     * (std::invalid_argument caso contrário).
+     */
+    uint32_t add(std::string_view path, const float* features, size_t dimension, double extractionTime);
+
+    const float* features(uint32_t id) const { return data_.data() + static_cast<size_t>(id) * stride_; }
+
+    std::string_view path(uint32_t id) const {
+        const uint32_t* offsets = pathOffsets_.data();
+        return std::string_view(paths_.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+    double extractionTime(uint32_t id) const { return extractionTimes_[id]; }
+
+    /**
+     * @brief ||x||² de cada imagem, calculado na inserção (usado por nearestInTile).
+     */
+    float squaredNorm(uint32_t id) const { return norms_[id]; }
+    const float* squaredNorms() const { return norms_.data(); }
+
+    /**
+     * @brief Imagem mais próxima de `query` entre `count` imagens, varrida em
+     * blocos de distanceTileRows() linhas com nearestInTile<Dim>.
+     *
+     * As imagens são ids[0..count) ou, com `ids == nullptr`, os ids
+     * first..first+count-1 (linhas consecutivas do bloco). `ignoreId` é pulado.
+     * Retorna o id com distância ao quadrado < bestSquared (atualizando-o) ou
+     * -1 se nenhuma melhora o limite; empates ficam com a primeira na ordem dada.
+     */
+    template <size_t Dim>
+    int nearestAmong(const float* query, float queryNorm, const uint32_t* ids, uint32_t first, size_t count,
+                     int ignoreId, double& bestSquared) const;
+
+    /**
+     * @brief Visão completa da imagem `id` (std::out_of_range se o id não existir).
+     */
+    ImageRef image(uint32_t id) const;
+
+    /**
+     * @brief Cópia das características de `id` (para usar a imagem como consulta).
+     */
+    FeatureVector copyFeatures(uint32_t id) const;
+
+    size_t size() const { return extractionTimes_.size(); }
+    bool empty() const { return extractionTimes_.empty(); }
+    size_t dimension() const { return dimension_; }
+    size_t stride() const { return stride_; }
+
+    /**
+     * @brief Bytes ocupados pelos blocos do store (capacidade, não só o usado).
+     */
+    size_t memoryBytes() const;
+
+private:
+    AppendArray<float, 64> data_;
+    AppendArray<char> paths_;
+    AppendArray<uint32_t> pathOffsets_; // size() + 1 posições (a primeira é 0)
+    AppendArray<double> extractionTimes_; // o último bloco gravado: publica a imagem
+    AppendArray<float> norms_;
+    size_t dimension_ = 0; // fixados pela primeira imagem, antes de ela ser publicada
+    size_t stride_ = 0;
+};
+
+#endif // FEATURE_STORE_H
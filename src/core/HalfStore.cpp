@@ -0,0 +1,347 @@
+// src/core/HalfStore.cpp
+
+#include "HalfStore.h"
+#include "Avx512.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cstring>
+
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Valores por linha múltiplos de 32: 64 bytes, uma linha de cache
+const size_t kHalfAlignment = 32;
+
+using HalfDistanceFn = double (*)(const float*, const uint16_t*, size_t, double);
+
+inline uint32_t floatBits(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+inline float bitsFloat(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Conversões em software (F. Giesen, "half_to_float" e "float_to_half_fast3_rtne")
+uint16_t floatToFp16(float value) {
+    uint32_t x = floatBits(value);
+    const uint32_t sign = x & 0x80000000u;
+    x ^= sign;
+
+    uint16_t out;
+    if (x >= (127u + 16u) << 23) {
+        out = x > (255u << 23) ? 0x7e00 : 0x7c00; // NaN ou fora da faixa (infinito)
+    } else if (x < 113u << 23) {
+        // Subnormal em FP16: a soma com 0.5f arredonda a mantissa para o par mais próximo
+        const float magic = bitsFloat(126u << 23);
+        out = static_cast<uint16_t>(floatBits(bitsFloat(x) + magic) - floatBits(magic));
+    } else {
+        const uint32_t mantissaOdd = (x >> 13) & 1;
+        x -= (127u - 15u) << 23;
+        x += 0xfff + mantissaOdd;
+        out = static_cast<uint16_t>(x >> 13);
+    }
+    return static_cast<uint16_t>(out | (sign >> 16));
+}
+
+float fp16ToFloat(uint16_t value) {
+    const float magic = bitsFloat(113u << 23);
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+    uint32_t out = (value & 0x7fffu) << 13;
+    const uint32_t exponent = shiftedExponent & out;
+    out += (127u - 15u) << 23;
+    if (exponent == shiftedExponent) {
+        out += (128u - 16u) << 23; // infinito ou NaN
+    } else if (exponent == 0) {
+        out += 1u << 23; // subnormal: renormaliza pela subtração
+        out = floatBits(bitsFloat(out) - magic);
+    }
+    return bitsFloat(out | (static_cast<uint32_t>(value & 0x8000u) << 16));
+}
+
+uint16_t floatToBf16(float value) {
+    const uint32_t x = floatBits(value);
+    if ((x & 0x7fffffffu) > 0x7f800000u) return static_cast<uint16_t>((x >> 16) | 0x40); // NaN silencioso
+    return static_cast<uint16_t>((x + 0x7fffu + ((x >> 16) & 1)) >> 16);
+}
+
+inline float bf16ToFloat(uint16_t value) { return bitsFloat(static_cast<uint32_t>(value) << 16); }
+
+template <HalfFormat Format>
+inline float toFloat(uint16_t value) {
+    return Format == HalfFormat::FP16 ? fp16ToFloat(value) : bf16ToFloat(value);
+}
+
+// Dim != DYNAMIC_DIMENSION fixa n em tempo de compilação (laços desenrolados)
+template <HalfFormat Format, size_t Dim>
+double halfReference(const float* a, const uint16_t* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    double sum_of_squares = 0.0;
+    for (size_t start = 0; start < n; start += DISTANCE_BLOCK) {
+        const size_t end = std::min(n, start + DISTANCE_BLOCK);
+        for (size_t i = start; i < end; ++i) {
+            const float d = a[i] - toFloat<Format>(b[i]);
+            sum_of_squares += d * d;
+        }
+        if (sum_of_squares > bound) break;
+    }
+    return sum_of_squares;
+}
+
+#if ANALISE_X86_DISPATCH
+
+ANALISE_TARGET("avx2,fma,f16c")
+inline float horizontalSum(__m256 v) {
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+
+// 8 valores de 16 bits -> 8 floats
+template <HalfFormat Format>
+ANALISE_TARGET("avx2,fma,f16c")
+inline __m256 loadHalf8(const uint16_t* p) {
+    const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    if (Format == HalfFormat::FP16) return _mm256_cvtph_ps(raw);
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(raw), 16));
+}
+
+template <HalfFormat Format, size_t Dim>
+ANALISE_TARGET("avx2,fma,f16c")
+double halfAvx2(const float* a, const uint16_t* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+    while (i + DISTANCE_BLOCK <= n) {
+        for (const size_t end = i + DISTANCE_BLOCK; i < end; i += 32) {
+            __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), loadHalf8<Format>(b + i));
+            __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), loadHalf8<Format>(b + i + 8));
+            __m256 d2 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 16), loadHalf8<Format>(b + i + 16));
+            __m256 d3 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 24), loadHalf8<Format>(b + i + 24));
+            acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+            acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+            acc2 = _mm256_fmadd_ps(d2, d2, acc2);
+            acc3 = _mm256_fmadd_ps(d3, d3, acc3);
+        }
+        if (i < n) {
+            const float partial = horizontalSum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), loadHalf8<Format>(b + i));
+        acc0 = _mm256_fmadd_ps(d, d, acc0);
+    }
+
+    float sum = horizontalSum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; ++i) {
+        float d = a[i] - toFloat<Format>(b[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+// 16 valores de 16 bits -> 16 floats (vcvtph2ps faz parte do AVX-512F)
+template <HalfFormat Format>
+ANALISE_TARGET("avx512f")
+inline __m512 loadHalf16(const uint16_t* p) {
+    const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    if (Format == HalfFormat::FP16) return avx512::cvtph(raw);
+    return _mm512_castsi512_ps(avx512::slli32(avx512::cvtepu16(raw), 16));
+}
+
+template <HalfFormat Format, size_t Dim>
+ANALISE_TARGET("avx512f")
+double halfAvx512(const float* a, const uint16_t* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+    size_t i = 0;
+    // Um bloco de DISTANCE_BLOCK (64) valores por iteração
+    for (; i + 64 <= n; i += 64) {
+        __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), loadHalf16<Format>(b + i));
+        __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), loadHalf16<Format>(b + i + 16));
+        __m512 d2 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 32), loadHalf16<Format>(b + i + 32));
+        __m512 d3 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 48), loadHalf16<Format>(b + i + 48));
+        acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+        acc2 = _mm512_fmadd_ps(d2, d2, acc2);
+        acc3 = _mm512_fmadd_ps(d3, d3, acc3);
+        if (i + 64 < n) {
+            const float partial = avx512::reduceAdd(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), loadHalf16<Format>(b + i));
+        acc0 = _mm512_fmadd_ps(d, d, acc0);
+    }
+
+    float sum = avx512::reduceAdd(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+    for (; i < n; ++i) {
+        float d = a[i] - toFloat<Format>(b[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+ANALISE_TARGET("avx,f16c")
+size_t encodeFp16F16c(const float* values, uint16_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), half);
+    }
+    return i;
+}
+
+ANALISE_TARGET("avx512f,avx512bf16")
+size_t encodeBf16Avx512(const float* values, uint16_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256bh half = _mm512_cvtneps_pbh(_mm512_loadu_ps(values + i));
+        std::memcpy(out + i, &half, sizeof(half));
+    }
+    return i;
+}
+
+#endif // ANALISE_X86_DISPATCH
+
+// Kernels pedidos que a CPU não suporta caem para o próximo abaixo
+template <HalfFormat Format, size_t Dim>
+HalfDistanceFn halfDistanceFn(DistanceKernel kernel) {
+#if ANALISE_X86_DISPATCH
+    const CpuFeatures& cpu = cpuFeatures();
+    if (kernel == DistanceKernel::AVX512 && cpu.avx512f) {
+        return halfAvx512<Format, Dim>;
+    }
+    if ((kernel == DistanceKernel::AVX512 || kernel == DistanceKernel::AVX2) && cpu.avx2 && cpu.fma && cpu.f16c) {
+        return halfAvx2<Format, Dim>;
+    }
+#endif
+    (void)kernel;
+    return halfReference<Format, Dim>;
+}
+
+// Kernel de DistanceKernel::Auto para cada formato e dimensão, escolhido na primeira chamada
+template <HalfFormat Format, size_t Dim>
+HalfDistanceFn bestHalfDistanceFn() {
+    static const HalfDistanceFn fn = halfDistanceFn<Format, Dim>(bestDistanceKernel());
+    return fn;
+}
+
+size_t halfStrideFor(size_t dimension) {
+    return (dimension + kHalfAlignment - 1) / kHalfAlignment * kHalfAlignment;
+}
+
+template <HalfFormat Format, size_t Dim>
+int nearestInHalfRows(const HalfStore& half, const float* query, const uint32_t* ids, uint32_t first,
+                      size_t count, int ignoreId, double& bestSquared) {
+    const HalfDistanceFn fn = bestHalfDistanceFn<Format, Dim>();
+    int best = -1;
+    for (size_t r = 0; r < count; ++r) {
+        const uint32_t id = ids ? ids[r] : first + static_cast<uint32_t>(r);
+        if (static_cast<int>(id) == ignoreId) continue;
+
+        const double distance = fn(query, half.features(id), half.dimension(), bestSquared);
+        if (distance < bestSquared) {
+            bestSquared = distance;
+            best = static_cast<int>(id);
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+uint16_t floatToHalf(float value, HalfFormat format) {
+    return format == HalfFormat::FP16 ? floatToFp16(value) : floatToBf16(value);
+}
+
+float halfToFloat(uint16_t value, HalfFormat format) {
+    return format == HalfFormat::FP16 ? fp16ToFloat(value) : bf16ToFloat(value);
+}
+
+void encodeHalf(const float* values, uint16_t* out, size_t count, HalfFormat format) {
+    size_t i = 0;
+#if ANALISE_X86_DISPATCH
+    if (format == HalfFormat::FP16 && cpuFeatures().f16c) {
+        i = encodeFp16F16c(values, out, count);
+    } else if (format == HalfFormat::BF16 && cpuFeatures().avx512bf16) {
+        i = encodeBf16Avx512(values, out, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = floatToHalf(values[i], format);
+    }
+}
+
+template <HalfFormat Format, size_t Dim>
+double squaredHalfDistance(const float* query, const uint16_t* half, size_t dimension, double bound) {
+    return bestHalfDistanceFn<Format, Dim>()(query, half, dimension, bound);
+}
+
+template double squaredHalfDistance<HalfFormat::FP16, DYNAMIC_DIMENSION>(const float*, const uint16_t*, size_t, double);
+template double squaredHalfDistance<HalfFormat::FP16, 8>(const float*, const uint16_t*, size_t, double);
+template double squaredHalfDistance<HalfFormat::FP16, 64>(const float*, const uint16_t*, size_t, double);
+template double squaredHalfDistance<HalfFormat::FP16, 512>(const float*, const uint16_t*, size_t, double);
+template double squaredHalfDistance<HalfFormat::BF16, DYNAMIC_DIMENSION>(const float*, const uint16_t*, size_t, double);
+template double squaredHalfDistance<HalfFormat::BF16, 8>(const float*, const uint16_t*, size_t, double);
+template double squaredHalfDistance<HalfFormat::BF16, 64>(const float*, const uint16_t*, size_t, double);
+template double squaredHalfDistance<HalfFormat::BF16, 512>(const float*, const uint16_t*, size_t, double);
+
+double squaredHalfDistance(HalfFormat format, const float* query, const uint16_t* half, size_t dimension,
+                           DistanceKernel kernel) {
+    const double noBound = std::numeric_limits<double>::infinity();
+    if (format == HalfFormat::FP16) {
+        const HalfDistanceFn fn = kernel == DistanceKernel::Auto
+                                      ? bestHalfDistanceFn<HalfFormat::FP16, DYNAMIC_DIMENSION>()
+                                      : halfDistanceFn<HalfFormat::FP16, DYNAMIC_DIMENSION>(kernel);
+        return fn(query, half, dimension, noBound);
+    }
+    const HalfDistanceFn fn = kernel == DistanceKernel::Auto
+                                  ? bestHalfDistanceFn<HalfFormat::BF16, DYNAMIC_DIMENSION>()
+                                  : halfDistanceFn<HalfFormat::BF16, DYNAMIC_DIMENSION>(kernel);
+    return fn(query, half, dimension, noBound);
+}
+
+HalfStore::HalfStore(const FeatureStore& store, HalfFormat format)
+    : store_(&store), format_(format), size_(store.size()), dimension_(store.dimension()),
+      stride_(halfStrideFor(store.dimension())) {
+    data_.assign(size_ * stride_, 0);
+    for (uint32_t id = 0; id < size_; ++id) {
+        encodeHalf(store.features(id), data_.data() + static_cast<size_t>(id) * stride_, dimension_, format_);
+    }
+}
+
+template <size_t Dim>
+int HalfStore::nearestAmong(const float* query, const uint32_t* ids, uint32_t first, size_t count, int ignoreId,
+                            double& bestSquared) const {
+    if (format_ == HalfFormat::FP16) {
+        return nearestInHalfRows<HalfFormat::FP16, Dim>(*this, query, ids, first, count, ignoreId, bestSquared);
+    }
+    return nearestInHalfRows<HalfFormat::BF16, Dim>(*this, query, ids, first, count, ignoreId, bestSquared);
+}
+
+template int HalfStore::nearestAmong<DYNAMIC_DIMENSION>(const float*, const uint32_t*, uint32_t, size_t, int,
+                                                        double&) const;
+template int HalfStore::nearestAmong<8>(const float*, const uint32_t*, uint32_t, size_t, int, double&) const;
+template int HalfStore::nearestAmong<64>(const float*, const uint32_t*, uint32_t, size_t, int, double&) const;
+template int HalfStore::nearestAmong<512>(const float*, const uint32_t*, uint32_t, size_t, int, double&) const;
+
+const char* halfFormatName(HalfFormat format) {
+    return format == HalfFormat::FP16 ? "fp16" : "bf16";
+}
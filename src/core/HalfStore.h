@@ -0,0 +1,111 @@
+// src/core/HalfStore.h
+
+#ifndef HALF_STORE_H
+#define HALF_STORE_H
+
+#include "FeatureStore.h"
+#include "Vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Formatos de 16 bits para as características.
+ */
+enum class HalfFormat {
+    FP16, // IEEE binário16: 10 bits de mantissa, faixa até 65504
+    BF16  // bfloat16: os 16 bits altos do float (8 bits de mantissa, mesma faixa)
+};
+
+/**
+ * @brief Conversão de um valor com arredondamento para o par mais próximo.
+ * Fora da faixa do FP16 o resultado é infinito; NaN continua NaN.
+ */
+uint16_t floatToHalf(float value, HalfFormat format);
+float halfToFloat(uint16_t value, HalfFormat format);
+
+/**
+ * @brief Converte `count` floats (F16C para FP16 e AVX-512 BF16 para BF16
+ * quando disponíveis). Os resultados são os de floatToHalf, exceto que o
+ * AVX-512 BF16 trata floats subnormais como zero.
+ */
+void encodeHalf(const float* values, uint16_t* out, size_t count, HalfFormat format);
+
+/**
+ * @brief Quadrado da distância euclidiana entre uma consulta em float e um
+ * vetor de 16 bits, com abandono antecipado (mesmo contrato de
+ * squaredEuclideanDistance<Dim>).
+ *
+ * Os valores de 16 bits são convertidos para float dentro do kernel (F16C ou
+ * deslocamento de 16 bits para BF16) e as somas são feitas em float, então o
+ * único erro em relação à distância original é o arredondamento da base.
+ */
+template <HalfFormat Format, size_t Dim>
+double squaredHalfDistance(const float* query, const uint16_t* half, size_t dimension,
+                           double bound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Versão com formato em tempo de execução e kernel específico (para os
+ * microbenchmarks). SSE2 não tem conversão em hardware e usa a referência.
+ */
+double squaredHalfDistance(HalfFormat format, const float* query, const uint16_t* half, size_t dimension,
+                           DistanceKernel kernel = DistanceKernel::Auto);
+
+/**
+ * @brief Cópia de 16 bits por característica de um FeatureStore.
+ *
+ * Ocupa metade da memória dos floats, então uma varredura sobre ela lê
+ * metade dos bytes. Ao contrário de QuantizedStore, a busca não reordena com
+ * os floats: o vizinho devolvido é o mais próximo das características
+ * arredondadas, que pode diferir do exato quando duas imagens estão a
+ * distâncias quase iguais da consulta.
+ *
+ * Linhas de stride() valores (múltiplo de 32, uma linha de cache), com o
+ * preenchimento zerado. O store deve viver mais que esta cópia, e imagens
+ * acrescentadas a ele depois da construção não estão convertidas.
+ */
+class HalfStore {
+public:
+    HalfStore(const FeatureStore& store, HalfFormat format);
+
+    const uint16_t* features(uint32_t id) const { return data_.data() + static_cast<size_t>(id) * stride_; }
+
+    const FeatureStore& source() const { return *store_; }
+
+    /**
+     * @brief Indica se esta cópia é de `store` e cobre todas as suas imagens.
+     */
+    bool covers(const FeatureStore& store) const { return store_ == &store && size_ == store.size(); }
+    HalfFormat format() const { return format_; }
+
+    /**
+     * @brief Imagem mais próxima de `query` entre ids[0..count) (ou
+     * first..first+count-1 com `ids == nullptr`), pela distância às
+     * características de 16 bits. Mesmo contrato de FeatureStore::nearestAmong.
+     */
+    template <size_t Dim>
+    int nearestAmong(const float* query, const uint32_t* ids, uint32_t first, size_t count, int ignoreId,
+                     double& bestSquared) const;
+
+    size_t size() const { return size_; }
+    size_t dimension() const { return dimension_; }
+    size_t stride() const { return stride_; }
+
+    /**
+     * @brief Bytes dos valores de 16 bits (sem o FeatureStore de origem).
+     */
+    size_t memoryBytes() const { return data_.capacity() * sizeof(uint16_t); }
+
+private:
+    const FeatureStore* store_;
+    HalfFormat format_;
+    std::vector<uint16_t, AlignedAllocator<uint16_t>> data_;
+    size_t size_ = 0;
+    size_t dimension_ = 0;
+    size_t stride_ = 0;
+};
+
+const char* halfFormatName(HalfFormat format);
+
+#endif // HALF_STORE_H
@@ -0,0 +1,302 @@
+// src/core/Histogram.cpp
+
+#include "Histogram.h"
+#include "CpuFeatures.h"
+#include <cstring>
+#include <vector>
+
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Histogramas até este tamanho são acumulados em 4 cópias privadas, para que
+// pixels consecutivos da mesma cor não esperem o store anterior (store-to-load).
+const size_t kMaxSubHistogramSize = 4096;
+const int kSubHistograms = 4;
+
+bool isPowerOfTwo(int v) {
+    return v > 0 && (v & (v - 1)) == 0;
+}
+
+void histogramReference(const unsigned char* rgb, size_t pixelCount, int bins, uint32_t* counts) {
+    const size_t histogramSize = static_cast<size_t>(bins) * bins * bins;
+    const int binSize = 256 / bins;
+
+    for (size_t i = 0; i < pixelCount; ++i) {
+        int rBin = rgb[i * 3 + 0] / binSize;
+        int gBin = rgb[i * 3 + 1] / binSize;
+        int bBin = rgb[i * 3 + 2] / binSize;
+
+        size_t binIndex = static_cast<size_t>(rBin) * bins * bins + gBin * bins + bBin;
+        if (binIndex < histogramSize) {
+            counts[binIndex]++;
+        }
+    }
+}
+
+// Tabelas por canal: índice = lutR[r] + lutG[g] + lutB[b]
+void histogramLut(const unsigned char* rgb, size_t pixelCount, int bins, uint32_t* const hist[4]) {
+    const uint32_t histogramSize = static_cast<uint32_t>(bins * bins * bins);
+    const int binSize = 256 / bins;
+
+    uint32_t lutR[256], lutG[256], lutB[256];
+    for (int v = 0; v < 256; ++v) {
+        uint32_t bin = static_cast<uint32_t>(v / binSize);
+        lutR[v] = bin * bins * bins;
+        lutG[v] = bin * bins;
+        lutB[v] = bin;
+    }
+
+    // Com bins potência de dois todo índice é válido; nos outros casos o último
+    // bin de cada canal pode estourar e é descartado, como no laço original.
+    const bool checked = !isPowerOfTwo(bins);
+
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const unsigned char* p = rgb + i * 3;
+        uint32_t index = lutR[p[0]] + lutG[p[1]] + lutB[p[2]];
+        if (checked && index >= histogramSize) continue;
+        hist[i & 3][index]++;
+    }
+}
+
+// Kernels especializados por número de bins: deslocamentos, máscaras e o
+// tamanho do histograma são constantes de compilação
+
+template <int Bins>
+inline uint32_t binIndex(const unsigned char* p) {
+    using L = HistogramLayout<Bins>;
+    return (static_cast<uint32_t>(p[0] >> L::kShift) << (2 * L::kBits)) |
+           (static_cast<uint32_t>(p[1] >> L::kShift) << L::kBits) |
+           static_cast<uint32_t>(p[2] >> L::kShift);
+}
+
+template <int Bins>
+using SubHistograms = uint32_t[kSubHistograms][HistogramLayout<Bins>::kSize];
+
+template <int Bins>
+void histogramShift(const unsigned char* rgb, size_t pixelCount, SubHistograms<Bins>& hist) {
+    size_t i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        const unsigned char* p = rgb + i * 3;
+        hist[0][binIndex<Bins>(p)]++;
+        hist[1][binIndex<Bins>(p + 3)]++;
+        hist[2][binIndex<Bins>(p + 6)]++;
+        hist[3][binIndex<Bins>(p + 9)]++;
+    }
+    for (; i < pixelCount; ++i) {
+        hist[i & 3][binIndex<Bins>(rgb + i * 3)]++;
+    }
+}
+
+#if ANALISE_X86_DISPATCH
+
+template <int Bins>
+ANALISE_TARGET("ssse3")
+void histogramSsse3(const unsigned char* rgb, size_t pixelCount, SubHistograms<Bins>& hist) {
+    using L = HistogramLayout<Bins>;
+
+    // Cada pixel RGB vai para uma lane de 32 bits: r | g << 8 | b << 16
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i mask = _mm_set1_epi32(Bins - 1);
+
+    alignas(16) uint32_t index[4];
+    size_t i = 0;
+
+    // Cada iteração lê 16 bytes e usa 12: mantém 2 pixels de folga no final
+    for (; i + 6 <= pixelCount; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+        v = _mm_shuffle_epi8(v, spread);
+
+        __m128i r = _mm_and_si128(_mm_srli_epi32(v, L::kShift), mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8 + L::kShift), mask);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16 + L::kShift), mask);
+        __m128i idx = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 2 * L::kBits), _mm_slli_epi32(g, L::kBits)), b);
+        _mm_store_si128(reinterpret_cast<__m128i*>(index), idx);
+
+        hist[0][index[0]]++;
+        hist[1][index[1]]++;
+        hist[2][index[2]]++;
+        hist[3][index[3]]++;
+    }
+
+    for (; i < pixelCount; ++i) {
+        hist[i & 3][binIndex<Bins>(rgb + i * 3)]++;
+    }
+}
+
+template <int Bins>
+ANALISE_TARGET("avx2")
+void histogramAvx2(const unsigned char* rgb, size_t pixelCount, SubHistograms<Bins>& hist) {
+    using L = HistogramLayout<Bins>;
+
+    const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i mask = _mm256_set1_epi32(Bins - 1);
+
+    alignas(32) uint32_t index[8];
+    size_t i = 0;
+
+    // Pixels 0-3 na metade baixa e 4-7 na alta; a segunda leitura vai até o
+    // byte 27, então são necessários 2 pixels de folga no final
+    for (; i + 10 <= pixelCount; i += 8) {
+        const unsigned char* p = rgb + i * 3;
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        v = _mm256_shuffle_epi8(v, spread);
+
+        __m256i r = _mm256_and_si256(_mm256_srli_epi32(v, L::kShift), mask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(v, 8 + L::kShift), mask);
+        __m256i b = _mm256_and_si256(_mm256_srli_epi32(v, 16 + L::kShift), mask);
+        __m256i idx = _mm256_or_si256(
+            _mm256_or_si256(_mm256_slli_epi32(r, 2 * L::kBits), _mm256_slli_epi32(g, L::kBits)), b);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(index), idx);
+
+        hist[0][index[0]]++;
+        hist[1][index[1]]++;
+        hist[2][index[2]]++;
+        hist[3][index[3]]++;
+        hist[0][index[4]]++;
+        hist[1][index[5]]++;
+        hist[2][index[6]]++;
+        hist[3][index[7]]++;
+    }
+
+    for (; i < pixelCount; ++i) {
+        hist[i & 3][binIndex<Bins>(rgb + i * 3)]++;
+    }
+}
+
+#endif // ANALISE_X86_DISPATCH
+
+} // namespace
+
+bool isHistogramKernelSupported(HistogramKernel kernel) {
+    switch (kernel) {
+        case HistogramKernel::Reference:
+        case HistogramKernel::Scalar:
+        case HistogramKernel::Auto:
+            return true;
+#if ANALISE_X86_DISPATCH
+        case HistogramKernel::SSSE3:
+            return cpuFeatures().ssse3;
+        case HistogramKernel::AVX2:
+            return cpuFeatures().avx2;
+#endif
+        default:
+            return false;
+    }
+}
+
+HistogramKernel bestHistogramKernel() {
+    if (isHistogramKernelSupported(HistogramKernel::AVX2)) return HistogramKernel::AVX2;
+    if (isHistogramKernelSupported(HistogramKernel::SSSE3)) return HistogramKernel::SSSE3;
+    return HistogramKernel::Scalar;
+}
+
+const char* histogramKernelName(HistogramKernel kernel) {
+    switch (kernel) {
+        case HistogramKernel::Reference: return "referencia";
+        case HistogramKernel::Scalar: return "escalar";
+        case HistogramKernel::SSSE3: return "ssse3";
+        case HistogramKernel::AVX2: return "avx2";
+        case HistogramKernel::Auto: return "auto";
+    }
+    return "?";
+}
+
+template <int Bins>
+void computeColorHistogram(const unsigned char* rgb, size_t pixelCount, uint32_t* counts,
+                           HistogramKernel kernel) {
+    using L = HistogramLayout<Bins>;
+
+    if (kernel == HistogramKernel::Reference) {
+        std::memset(counts, 0, L::kSize * sizeof(uint32_t));
+        histogramReference(rgb, pixelCount, Bins, counts);
+        return;
+    }
+
+    if (kernel == HistogramKernel::Auto || !isHistogramKernelSupported(kernel)) {
+        kernel = bestHistogramKernel();
+    }
+
+    // Sub-histogramas na pilha: no máximo 4 x 4096 contadores (bins = 16)
+    SubHistograms<Bins> hist;
+    std::memset(hist, 0, sizeof(hist));
+
+    switch (kernel) {
+#if ANALISE_X86_DISPATCH
+        case HistogramKernel::AVX2:
+            histogramAvx2<Bins>(rgb, pixelCount, hist);
+            break;
+        case HistogramKernel::SSSE3:
+            histogramSsse3<Bins>(rgb, pixelCount, hist);
+            break;
+#endif
+        default:
+            histogramShift<Bins>(rgb, pixelCount, hist);
+            break;
+    }
+
+    for (size_t j = 0; j < L::kSize; ++j) {
+        counts[j] = hist[0][j] + hist[1][j] + hist[2][j] + hist[3][j];
+    }
+}
+
+template void computeColorHistogram<2>(const unsigned char*, size_t, uint32_t*, HistogramKernel);
+template void computeColorHistogram<4>(const unsigned char*, size_t, uint32_t*, HistogramKernel);
+template void computeColorHistogram<8>(const unsigned char*, size_t, uint32_t*, HistogramKernel);
+template void computeColorHistogram<16>(const unsigned char*, size_t, uint32_t*, HistogramKernel);
+
+void computeColorHistogram(const unsigned char* rgb, size_t pixelCount, int binsPerChannel,
+                           uint32_t* counts, HistogramKernel kernel) {
+    const size_t histogramSize = static_cast<size_t>(binsPerChannel) * binsPerChannel * binsPerChannel;
+
+    // A referência fica com bins em tempo de execução (divisões de verdade)
+    if (kernel == HistogramKernel::Reference) {
+        std::memset(counts, 0, histogramSize * sizeof(uint32_t));
+        histogramReference(rgb, pixelCount, binsPerChannel, counts);
+        return;
+    }
+
+    // Despacha para a especialização de compilação quando existir
+    switch (binsPerChannel) {
+        case 2: computeColorHistogram<2>(rgb, pixelCount, counts, kernel); return;
+        case 4: computeColorHistogram<4>(rgb, pixelCount, counts, kernel); return;
+        case 8: computeColorHistogram<8>(rgb, pixelCount, counts, kernel); return;
+        case 16: computeColorHistogram<16>(rgb, pixelCount, counts, kernel); return;
+        default: break;
+    }
+
+    std::memset(counts, 0, histogramSize * sizeof(uint32_t));
+
+    // Demais tamanhos: tabelas de consulta em tempo de execução
+    thread_local std::vector<uint32_t> partial; // reaproveitado entre chamadas
+    partial.clear();
+    uint32_t* hist[kSubHistograms] = {counts, counts, counts, counts};
+    if (histogramSize <= kMaxSubHistogramSize) {
+        partial.assign(histogramSize * (kSubHistograms - 1), 0);
+        for (int k = 1; k < kSubHistograms; ++k) {
+            hist[k] = partial.data() + (k - 1) * histogramSize;
+        }
+    }
+
+    histogramLut(rgb, pixelCount, binsPerChannel, hist);
+
+    if (!partial.empty()) {
+        for (int k = 1; k < kSubHistograms; ++k) {
+            for (size_t j = 0; j < histogramSize; ++j) {
+                counts[j] += hist[k][j];
+            }
+        }
+    }
+}
+
+void normalizeHistogram(const uint32_t* counts, size_t size, size_t totalPixels, float* out) {
+    const float total = static_cast<float>(totalPixels);
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = total > 0 ? static_cast<float>(counts[i]) / total : static_cast<float>(counts[i]);
+    }
+}
@@ -0,0 +1,69 @@
+// src/core/Histogram.h
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Implementações disponíveis do kernel de histograma de cores.
+ */
+enum class HistogramKernel {
+    Reference, // laço original: três divisões por pixel
+    Scalar,    // tabelas de consulta e sub-histogramas
+    SSSE3,     // índices calculados 4 pixels por vez
+    AVX2,      // índices calculados 8 pixels por vez
+    Auto       // melhor kernel suportado pela CPU
+};
+
+/**
+ * @brief Constantes de compilação do histograma com `Bins` bins por canal.
+ * Especializações disponíveis: 2, 4, 8 e 16 (8, 64, 512 e 4096 dimensões).
+ */
+template <int Bins>
+struct HistogramLayout {
+    static_assert(Bins == 2 || Bins == 4 || Bins == 8 || Bins == 16,
+                  "bins por canal especializados: 2, 4, 8 ou 16");
+    static constexpr int kBits = Bins == 2 ? 1 : Bins == 4 ? 2 : Bins == 8 ? 3 : 4;
+    static constexpr int kShift = 8 - kBits;
+    static constexpr size_t kSize = static_cast<size_t>(Bins) * Bins * Bins;
+};
+
+/**
+ * @brief Acumula o histograma RGB de `pixelCount` pixels intercalados (RGBRGB...).
+ *
+ * `counts` deve ter bins^3 posições e é zerado pela função. Para 2, 4, 8 e 16
+ * bins a chamada é despachada para computeColorHistogram<Bins>; os demais
+ * tamanhos usam tabelas de consulta por canal e sempre o kernel escalar.
+ */
+void computeColorHistogram(const unsigned char* rgb, size_t pixelCount, int binsPerChannel,
+                           uint32_t* counts, HistogramKernel kernel = HistogramKernel::Auto);
+
+/**
+ * @brief Versão especializada em tempo de compilação: índices só com
+ * deslocamentos constantes e sub-histogramas de tamanho fixo na pilha.
+ * `counts` deve ter HistogramLayout<Bins>::kSize posições.
+ */
+template <int Bins>
+void computeColorHistogram(const unsigned char* rgb, size_t pixelCount, uint32_t* counts,
+                           HistogramKernel kernel = HistogramKernel::Auto);
+
+/**
+ * @brief Converte contagens inteiras em frequências relativas (soma 1).
+ */
+void normalizeHistogram(const uint32_t* counts, size_t size, size_t totalPixels, float* out);
+
+/**
+ * @brief Indica se o kernel pode ser executado na CPU atual.
+ */
+bool isHistogramKernelSupported(HistogramKernel kernel);
+
+/**
+ * @brief Kernel escolhido por HistogramKernel::Auto.
+ */
+HistogramKernel bestHistogramKernel();
+
+const char* histogramKernelName(HistogramKernel kernel);
+
+#endif // HISTOGRAM_H
@@ -2,50 +2,466 @@
 
 #include "Image.h"
 #include "Vector.h"
+#include "Histogram.h"
+#include "JpegDecoder.h"
+#include "DecodeArena.h"
+#include "MappedFile.h"
+#include "ReadAhead.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 
+// Todas as alocações do stb_image passam pela arena da thread
+#define STBI_MALLOC(size) DecodeArena::local().allocate(size)
+#define STBI_REALLOC(ptr, size) DecodeArena::local().reallocate(ptr, size)
+#define STBI_FREE(ptr) DecodeArena::local().release(ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-FeatureVector extractFeatures(const std::string& image_path, int bins_per_channel) {
-    int width, height, channels;
-    unsigned char *image_data = stbi_load(image_path.c_str(), &width, &height, &channels, 3);
+namespace {
 
-    if (image_data == nullptr) {
-        throw std::runtime_error("Falha ao carregar a imagem: " + image_path);
+// Chama visit(x, y, pixel) para cada pixel escolhido pelo padrão de amostragem
+// (com stride 1 e Grid, todos os pixels em ordem de varredura)
+template <typename Visit>
+void forEachSample(const unsigned char* image_data, int width, int height, int stride,
+                   SamplingPattern pattern, Visit&& visit) {
+    if (pattern == SamplingPattern::Grid) {
+        for (int y = std::min(stride / 2, height - 1); y < height; y += stride) {
+            const unsigned char* row = image_data + static_cast<size_t>(y) * width * 3;
+            for (int x = std::min(stride / 2, width - 1); x < width; x += stride) {
+                visit(x, y, row + x * 3);
+            }
+        }
+        return;
     }
 
-    int histogram_size = bins_per_channel * bins_per_channel * bins_per_channel;
-    FeatureVector histogram(histogram_size, 0.0f);
+    // Sequência R2 (Roberts): baixa discrepância em 2D, sem os padrões de
+    // aliasing que a grade regular pode ter em texturas periódicas
+    const double g = 1.32471795724474602596;
+    const double a1 = 1.0 / g;
+    const double a2 = 1.0 / (g * g);
+    const size_t samples = std::max<size_t>(1, static_cast<size_t>(width) * height /
+                                                   (static_cast<size_t>(stride) * stride));
+    for (size_t k = 0; k < samples; ++k) {
+        double u = 0.5 + a1 * k;
+        double v = 0.5 + a2 * k;
+        u -= std::floor(u);
+        v -= std::floor(v);
+        const int x = static_cast<int>(u * width);
+        const int y = static_cast<int>(v * height);
+        visit(x, y, image_data + (static_cast<size_t>(y) * width + x) * 3);
+    }
+}
 
-    int bin_size = 256 / bins_per_channel;
+// Copia para `out` os pixels escolhidos pelo padrão de amostragem
+void samplePixels(const unsigned char* image_data, int width, int height, int stride,
+                  SamplingPattern pattern, std::vector<unsigned char>& out) {
+    out.reserve(static_cast<size_t>(width) * height * 3 / (static_cast<size_t>(stride) * stride) + 3);
+    forEachSample(image_data, width, height, stride, pattern,
+                  [&out](int, int, const unsigned char* p) { out.insert(out.end(), p, p + 3); });
+}
 
-    for (int i = 0; i < width * height; ++i) {
-        int r = image_data[i * 3 + 0];
-        int g = image_data[i * 3 + 1];
-        int b = image_data[i * 3 + 2];
+// Imagem decodificada em RGB intercalado; os pixels ficam na arena ou em um
+// buffer thread_local e valem até a próxima imagem processada pela mesma thread.
+struct DecodedImage {
+    const unsigned char* pixels;
+    int width;
+    int height;
+};
 
-        int r_bin = r / bin_size;
-        int g_bin = g / bin_size;
-        int b_bin = b / bin_size;
+// Arquivo comprimido mapeado em memória (não copiado) enquanto o objeto existir.
+// Reaproveita o MappedFile da thread, cujo buffer é mantido quando não há mmap.
+class ScopedMapping {
+public:
+    explicit ScopedMapping(const std::string& path) : file_(threadFile()) {
+        if (!file_.open(path)) {
+            throw std::runtime_error("Falha ao carregar a imagem: " + path);
+        }
+    }
+    ~ScopedMapping() { file_.close(); }
 
-        int bin_index = r_bin * bins_per_channel * bins_per_channel + g_bin * bins_per_channel + b_bin;
+    ScopedMapping(const ScopedMapping&) = delete;
+    ScopedMapping& operator=(const ScopedMapping&) = delete;
 
-        if (bin_index < histogram_size) {
-            histogram[bin_index]++;
-        }
+    const unsigned char* data() const { return file_.data(); }
+    size_t size() const { return file_.size(); }
+
+private:
+    MappedFile& file_;
+
+    static MappedFile& threadFile() {
+        thread_local MappedFile file;
+        return file;
+    }
+};
+
+// Arquivo comprimido em memória (mapeado ou já lido) e o nome usado nas mensagens de erro
+struct EncodedImage {
+    const unsigned char* data;
+    size_t size;
+    const std::string& name;
+};
+
+DecodedImage decodeImage(const EncodedImage& encoded, int jpeg_scale) {
+    // Buffer reaproveitado entre as imagens processadas pela mesma thread
+    thread_local std::vector<unsigned char> scaled;
+
+    // A saída do stb_image vai para a arena da thread, reiniciada a cada imagem
+    // (por isso não há stbi_image_free: o buffer é recuperado no próximo reset)
+    DecodeArena::local().reset();
+
+    DecodedImage image = {nullptr, 0, 0};
+    int channels;
+
+    // Caminho rápido: JPEG em 1/2, 1/4 ou 1/8 da resolução, sem a IDCT completa
+    if (jpeg_scale > 1 && isJpeg(encoded.data, encoded.size) &&
+        decodeJpegScaled(encoded.data, encoded.size, jpeg_scale, scaled, image.width, image.height)) {
+        image.pixels = scaled.data();
+    } else if (encoded.data != nullptr) {
+        image.pixels = stbi_load_from_memory(encoded.data, static_cast<int>(encoded.size),
+                                             &image.width, &image.height, &channels, 3);
+    }
+
+    if (image.pixels == nullptr) {
+        throw std::runtime_error("Falha ao carregar a imagem: " + encoded.name);
     }
+    return image;
+}
 
-    stbi_image_free(image_data);
+// Pixels prontos para o histograma. Apontam para a arena ou para buffers
+// thread_local e valem até a próxima imagem processada pela mesma thread.
+struct PixelSource {
+    const unsigned char* pixels;
+    size_t count; // pixels usados (após a amostragem)
+    size_t total; // pixels da imagem decodificada
+};
+
+PixelSource decodePixels(const EncodedImage& encoded, const ExtractionOptions& options) {
+    thread_local std::vector<unsigned char> samples;
+
+    const DecodedImage image = decodeImage(encoded, options.jpeg_scale);
+    const unsigned char* image_data = image.pixels;
+    const int width = image.width, height = image.height;
+
+    PixelSource source;
+    source.total = static_cast<size_t>(width) * height;
+
+    if (options.sample_stride > 1) {
+        samples.clear();
+        samplePixels(image_data, width, height, options.sample_stride, options.sampling_pattern, samples);
+        source.pixels = samples.data();
+        source.count = samples.size() / 3;
+    } else {
+        source.pixels = image_data;
+        source.count = source.total;
+    }
+    return source;
+}
 
+// Índice HSV (h * bins² + s * bins + v) em aritmética inteira. A volta
+// completa da matiz vale 6 * delta, então h ∈ [0, 6 * delta).
+inline uint32_t hsvIndex(const unsigned char* p, int bins) {
+    const int r = p[0], g = p[1], b = p[2];
+    const int max = std::max(r, std::max(g, b));
+    const int min = std::min(r, std::min(g, b));
+    const int delta = max - min;
 
-    float total_pixels = width * height;
-    if (total_pixels > 0) {
-        for (float& val : histogram) {
-            val /= total_pixels;
+    const int vBin = (max * bins) >> 8;
+    int sBin = 0, hBin = 0;
+    if (delta > 0) {
+        sBin = std::min(bins - 1, delta * bins / max);
+        int h;
+        if (max == r) h = g - b;
+        else if (max == g) h = 2 * delta + b - r;
+        else h = 4 * delta + r - g;
+        if (h < 0) h += 6 * delta;
+        hBin = h * bins / (6 * delta);
+    }
+    return static_cast<uint32_t>((hBin * bins + sBin) * bins + vBin);
+}
+
+// Tabelas por canal do índice RGB com `bins` bins; posições fora do
+// histograma (bins que não dividem 256) recebem `invalid`, como no laço original
+void buildRgbLut(int bins, uint32_t invalid, uint32_t lut[3][256]) {
+    const int binSize = 256 / bins;
+    for (int v = 0; v < 256; ++v) {
+        const int bin = v / binSize;
+        const bool valid = bin < bins;
+        lut[0][v] = valid ? static_cast<uint32_t>(bin * bins * bins) : invalid;
+        lut[1][v] = valid ? static_cast<uint32_t>(bin * bins) : invalid;
+        lut[2][v] = valid ? static_cast<uint32_t>(bin) : invalid;
+    }
+}
+
+// Decodifica uma vez e distribui cada pixel amostrado entre os acumuladores
+// ativos (RGB global, HSV e a célula da grade correspondente)
+void extractDescriptors(const EncodedImage& encoded, const ExtractionOptions& options,
+                        float* out, double* error_bound) {
+    thread_local std::vector<uint32_t> counts;
+    thread_local std::vector<uint32_t> cellPixels;
+    thread_local std::vector<uint32_t> cellOfColumn;
+    thread_local std::vector<uint32_t> cellOfRow;
+
+    const FeatureLayout layout = featureLayout(options);
+    const DecodedImage image = decodeImage(encoded, options.jpeg_scale);
+
+    counts.assign(layout.dimension, 0);
+    cellPixels.assign(layout.grid_cells, 0);
+
+    // Um valor acima de qualquer índice válido marca bins descartados
+    const uint32_t invalid = 1u << 30;
+    uint32_t rgbLut[3][256];
+    uint32_t gridLut[3][256];
+    if (layout.rgb_size) buildRgbLut(options.bins_per_channel, invalid, rgbLut);
+    if (layout.grid_cells) {
+        buildRgbLut(options.grid_bins, invalid, gridLut);
+        const uint32_t n = static_cast<uint32_t>(options.grid_size);
+        cellOfColumn.resize(image.width);
+        cellOfRow.resize(image.height);
+        for (int x = 0; x < image.width; ++x) cellOfColumn[x] = static_cast<uint32_t>(static_cast<uint64_t>(x) * n / image.width);
+        for (int y = 0; y < image.height; ++y) cellOfRow[y] = static_cast<uint32_t>(static_cast<uint64_t>(y) * n / image.height) * n;
+    }
+
+    uint32_t* rgbCounts = counts.data() + layout.rgb_offset;
+    uint32_t* hsvCounts = counts.data() + layout.hsv_offset;
+    uint32_t* gridCounts = counts.data() + layout.grid_offset;
+    const uint32_t rgbSize = static_cast<uint32_t>(layout.rgb_size);
+    const uint32_t cellSize = static_cast<uint32_t>(layout.grid_cell_size);
+    const bool rgb = layout.rgb_size > 0;
+    const bool hsv = layout.hsv_size > 0;
+    const bool grid = layout.grid_cells > 0;
+    const int hsvBins = options.hsv_bins;
+    size_t used = 0;
+
+    forEachSample(image.pixels, image.width, image.height, options.sample_stride, options.sampling_pattern,
+                  [&](int x, int y, const unsigned char* p) {
+        ++used;
+        if (rgb) {
+            const uint32_t index = rgbLut[0][p[0]] + rgbLut[1][p[1]] + rgbLut[2][p[2]];
+            if (index < rgbSize) rgbCounts[index]++;
         }
+        if (hsv) {
+            hsvCounts[hsvIndex(p, hsvBins)]++;
+        }
+        if (grid) {
+            const uint32_t cell = cellOfRow[y] + cellOfColumn[x];
+            const uint32_t index = gridLut[0][p[0]] + gridLut[1][p[1]] + gridLut[2][p[2]];
+            cellPixels[cell]++;
+            if (index < cellSize) gridCounts[static_cast<size_t>(cell) * cellSize + index]++;
+        }
+    });
+
+    if (rgb) normalizeHistogram(rgbCounts, layout.rgb_size, used, out + layout.rgb_offset);
+    if (hsv) normalizeHistogram(hsvCounts, layout.hsv_size, used, out + layout.hsv_offset);
+    for (size_t cell = 0; cell < layout.grid_cells; ++cell) {
+        const size_t offset = cell * layout.grid_cell_size;
+        normalizeHistogram(gridCounts + offset, layout.grid_cell_size, cellPixels[cell],
+                           out + layout.grid_offset + offset);
+    }
+
+    if (error_bound) {
+        *error_bound = samplingErrorBound(used, static_cast<size_t>(image.width) * image.height);
     }
+}
 
+template <int Bins>
+void extractRgbHistogram(const EncodedImage& encoded, const ExtractionOptions& options,
+                         float* out, double* error_bound) {
+    using Layout = HistogramLayout<Bins>;
+
+    const PixelSource source = decodePixels(encoded, options);
+
+    uint32_t counts[Layout::kSize];
+    computeColorHistogram<Bins>(source.pixels, source.count, counts);
+    normalizeHistogram(counts, Layout::kSize, source.count, out);
+
+    if (error_bound) {
+        *error_bound = samplingErrorBound(source.count, source.total);
+    }
+}
+
+// Número de bins sem especialização: histograma com tamanho em tempo de execução
+void extractRgbHistogram(const EncodedImage& encoded, const ExtractionOptions& options,
+                         float* out, double* error_bound) {
+    thread_local std::vector<uint32_t> counts;
+
+    const int bins_per_channel = options.bins_per_channel;
+    const size_t histogram_size = static_cast<size_t>(bins_per_channel) * bins_per_channel * bins_per_channel;
+    const PixelSource source = decodePixels(encoded, options);
+
+    counts.resize(histogram_size);
+    computeColorHistogram(source.pixels, source.count, bins_per_channel, counts.data());
+    normalizeHistogram(counts.data(), histogram_size, source.count, out);
+
+    if (error_bound) {
+        *error_bound = samplingErrorBound(source.count, source.total);
+    }
+}
+
+} // namespace
+
+FeatureVector extractFeatures(const std::string& image_path, int bins_per_channel,
+                              int sample_stride, SamplingPattern pattern, double* error_bound) {
+    ExtractionOptions options;
+    options.bins_per_channel = bins_per_channel;
+    options.sample_stride = sample_stride;
+    options.sampling_pattern = pattern;
+    return extractFeatures(image_path, options, error_bound);
+}
+
+template <int Bins>
+FeatureVector extractFeatures(const std::string& image_path, const ExtractionOptions& options,
+                              double* error_bound) {
+    const ScopedMapping file(image_path);
+
+    FeatureVector histogram(HistogramLayout<Bins>::kSize, 0.0f);
+    extractRgbHistogram<Bins>({file.data(), file.size(), image_path}, options, histogram.data(), error_bound);
     return histogram;
-}
\ No newline at end of file
+}
+
+template FeatureVector extractFeatures<2>(const std::string&, const ExtractionOptions&, double*);
+template FeatureVector extractFeatures<4>(const std::string&, const ExtractionOptions&, double*);
+template FeatureVector extractFeatures<8>(const std::string&, const ExtractionOptions&, double*);
+template FeatureVector extractFeatures<16>(const std::string&, const ExtractionOptions&, double*);
+
+FeatureVector extractFeatures(const std::string& image_path, const ExtractionOptions& options,
+                              double* error_bound) {
+    FeatureVector features(featureLayout(options).dimension, 0.0f);
+    extractFeaturesInto(image_path, options, features.data(), error_bound);
+    return features;
+}
+
+void extractFeaturesFromMemory(const unsigned char* data, size_t size, const std::string& name,
+                               const ExtractionOptions& options, float* out, double* error_bound) {
+    const EncodedImage encoded = {data, size, name};
+
+    if (!options.rgb_histogram || options.hsv_bins > 0 || options.grid_size > 0) {
+        extractDescriptors(encoded, options, out, error_bound);
+        return;
+    }
+
+    switch (options.bins_per_channel) {
+        case 2: extractRgbHistogram<2>(encoded, options, out, error_bound); break;
+        case 4: extractRgbHistogram<4>(encoded, options, out, error_bound); break;
+        case 8: extractRgbHistogram<8>(encoded, options, out, error_bound); break;
+        case 16: extractRgbHistogram<16>(encoded, options, out, error_bound); break;
+        default: extractRgbHistogram(encoded, options, out, error_bound); break;
+    }
+}
+
+void extractFeaturesInto(const std::string& image_path, const ExtractionOptions& options,
+                         float* out, double* error_bound) {
+    const ScopedMapping file(image_path);
+    extractFeaturesFromMemory(file.data(), file.size(), image_path, options, out, error_bound);
+}
+
+void extractFeaturesBatch(const std::vector<std::string>& paths, const ExtractionOptions& options,
+                          FeatureMatrix& matrix, std::vector<ExtractionRecord>& records, ThreadPool* pool,
+                          size_t read_ahead) {
+    matrix.resize(paths.size(), featureLayout(options).dimension);
+    records.assign(paths.size(), ExtractionRecord());
+
+    // Extrai a linha i com `extract`; uma falha zera a linha e não interrompe o lote
+    auto runRow = [&](size_t i, auto&& extract) {
+        ExtractionRecord& record = records[i];
+        Timer timer;
+        try {
+            extract(matrix.row(i), &record.error_bound);
+            record.ok = true;
+        } catch (const std::exception& e) {
+            std::fill(matrix.row(i), matrix.row(i) + matrix.cols(), 0.0f);
+            record.error = e.what();
+        }
+        record.time_ms = timer.elapsed_milliseconds();
+    };
+
+    auto forEachRow = [&](auto&& body) {
+        if (pool) {
+            pool->parallelFor(paths.size(), body);
+        } else {
+            for (size_t i = 0; i < paths.size(); ++i) body(i);
+        }
+    };
+
+    if (read_ahead == 0 || paths.empty()) {
+        forEachRow([&](size_t i) {
+            runRow(i, [&](float* out, double* bound) { extractFeaturesInto(paths[i], options, out, bound); });
+        });
+        return;
+    }
+
+    // Cada tarefa decodifica o próximo arquivo já lido pelo estágio de leitura,
+    // em qualquer ordem; a linha de destino vem de File::index
+    ReadAhead reader(paths, read_ahead);
+    forEachRow([&](size_t) {
+        ReadAhead::File file;
+        if (!reader.next(file)) return;
+        runRow(file.index, [&](float* out, double* bound) {
+            extractFeaturesFromMemory(file.data, file.size, paths[file.index], options, out, bound);
+        });
+        reader.release(file);
+    });
+}
+
+double samplingErrorBound(size_t sampled_pixels, size_t total_pixels) {
+    if (sampled_pixels == 0) return 1.0;
+    if (sampled_pixels >= total_pixels) return 0.0;
+    return 1.0 / std::sqrt(static_cast<double>(sampled_pixels));
+}
+
+FeatureLayout featureLayout(const ExtractionOptions& options) {
+    if (options.bins_per_channel < 1 || options.hsv_bins < 0 || options.grid_size < 0 ||
+        (options.grid_size > 0 && options.grid_bins < 1)) {
+        throw std::invalid_argument("Parâmetros de descritores inválidos");
+    }
+
+    FeatureLayout layout;
+    layout.version = FEATURE_LAYOUT_VERSION;
+
+    const size_t rgbBins = options.rgb_histogram ? static_cast<size_t>(options.bins_per_channel) : 0;
+    const size_t hsvBins = static_cast<size_t>(options.hsv_bins);
+    const size_t gridBins = options.grid_size > 0 ? static_cast<size_t>(options.grid_bins) : 0;
+
+    layout.rgb_offset = 0;
+    layout.rgb_size = rgbBins * rgbBins * rgbBins;
+    layout.hsv_offset = layout.rgb_offset + layout.rgb_size;
+    layout.hsv_size = hsvBins * hsvBins * hsvBins;
+    layout.grid_offset = layout.hsv_offset + layout.hsv_size;
+    layout.grid_cells = static_cast<size_t>(options.grid_size) * options.grid_size;
+    layout.grid_cell_size = gridBins * gridBins * gridBins;
+    layout.dimension = layout.grid_offset + layout.grid_cells * layout.grid_cell_size;
+
+    if (layout.dimension == 0) {
+        throw std::invalid_argument("Nenhum descritor selecionado");
+    }
+    return layout;
+}
+
+uint64_t extractionConfigKey(const ExtractionOptions& options) {
+    uint64_t key = static_cast<uint64_t>(options.bins_per_channel) |
+                   (static_cast<uint64_t>(options.sample_stride) << 16) |
+                   (static_cast<uint64_t>(options.jpeg_scale) << 40) |
+                   (static_cast<uint64_t>(options.sampling_pattern) << 48);
+
+    // Só o histograma RGB: a chave é a mesma de antes dos descritores múltiplos,
+    // então os caches já gravados continuam válidos
+    if (options.rgb_histogram && options.hsv_bins == 0 && options.grid_size == 0) {
+        return key;
+    }
+
+    // Demais combinações: mistura (FNV-1a) a versão do layout e os descritores
+    const uint64_t fields[] = {FEATURE_LAYOUT_VERSION, options.rgb_histogram ? 1u : 0u,
+                               static_cast<uint64_t>(options.hsv_bins),
+                               static_cast<uint64_t>(options.grid_size),
+                               static_cast<uint64_t>(options.grid_bins)};
+    uint64_t hash = 1469598103934665603ull;
+    for (uint64_t field : fields) {
+        hash ^= field;
+        hash *= 1099511628211ull;
+    }
+    return key ^ hash;
+}
@@ -4,11 +4,154 @@
 #define IMAGE_H
 
 #include "Vector.h" // Precisa saber o que é FeatureVector
+#include "FeatureMatrix.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief Padrão usado para escolher os pixels amostrados quando sample_stride > 1.
+ */
+enum class SamplingPattern {
+    Grid,        // um pixel a cada sample_stride linhas e colunas
+    QuasiRandom  // mesma quantidade de pixels, espalhados pela sequência R2 (determinística)
+};
+
+/**
+ * @brief Versão do layout do vetor de características com vários descritores.
+ * Deve ser incrementada sempre que a ordem ou a normalização dos blocos mudar.
+ */
+const uint32_t FEATURE_LAYOUT_VERSION = 1;
+
+/**
+ * @brief Parâmetros da extração de características.
+ *
+ * O padrão (apenas o histograma RGB) produz o mesmo vetor de sempre. Ativar
+ * hsv_bins ou grid_size acrescenta descritores calculados na mesma passada
+ * sobre os pixels decodificados; veja FeatureLayout.
+ */
+struct ExtractionOptions {
+    int bins_per_channel = 4;
+    int sample_stride = 1;  // 1 = todos os pixels
+    SamplingPattern sampling_pattern = SamplingPattern::Grid;
+    int jpeg_scale = 1;     // 1 (completo), 2, 4 ou 8 (apenas coeficientes DC)
+
+    bool rgb_histogram = true; // histograma RGB global (bins_per_channel³)
+    int hsv_bins = 0;          // histograma HSV com hsv_bins³ posições (0 = desligado)
+    int grid_size = 0;         // histogramas RGB por célula em uma grade NxN (0 = desligado)
+    int grid_bins = 2;         // bins por canal de cada célula da grade
+};
+
+/**
+ * @brief Posição de cada descritor no vetor concatenado.
+ *
+ * Ordem: RGB global, HSV, células da grade (linha a linha, de cima para
+ * baixo). Cada bloco é normalizado separadamente (soma 1; cada célula pela
+ * quantidade de pixels dela). Blocos desligados têm tamanho 0.
+ */
+struct FeatureLayout {
+    uint32_t version;
+    size_t rgb_offset, rgb_size;
+    size_t hsv_offset, hsv_size;
+    size_t grid_offset, grid_cells, grid_cell_size;
+    size_t dimension;
+};
+
+FeatureLayout featureLayout(const ExtractionOptions& options);
 
 /**
  * @brief Extrai um vetor de características (histograma de cores) de uma imagem.
  */
-FeatureVector extractFeatures(const std::string& image_path, int bins_per_channel = 4);
+FeatureVector extractFeatures(const std::string& image_path, int bins_per_channel = 4,
+                              int sample_stride = 1,
+                              SamplingPattern pattern = SamplingPattern::Grid,
+                              double* error_bound = nullptr);
+
+/**
+ * @brief Extrai o histograma de cores segundo `options`.
+ *
+ * Com jpeg_scale > 1, arquivos JPEG baseline são decodificados em resolução
+ * reduzida (veja decodeJpegScaled); PNG e JPEGs não suportados usam o
+ * decodificador completo (stb_image).
+ *
+ * Com hsv_bins ou grid_size ativos, a imagem é decodificada uma vez e todos os
+ * descritores são acumulados na mesma passada (layout em FeatureLayout).
+ *
+ * Com sample_stride > 1 o histograma é estimado com cerca de 1/sample_stride² dos
+ * pixels. Se error_bound não for nulo, recebe o limite do erro esperado
+ * (distância euclidiana RMS) em relação ao histograma completo; veja samplingErrorBound.
+ */
+FeatureVector extractFeatures(const std::string& image_path, const ExtractionOptions& options,
+                              double* error_bound = nullptr);
+
+/**
+ * @brief Como extractFeatures, mas escreve featureLayout(options).dimension
+ * floats em `out` em vez de alocar um vetor novo.
+ */
+void extractFeaturesInto(const std::string& image_path, const ExtractionOptions& options,
+                         float* out, double* error_bound = nullptr);
+
+/**
+ * @brief Extrai as características de um arquivo já carregado em memória
+ * (JPEG ou PNG). `name` só é usado nas mensagens de erro.
+ */
+void extractFeaturesFromMemory(const unsigned char* data, size_t size, const std::string& name,
+                               const ExtractionOptions& options, float* out, double* error_bound = nullptr);
+
+/**
+ * @brief Resultado da extração de uma linha de extractFeaturesBatch.
+ */
+struct ExtractionRecord {
+    bool ok = false;
+    double time_ms = 0.0;
+    double error_bound = 0.0;
+    std::string error; // mensagem da falha (vazia se ok)
+};
+
+/**
+ * @brief Extrai as características de várias imagens direto para uma matriz.
+ *
+ * `matrix` é redimensionada para paths.size() linhas de
+ * featureLayout(options).dimension colunas e a linha i recebe a imagem
+ * paths[i]. Falhas não interrompem o lote: a linha fica zerada e
+ * records[i].error guarda a mensagem. Com `pool`, as linhas são extraídas em
+ * paralelo.
+ *
+ * Com read_ahead > 0, os arquivos são lidos por um estágio ReadAhead com
+ * `read_ahead` buffers, à frente dos decodificadores; nesse caso time_ms mede
+ * só a decodificação e o histograma. Com 0, cada thread mapeia o seu arquivo.
+ */
+void extractFeaturesBatch(const std::vector<std::string>& paths, const ExtractionOptions& options,
+                          FeatureMatrix& matrix, std::vector<ExtractionRecord>& records,
+                          ThreadPool* pool = nullptr, size_t read_ahead = 0);
+
+/**
+ * @brief Versão especializada para `Bins` bins por canal (2, 4, 8 ou 16).
+ *
+ * O tamanho do histograma e os deslocamentos do índice são constantes de
+ * compilação e os contadores ficam na pilha. Produz apenas o histograma RGB
+ * (options.bins_per_channel e os demais descritores são ignorados); a versão
+ * não-template despacha para esta quando possível.
+ */
+template <int Bins>
+FeatureVector extractFeatures(const std::string& image_path, const ExtractionOptions& options,
+                              double* error_bound = nullptr);
+
+/**
+ * @brief Limite do erro do histograma estimado com `sampled_pixels` amostras.
+ *
+ * Para amostras uniformes, E[||h' - h||²] = Σ p(1 - p) / n <= 1 / n, então a
+ * distância euclidiana RMS até o histograma completo é no máximo 1/sqrt(n).
+ * Retorna 0 quando todos os pixels foram usados.
+ */
+double samplingErrorBound(size_t sampled_pixels, size_t total_pixels);
+
+/**
+ * @brief Chave que identifica os parâmetros de extração (usada pelo cache em disco).
+ */
+uint64_t extractionConfigKey(const ExtractionOptions& options);
 
-#endif // IMAGE_H
\ No newline at end of file
+#endif // IMAGE_H
@@ -0,0 +1,579 @@
+// src/core/JpegDecoder.cpp
+
+#include "JpegDecoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+// Posição natural (linha * 8 + coluna) do k-ésimo coeficiente em zigue-zague
+const uint8_t kZigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+const int kFastBits = 9;
+
+struct HuffmanTable {
+    bool defined = false;
+    uint16_t fast[1 << kFastBits]; // (comprimento << 8) | símbolo; 0 = código longo
+    // Tabelas AC: decodifica código + valor de uma vez quando ambos cabem em
+    // kFastBits bits: (valor << 16) | (run << 8) | bits consumidos; 0 = caminho normal
+    int32_t fastAc[1 << kFastBits];
+    int32_t maxCode[17];
+    int32_t minCode[17];
+    int32_t valPtr[17];
+    uint8_t values[256];
+
+    bool build(const uint8_t* counts, const uint8_t* symbols, int numSymbols) {
+        std::memset(fast, 0, sizeof(fast));
+        std::memcpy(values, symbols, numSymbols);
+
+        int code = 0, k = 0;
+        for (int len = 1; len <= 16; ++len) {
+            valPtr[len] = k;
+            minCode[len] = code;
+            for (int i = 0; i < counts[len - 1]; ++i, ++k, ++code) {
+                if (len <= kFastBits) {
+                    int first = code << (kFastBits - len);
+                    int last = (code + 1) << (kFastBits - len);
+                    for (int f = first; f < last; ++f) {
+                        fast[f] = static_cast<uint16_t>((len << 8) | values[k]);
+                    }
+                }
+            }
+            maxCode[len] = counts[len - 1] ? code - 1 : -1;
+            if (code > (1 << len)) return false; // tabela inválida
+            code <<= 1;
+        }
+        buildFastAc();
+        defined = true;
+        return true;
+    }
+
+    void buildFastAc() {
+        for (int p = 0; p < (1 << kFastBits); ++p) {
+            fastAc[p] = 0;
+            if (!fast[p]) continue;
+            int len = fast[p] >> 8;
+            int rs = fast[p] & 0xFF;
+            int run = rs >> 4, size = rs & 15;
+            if (size == 0 || len + size > kFastBits) continue;
+            int value = (p >> (kFastBits - len - size)) & ((1 << size) - 1);
+            if (value < (1 << (size - 1))) value -= (1 << size) - 1;
+            fastAc[p] = static_cast<int32_t>(static_cast<uint32_t>(value) << 16) | (run << 8) | (len + size);
+        }
+    }
+};
+
+struct QuantTable {
+    bool defined = false;
+    uint16_t q[64]; // em ordem zigue-zague, como no arquivo
+};
+
+struct Component {
+    int id;
+    int h, v;
+    int tq, td, ta;
+    int dcPred;
+    int planeW, planeH;
+    uint8_t* plane; // amostras já na resolução reduzida
+};
+
+// Leitor de bits do segmento entrópico (trata byte stuffing 0xFF00 e para nos marcadores)
+class BitReader {
+public:
+    BitReader(const uint8_t* p, const uint8_t* end) : p_(p), end_(end), buf_(0), bits_(0), marker_(false) {}
+
+    void fill() {
+        while (bits_ <= 56) {
+            uint32_t b = 0;
+            if (!marker_ && p_ < end_) {
+                b = *p_;
+                if (b == 0xFF) {
+                    uint32_t next = (p_ + 1 < end_) ? p_[1] : 0;
+                    if (next == 0x00) {
+                        p_ += 2;
+                    } else {
+                        marker_ = true; // alimenta zeros até o restart/EOI
+                        b = 0;
+                    }
+                } else {
+                    ++p_;
+                }
+            }
+            buf_ |= static_cast<uint64_t>(b) << (56 - bits_);
+            bits_ += 8;
+        }
+    }
+
+    // Garante pelo menos n bits no buffer (recarrega ~7 bytes de uma vez)
+    void ensure(int n) {
+        if (bits_ < n) fill();
+    }
+
+    uint32_t peek(int n) const { return static_cast<uint32_t>(buf_ >> (64 - n)); }
+    void skip(int n) { buf_ <<= n; bits_ -= n; }
+
+    int decode(const HuffmanTable& t) {
+        ensure(16);
+        uint16_t e = t.fast[peek(kFastBits)];
+        if (e) {
+            skip(e >> 8);
+            return e & 0xFF;
+        }
+        for (int len = kFastBits + 1; len <= 16; ++len) {
+            int32_t code = static_cast<int32_t>(peek(len));
+            if (code <= t.maxCode[len]) {
+                skip(len);
+                return t.values[t.valPtr[len] + code - t.minCode[len]];
+            }
+        }
+        return -1;
+    }
+
+    int receiveExtend(int s) {
+        if (s == 0) return 0;
+        ensure(s);
+        int v = static_cast<int>(peek(s));
+        skip(s);
+        if (v < (1 << (s - 1))) v -= (1 << s) - 1;
+        return v;
+    }
+
+    // Descarta os bits restantes e consome o próximo marcador RSTn
+    bool restart() {
+        buf_ = 0;
+        bits_ = 0;
+        marker_ = false;
+        while (p_ + 1 < end_ && !(p_[0] == 0xFF && (p_[1] & 0xF8) == 0xD0)) ++p_;
+        if (p_ + 1 >= end_) return false;
+        p_ += 2;
+        return true;
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    uint64_t buf_;
+    int bits_;
+    bool marker_;
+};
+
+/**
+ * Base da IDCT reduzida: basis[x][u] é a média de C(u)/2 * cos((2i + 1)uπ/16)
+ * sobre os 8/n pixels originais que formam o pixel reduzido x. Assim cada
+ * amostra reduzida aproxima a média da caixa correspondente da imagem completa.
+ */
+struct ReducedBasis {
+    float basis[4][4];
+
+    explicit ReducedBasis(int n) {
+        const double pi = 3.14159265358979323846;
+        const int span = 8 / n;
+        for (int x = 0; x < n; ++x) {
+            for (int u = 0; u < n; ++u) {
+                double sum = 0.0;
+                for (int j = 0; j < span; ++j) {
+                    int i = x * span + j;
+                    sum += std::cos((2 * i + 1) * u * pi / 16.0);
+                }
+                double cu = (u == 0) ? 1.0 / std::sqrt(2.0) : 1.0;
+                basis[x][u] = static_cast<float>(cu / 2.0 * sum / span);
+            }
+        }
+    }
+};
+
+// Planos de amostras reaproveitados entre as decodificações da mesma thread
+std::vector<uint8_t>& planeStorage(int component) {
+    thread_local std::vector<uint8_t> storage[3];
+    return storage[component];
+}
+
+inline uint8_t clampSample(float v) {
+    int i = static_cast<int>(v + 0.5f);
+    return static_cast<uint8_t>(i < 0 ? 0 : (i > 255 ? 255 : i));
+}
+
+class ScaledDecoder {
+public:
+    ScaledDecoder(const uint8_t* data, size_t size, int scale)
+        : data_(data), size_(size), n_(8 / scale), basis_(8 / scale) {}
+
+    bool decode(std::vector<unsigned char>& rgb, int& width, int& height);
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    int n_; // amostras por bloco em cada direção (1, 2 ou 4)
+    ReducedBasis basis_;
+
+    HuffmanTable dcTables_[4];
+    HuffmanTable acTables_[4];
+    QuantTable quant_[4];
+    Component comps_[3];
+    int ncomp_ = 0;
+    int width_ = 0, height_ = 0;
+    int hmax_ = 1, vmax_ = 1;
+    int mcusX_ = 0, mcusY_ = 0;
+    int restartInterval_ = 0;
+    bool frameSeen_ = false;
+    bool adobe_ = false;
+    int adobeTransform_ = 1;
+
+    bool parseSof(const uint8_t* seg, int len);
+    bool parseDht(const uint8_t* seg, int len);
+    bool parseDqt(const uint8_t* seg, int len);
+    bool decodeScan(const uint8_t* seg, int len, const uint8_t* scanData, const uint8_t* end);
+    bool decodeBlock(BitReader& reader, Component& c, int blockX, int blockY);
+    void toRgb(std::vector<unsigned char>& rgb, int& width, int& height) const;
+};
+
+bool ScaledDecoder::parseSof(const uint8_t* seg, int len) {
+    if (len < 6 || seg[0] != 8) return false; // apenas 8 bits por amostra
+    height_ = (seg[1] << 8) | seg[2];
+    width_ = (seg[3] << 8) | seg[4];
+    int ncomp = seg[5];
+    if (width_ == 0 || height_ == 0 || (ncomp != 1 && ncomp != 3) || len < 6 + ncomp * 3) return false;
+
+    ncomp_ = ncomp;
+    for (int i = 0; i < ncomp; ++i) {
+        Component& c = comps_[i];
+        c.id = seg[6 + i * 3];
+        c.h = seg[7 + i * 3] >> 4;
+        c.v = seg[7 + i * 3] & 15;
+        c.tq = seg[8 + i * 3];
+        if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4 || c.tq > 3) return false;
+    }
+
+    // Imagem de um componente: o scan é não-intercalado, um bloco por MCU
+    if (ncomp == 1) {
+        comps_[0].h = comps_[0].v = 1;
+    }
+
+    hmax_ = vmax_ = 1;
+    for (int i = 0; i < ncomp_; ++i) {
+        hmax_ = std::max(hmax_, comps_[i].h);
+        vmax_ = std::max(vmax_, comps_[i].v);
+    }
+    for (int i = 0; i < ncomp_; ++i) {
+        const Component& c = comps_[i];
+        if (hmax_ % c.h != 0 || vmax_ % c.v != 0) return false; // fatores incomuns
+    }
+
+    mcusX_ = (width_ + 8 * hmax_ - 1) / (8 * hmax_);
+    mcusY_ = (height_ + 8 * vmax_ - 1) / (8 * vmax_);
+    for (int i = 0; i < ncomp_; ++i) {
+        Component& c = comps_[i];
+        c.planeW = mcusX_ * c.h * n_;
+        c.planeH = mcusY_ * c.v * n_;
+        std::vector<uint8_t>& storage = planeStorage(i);
+        storage.assign(static_cast<size_t>(c.planeW) * c.planeH, 0);
+        c.plane = storage.data();
+    }
+
+    frameSeen_ = true;
+    return true;
+}
+
+bool ScaledDecoder::parseDht(const uint8_t* seg, int len) {
+    int pos = 0;
+    while (pos < len) {
+        if (pos + 17 > len) return false;
+        int tc = seg[pos] >> 4;
+        int th = seg[pos] & 15;
+        if (tc > 1 || th > 3) return false;
+
+        const uint8_t* counts = seg + pos + 1;
+        int total = 0;
+        for (int i = 0; i < 16; ++i) total += counts[i];
+        if (total > 256 || pos + 17 + total > len) return false;
+
+        HuffmanTable& table = tc == 0 ? dcTables_[th] : acTables_[th];
+        if (!table.build(counts, seg + pos + 17, total)) return false;
+        pos += 17 + total;
+    }
+    return true;
+}
+
+bool ScaledDecoder::parseDqt(const uint8_t* seg, int len) {
+    int pos = 0;
+    while (pos < len) {
+        int pq = seg[pos] >> 4;
+        int tq = seg[pos] & 15;
+        if (tq > 3 || pq > 1) return false;
+        int bytes = pq ? 128 : 64;
+        if (pos + 1 + bytes > len) return false;
+
+        QuantTable& table = quant_[tq];
+        for (int k = 0; k < 64; ++k) {
+            table.q[k] = pq ? static_cast<uint16_t>((seg[pos + 1 + 2 * k] << 8) | seg[pos + 2 + 2 * k])
+                            : seg[pos + 1 + k];
+        }
+        table.defined = true;
+        pos += 1 + bytes;
+    }
+    return true;
+}
+
+bool ScaledDecoder::decodeBlock(BitReader& reader, Component& c, int blockX, int blockY) {
+    const HuffmanTable& dc = dcTables_[c.td];
+    const HuffmanTable& ac = acTables_[c.ta];
+    const uint16_t* q = quant_[c.tq].q;
+    const int n = n_;
+
+    float coeff[4][4] = {};
+
+    int s = reader.decode(dc);
+    if (s < 0 || s > 11) return false;
+    c.dcPred += reader.receiveExtend(s);
+    coeff[0][0] = static_cast<float>(c.dcPred * q[0]);
+
+    // Os AC precisam ser lidos para avançar no fluxo, mas só os de baixa
+    // frequência (linha e coluna < n) entram na IDCT reduzida
+    for (int k = 1; k < 64;) {
+        reader.ensure(16);
+        int32_t fast = ac.fastAc[reader.peek(kFastBits)];
+        if (fast) {
+            reader.skip(fast & 0xFF);
+            k += (fast >> 8) & 15;
+            if (k > 63) return false;
+            int natural = kZigzag[k];
+            if ((natural >> 3) < n && (natural & 7) < n) {
+                coeff[natural >> 3][natural & 7] = static_cast<float>((fast >> 16) * q[k]);
+            }
+            ++k;
+            continue;
+        }
+
+        int rs = reader.decode(ac);
+        if (rs < 0) return false;
+        int r = rs >> 4;
+        s = rs & 15;
+        if (s == 0) {
+            if (r != 15) break; // EOB
+            k += 16;
+            continue;
+        }
+        k += r;
+        if (k > 63) return false;
+        int value = reader.receiveExtend(s);
+        int natural = kZigzag[k];
+        int row = natural >> 3, col = natural & 7;
+        if (row < n && col < n) {
+            coeff[row][col] = static_cast<float>(value * q[k]);
+        }
+        ++k;
+    }
+
+    uint8_t* out = c.plane + static_cast<size_t>(blockY) * n * c.planeW + static_cast<size_t>(blockX) * n;
+
+    if (n == 1) {
+        out[0] = clampSample(coeff[0][0] / 8.0f + 128.0f);
+        return true;
+    }
+
+    // IDCT separável nas linhas e depois nas colunas
+    float tmp[4][4];
+    for (int v = 0; v < n; ++v) {
+        for (int x = 0; x < n; ++x) {
+            float sum = 0.0f;
+            for (int u = 0; u < n; ++u) sum += basis_.basis[x][u] * coeff[v][u];
+            tmp[v][x] = sum;
+        }
+    }
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            float sum = 0.0f;
+            for (int v = 0; v < n; ++v) sum += basis_.basis[y][v] * tmp[v][x];
+            out[static_cast<size_t>(y) * c.planeW + x] = clampSample(sum + 128.0f);
+        }
+    }
+    return true;
+}
+
+bool ScaledDecoder::decodeScan(const uint8_t* seg, int len, const uint8_t* scanData, const uint8_t* end) {
+    if (!frameSeen_ || len < 1) return false;
+    int ns = seg[0];
+    if (ns != ncomp_ || len < 1 + ns * 2 + 3) return false; // scans múltiplos: fallback
+
+    Component* order[3];
+    for (int i = 0; i < ns; ++i) {
+        int id = seg[1 + i * 2];
+        Component* found = nullptr;
+        for (int j = 0; j < ncomp_; ++j) {
+            if (comps_[j].id == id) found = &comps_[j];
+        }
+        if (!found) return false;
+        found->td = seg[2 + i * 2] >> 4;
+        found->ta = seg[2 + i * 2] & 15;
+        if (found->td > 3 || found->ta > 3 || !dcTables_[found->td].defined ||
+            !acTables_[found->ta].defined || !quant_[found->tq].defined) {
+            return false;
+        }
+        found->dcPred = 0;
+        order[i] = found;
+    }
+
+    BitReader reader(scanData, end);
+    int restartsLeft = restartInterval_;
+
+    for (int my = 0; my < mcusY_; ++my) {
+        for (int mx = 0; mx < mcusX_; ++mx) {
+            if (restartInterval_ > 0) {
+                if (restartsLeft == 0) {
+                    if (!reader.restart()) return false;
+                    for (int i = 0; i < ns; ++i) order[i]->dcPred = 0;
+                    restartsLeft = restartInterval_;
+                }
+                --restartsLeft;
+            }
+
+            for (int i = 0; i < ns; ++i) {
+                Component* c = order[i];
+                for (int by = 0; by < c->v; ++by) {
+                    for (int bx = 0; bx < c->h; ++bx) {
+                        if (!decodeBlock(reader, *c, mx * c->h + bx, my * c->v + by)) return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void ScaledDecoder::toRgb(std::vector<unsigned char>& rgb, int& width, int& height) const {
+    const int scale = 8 / n_;
+    width = (width_ + scale - 1) / scale;
+    height = (height_ + scale - 1) / scale;
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+
+    bool transform = true;
+    if (ncomp_ == 3) {
+        if (adobe_) {
+            transform = adobeTransform_ != 0;
+        } else if (comps_[0].id == 'R' && comps_[1].id == 'G' && comps_[2].id == 'B') {
+            transform = false;
+        }
+    }
+
+    // Coluna de cada componente para cada x de saída (croma subamostrado é replicado)
+    const int ncomp = ncomp_;
+    thread_local std::vector<int> columns;
+    columns.resize(static_cast<size_t>(ncomp) * width);
+    for (int i = 0; i < ncomp; ++i) {
+        for (int x = 0; x < width; ++x) {
+            columns[i * width + x] = x * comps_[i].h / hmax_;
+        }
+    }
+
+    unsigned char* out = rgb.data();
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* rows[3];
+        for (int i = 0; i < ncomp; ++i) {
+            const Component& c = comps_[i];
+            rows[i] = c.plane + static_cast<size_t>(y * c.v / vmax_) * c.planeW;
+        }
+
+        for (int x = 0; x < width; ++x, out += 3) {
+            int s[3];
+            for (int i = 0; i < ncomp; ++i) {
+                s[i] = rows[i][columns[i * width + x]];
+            }
+
+            if (ncomp == 1) {
+                out[0] = out[1] = out[2] = static_cast<unsigned char>(s[0]);
+            } else if (!transform) {
+                out[0] = static_cast<unsigned char>(s[0]);
+                out[1] = static_cast<unsigned char>(s[1]);
+                out[2] = static_cast<unsigned char>(s[2]);
+            } else {
+                // YCbCr -> RGB (JFIF) em ponto fixo 16.16
+                int yy = s[0] << 16;
+                int cb = s[1] - 128;
+                int cr = s[2] - 128;
+                int r = (yy + 91881 * cr + 32768) >> 16;
+                int g = (yy - 22554 * cb - 46802 * cr + 32768) >> 16;
+                int b = (yy + 116130 * cb + 32768) >> 16;
+                out[0] = static_cast<unsigned char>(r < 0 ? 0 : (r > 255 ? 255 : r));
+                out[1] = static_cast<unsigned char>(g < 0 ? 0 : (g > 255 ? 255 : g));
+                out[2] = static_cast<unsigned char>(b < 0 ? 0 : (b > 255 ? 255 : b));
+            }
+        }
+    }
+}
+
+bool ScaledDecoder::decode(std::vector<unsigned char>& rgb, int& width, int& height) {
+    if (!isJpeg(data_, size_)) return false;
+
+    size_t pos = 2;
+    while (pos + 4 <= size_) {
+        if (data_[pos] != 0xFF) return false;
+        uint8_t marker = data_[pos + 1];
+        pos += 2;
+
+        if (marker == 0xFF) { // bytes de preenchimento
+            --pos;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) continue; // sem comprimento
+        if (marker == 0xD9) return false; // EOI antes do scan
+
+        int len = (data_[pos] << 8) | data_[pos + 1];
+        if (len < 2 || pos + len > size_) return false;
+        const uint8_t* seg = data_ + pos + 2;
+        int segLen = len - 2;
+
+        switch (marker) {
+            case 0xC0: // baseline
+            case 0xC1: // sequencial estendido (Huffman)
+                if (!parseSof(seg, segLen)) return false;
+                break;
+            case 0xC4:
+                if (!parseDht(seg, segLen)) return false;
+                break;
+            case 0xDB:
+                if (!parseDqt(seg, segLen)) return false;
+                break;
+            case 0xDD:
+                if (segLen < 2) return false;
+                restartInterval_ = (seg[0] << 8) | seg[1];
+                break;
+            case 0xEE: // APP14 Adobe: indica a transformação de cor
+                if (segLen >= 12 && std::memcmp(seg, "Adobe", 5) == 0) {
+                    adobe_ = true;
+                    adobeTransform_ = seg[11];
+                }
+                break;
+            case 0xDA:
+                if (!decodeScan(seg, segLen, data_ + pos + len, data_ + size_)) return false;
+                toRgb(rgb, width, height);
+                return true;
+            default:
+                // Progressivo, sem perdas e aritmético ficam para o decodificador completo
+                if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                    return false;
+                }
+                break;
+        }
+        pos += len;
+    }
+    return false;
+}
+
+} // namespace
+
+bool isJpeg(const unsigned char* data, size_t size) {
+    return size >= 4 && data[0] == 0xFF && data[1] == 0xD8;
+}
+
+bool decodeJpegScaled(const unsigned char* data, size_t size, int scale,
+                      std::vector<unsigned char>& rgb, int& width, int& height) {
+    if (scale != 2 && scale != 4 && scale != 8) return false;
+    ScaledDecoder decoder(data, size, scale);
+    return decoder.decode(rgb, width, height);
+}
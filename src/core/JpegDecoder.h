@@ -0,0 +1,35 @@
+// src/core/JpegDecoder.h
+
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Decodifica um JPEG baseline diretamente em resolução reduzida.
+ *
+ * Com scale = 8 usa apenas o coeficiente DC de cada bloco 8x8 (nenhuma IDCT);
+ * com scale = 4 ou 2 aplica uma IDCT reduzida sobre os coeficientes de baixa
+ * frequência (2x2 ou 4x4). Os coeficientes AC restantes ainda são lidos do
+ * fluxo Huffman, mas não são desquantizados nem transformados.
+ *
+ * Suporta JPEG baseline/extended de 8 bits, 1 ou 3 componentes (YCbCr ou RGB),
+ * com qualquer subamostragem de croma e intervalos de restart. Retorna false
+ * para os demais casos (progressivo, aritmético, CMYK, dados corrompidos...),
+ * e o chamador deve recorrer ao decodificador completo.
+ *
+ * @param data  Conteúdo do arquivo JPEG
+ * @param size  Tamanho em bytes
+ * @param scale Fator de redução: 2, 4 ou 8
+ * @param rgb   Saída com width * height pixels RGB intercalados
+ */
+bool decodeJpegScaled(const unsigned char* data, size_t size, int scale,
+                      std::vector<unsigned char>& rgb, int& width, int& height);
+
+/**
+ * @brief Verifica a assinatura SOI (0xFFD8) de um arquivo JPEG.
+ */
+bool isJpeg(const unsigned char* data, size_t size);
+
+#endif // JPEG_DECODER_H
@@ -0,0 +1,44 @@
+// src/core/MappedFile.h
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Arquivo somente-leitura mapeado em memória (mmap).
+ *
+ * Em sistemas sem mmap (Windows/MinGW) o conteúdo é lido para um buffer
+ * interno, mantendo a mesma interface.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Mapeia o arquivo. Retorna false se ele não existir ou não puder ser lido.
+     */
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<unsigned char> buffer_; // usado quando mmap não está disponível
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,386 @@
+// src/core/Metric.cpp
+
+#include "Metric.h"
+#include "Avx512.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using ScoreFn = double (*)(const float*, const float*, size_t, double);
+
+// Cada métrica é descrita por uma operação por elemento (scalar) ou por
+// vetor (sse2/avx2/avx512) que acumula em `sums` somas independentes, e por
+// finish(), que combina as somas no score. Nas operações com `monotone` a
+// soma 0 só cresce e finish() a devolve sem alteração, o que permite o
+// abandono antecipado pelo mesmo esquema de blocos de squaredEuclideanDistance.
+
+struct L1Op {
+    static constexpr int sums = 1;
+    static constexpr bool monotone = true;
+    static void scalar(double* s, float a, float b) { s[0] += std::fabs(a - b); }
+    static double finish(const double* s) { return s[0]; }
+#if ANALISE_X86_DISPATCH
+    ANALISE_TARGET("sse2")
+    static void sse2(__m128* s, __m128 a, __m128 b) {
+        s[0] = _mm_add_ps(s[0], _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(a, b)));
+    }
+    ANALISE_TARGET("avx2,fma")
+    static void avx2(__m256* s, __m256 a, __m256 b) {
+        s[0] = _mm256_add_ps(s[0], _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_sub_ps(a, b)));
+    }
+    ANALISE_TARGET("avx512f")
+    static void avx512(__m512* s, __m512 a, __m512 b) {
+        s[0] = _mm512_add_ps(s[0], _mm512_abs_ps(_mm512_sub_ps(a, b)));
+    }
+#endif
+};
+
+// Bins vazios nos dois histogramas (a + b = 0) não contribuem
+struct ChiSquareOp {
+    static constexpr int sums = 1;
+    static constexpr bool monotone = true;
+    static void scalar(double* s, float a, float b) {
+        const float d = a - b, den = a + b;
+        if (den > 0.0f) s[0] += d * d / den;
+    }
+    static double finish(const double* s) { return s[0]; }
+#if ANALISE_X86_DISPATCH
+    ANALISE_TARGET("sse2")
+    static void sse2(__m128* s, __m128 a, __m128 b) {
+        const __m128 d = _mm_sub_ps(a, b), den = _mm_add_ps(a, b);
+        const __m128 term = _mm_div_ps(_mm_mul_ps(d, d), den);
+        s[0] = _mm_add_ps(s[0], _mm_and_ps(_mm_cmpgt_ps(den, _mm_setzero_ps()), term));
+    }
+    ANALISE_TARGET("avx2,fma")
+    static void avx2(__m256* s, __m256 a, __m256 b) {
+        const __m256 d = _mm256_sub_ps(a, b), den = _mm256_add_ps(a, b);
+        const __m256 term = _mm256_div_ps(_mm256_mul_ps(d, d), den);
+        s[0] = _mm256_add_ps(s[0], _mm256_and_ps(_mm256_cmp_ps(den, _mm256_setzero_ps(), _CMP_GT_OQ), term));
+    }
+    ANALISE_TARGET("avx512f")
+    static void avx512(__m512* s, __m512 a, __m512 b) {
+        const __m512 d = _mm512_sub_ps(a, b), den = _mm512_add_ps(a, b);
+        const __mmask16 nonEmpty = _mm512_cmp_ps_mask(den, _mm512_setzero_ps(), _CMP_GT_OQ);
+        s[0] = _mm512_add_ps(s[0], _mm512_maskz_div_ps(nonEmpty, _mm512_mul_ps(d, d), den));
+    }
+#endif
+};
+
+// sums: soma de min(a, b) e soma de b (normaliza pelo histograma da base)
+struct IntersectionOp {
+    static constexpr int sums = 2;
+    static constexpr bool monotone = false;
+    static void scalar(double* s, float a, float b) {
+        s[0] += std::min(a, b);
+        s[1] += b;
+    }
+    static double finish(const double* s) { return s[1] > 0.0 ? 1.0 - s[0] / s[1] : 1.0; }
+#if ANALISE_X86_DISPATCH
+    ANALISE_TARGET("sse2")
+    static void sse2(__m128* s, __m128 a, __m128 b) {
+        s[0] = _mm_add_ps(s[0], _mm_min_ps(a, b));
+        s[1] = _mm_add_ps(s[1], b);
+    }
+    ANALISE_TARGET("avx2,fma")
+    static void avx2(__m256* s, __m256 a, __m256 b) {
+        s[0] = _mm256_add_ps(s[0], _mm256_min_ps(a, b));
+        s[1] = _mm256_add_ps(s[1], b);
+    }
+    ANALISE_TARGET("avx512f")
+    static void avx512(__m512* s, __m512 a, __m512 b) {
+        s[0] = _mm512_add_ps(s[0], avx512::min(a, b));
+        s[1] = _mm512_add_ps(s[1], b);
+    }
+#endif
+};
+
+// Valores negativos (não ocorrem em histogramas) contam como zero
+struct HellingerOp {
+    static constexpr int sums = 1;
+    static constexpr bool monotone = true;
+    static void scalar(double* s, float a, float b) {
+        const float d = std::sqrt(std::max(a, 0.0f)) - std::sqrt(std::max(b, 0.0f));
+        s[0] += d * d;
+    }
+    static double finish(const double* s) { return s[0]; }
+#if ANALISE_X86_DISPATCH
+    ANALISE_TARGET("sse2")
+    static void sse2(__m128* s, __m128 a, __m128 b) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 d = _mm_sub_ps(_mm_sqrt_ps(_mm_max_ps(a, zero)), _mm_sqrt_ps(_mm_max_ps(b, zero)));
+        s[0] = _mm_add_ps(s[0], _mm_mul_ps(d, d));
+    }
+    ANALISE_TARGET("avx2,fma")
+    static void avx2(__m256* s, __m256 a, __m256 b) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 d = _mm256_sub_ps(_mm256_sqrt_ps(_mm256_max_ps(a, zero)), _mm256_sqrt_ps(_mm256_max_ps(b, zero)));
+        s[0] = _mm256_fmadd_ps(d, d, s[0]);
+    }
+    ANALISE_TARGET("avx512f")
+    static void avx512(__m512* s, __m512 a, __m512 b) {
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 d = _mm512_sub_ps(avx512::sqrt(avx512::max(a, zero)), avx512::sqrt(avx512::max(b, zero)));
+        s[0] = _mm512_fmadd_ps(d, d, s[0]);
+    }
+#endif
+};
+
+// sums: a·b, ||a||² e ||b||²; vetores nulos ficam a distância 1 de tudo
+struct CosineOp {
+    static constexpr int sums = 3;
+    static constexpr bool monotone = false;
+    static void scalar(double* s, float a, float b) {
+        s[0] += a * b;
+        s[1] += a * a;
+        s[2] += b * b;
+    }
+    static double finish(const double* s) {
+        return s[1] > 0.0 && s[2] > 0.0 ? 1.0 - s[0] / std::sqrt(s[1] * s[2]) : 1.0;
+    }
+#if ANALISE_X86_DISPATCH
+    ANALISE_TARGET("sse2")
+    static void sse2(__m128* s, __m128 a, __m128 b) {
+        s[0] = _mm_add_ps(s[0], _mm_mul_ps(a, b));
+        s[1] = _mm_add_ps(s[1], _mm_mul_ps(a, a));
+        s[2] = _mm_add_ps(s[2], _mm_mul_ps(b, b));
+    }
+    ANALISE_TARGET("avx2,fma")
+    static void avx2(__m256* s, __m256 a, __m256 b) {
+        s[0] = _mm256_fmadd_ps(a, b, s[0]);
+        s[1] = _mm256_fmadd_ps(a, a, s[1]);
+        s[2] = _mm256_fmadd_ps(b, b, s[2]);
+    }
+    ANALISE_TARGET("avx512f")
+    static void avx512(__m512* s, __m512 a, __m512 b) {
+        s[0] = _mm512_fmadd_ps(a, b, s[0]);
+        s[1] = _mm512_fmadd_ps(a, a, s[1]);
+        s[2] = _mm512_fmadd_ps(b, b, s[2]);
+    }
+#endif
+};
+
+template <MetricKind Kind> struct OpOf;
+template <> struct OpOf<MetricKind::L1> { using type = L1Op; };
+template <> struct OpOf<MetricKind::ChiSquare> { using type = ChiSquareOp; };
+template <> struct OpOf<MetricKind::Intersection> { using type = IntersectionOp; };
+template <> struct OpOf<MetricKind::Hellinger> { using type = HellingerOp; };
+template <> struct OpOf<MetricKind::Cosine> { using type = CosineOp; };
+
+// Dim != DYNAMIC_DIMENSION fixa n em tempo de compilação (laços desenrolados)
+template <typename Op, size_t Dim>
+double scoreReference(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    double s[Op::sums] = {};
+    for (size_t start = 0; start < n; start += DISTANCE_BLOCK) {
+        const size_t end = std::min(n, start + DISTANCE_BLOCK);
+        for (size_t i = start; i < end; ++i) {
+            Op::scalar(s, a[i], b[i]);
+        }
+        if (Op::monotone && s[0] > bound) break;
+    }
+    return Op::finish(s);
+}
+
+#if ANALISE_X86_DISPATCH
+
+ANALISE_TARGET("sse2")
+inline float horizontalSum(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+ANALISE_TARGET("avx2,fma")
+inline float horizontalSum(__m256 v) {
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+
+// Dois conjuntos de acumuladores independentes escondem a latência da soma
+template <typename Op, size_t Dim>
+ANALISE_TARGET("sse2")
+double scoreSse2(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m128 acc0[Op::sums], acc1[Op::sums];
+    for (int k = 0; k < Op::sums; ++k) acc0[k] = acc1[k] = _mm_setzero_ps();
+    size_t i = 0;
+    while (i + DISTANCE_BLOCK <= n) {
+        for (const size_t end = i + DISTANCE_BLOCK; i < end; i += 8) {
+            Op::sse2(acc0, _mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+            Op::sse2(acc1, _mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+        }
+        if (Op::monotone && i < n) {
+            const float partial = horizontalSum(_mm_add_ps(acc0[0], acc1[0]));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 4 <= n; i += 4) {
+        Op::sse2(acc0, _mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    }
+
+    double s[Op::sums];
+    for (int k = 0; k < Op::sums; ++k) s[k] = horizontalSum(_mm_add_ps(acc0[k], acc1[k]));
+    for (; i < n; ++i) Op::scalar(s, a[i], b[i]);
+    return Op::finish(s);
+}
+
+template <typename Op, size_t Dim>
+ANALISE_TARGET("avx2,fma")
+double scoreAvx2(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m256 acc0[Op::sums], acc1[Op::sums];
+    for (int k = 0; k < Op::sums; ++k) acc0[k] = acc1[k] = _mm256_setzero_ps();
+    size_t i = 0;
+    while (i + DISTANCE_BLOCK <= n) {
+        for (const size_t end = i + DISTANCE_BLOCK; i < end; i += 16) {
+            Op::avx2(acc0, _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+            Op::avx2(acc1, _mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+        }
+        if (Op::monotone && i < n) {
+            const float partial = horizontalSum(_mm256_add_ps(acc0[0], acc1[0]));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        Op::avx2(acc0, _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    }
+
+    double s[Op::sums];
+    for (int k = 0; k < Op::sums; ++k) s[k] = horizontalSum(_mm256_add_ps(acc0[k], acc1[k]));
+    for (; i < n; ++i) Op::scalar(s, a[i], b[i]);
+    return Op::finish(s);
+}
+
+// Final com máscara: as lanes fora do vetor são zero e não contribuem em
+// nenhuma das operações
+template <typename Op, size_t Dim>
+ANALISE_TARGET("avx512f")
+double scoreAvx512(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m512 acc0[Op::sums], acc1[Op::sums];
+    for (int k = 0; k < Op::sums; ++k) acc0[k] = acc1[k] = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        Op::avx512(acc0, _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        Op::avx512(acc1, _mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+        Op::avx512(acc0, _mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32));
+        Op::avx512(acc1, _mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48));
+        if (Op::monotone && i + 64 < n) {
+            const float partial = avx512::reduceAdd(_mm512_add_ps(acc0[0], acc1[0]));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 16 <= n; i += 16) {
+        Op::avx512(acc0, _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    }
+    if (i < n) {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        Op::avx512(acc1, _mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+    }
+
+    double s[Op::sums];
+    for (int k = 0; k < Op::sums; ++k) s[k] = avx512::reduceAdd(_mm512_add_ps(acc0[k], acc1[k]));
+    return Op::finish(s);
+}
+
+#endif // ANALISE_X86_DISPATCH
+
+template <typename Op, size_t Dim>
+ScoreFn scoreFn(DistanceKernel kernel) {
+    switch (kernel) {
+#if ANALISE_X86_DISPATCH
+        case DistanceKernel::SSE2: return scoreSse2<Op, Dim>;
+        case DistanceKernel::AVX2: return scoreAvx2<Op, Dim>;
+        case DistanceKernel::AVX512: return scoreAvx512<Op, Dim>;
+#endif
+        default: return scoreReference<Op, Dim>;
+    }
+}
+
+// Kernel de DistanceKernel::Auto para cada métrica e dimensão, escolhido na primeira chamada
+template <typename Op, size_t Dim>
+ScoreFn bestScoreFn() {
+    static const ScoreFn fn = scoreFn<Op, Dim>(bestDistanceKernel());
+    return fn;
+}
+
+template <typename Op>
+double selectedScore(const float* a, const float* b, size_t n, DistanceKernel kernel) {
+    const double kNoBound = std::numeric_limits<double>::infinity();
+    if (kernel != DistanceKernel::Auto && isDistanceKernelSupported(kernel)) {
+        return scoreFn<Op, DYNAMIC_DIMENSION>(kernel)(a, b, n, kNoBound);
+    }
+    return bestScoreFn<Op, DYNAMIC_DIMENSION>()(a, b, n, kNoBound);
+}
+
+struct MetricNameEntry {
+    MetricKind kind;
+    const char* name;
+};
+
+const MetricNameEntry kMetricNames[] = {
+    {MetricKind::Euclidean, "euclidiana"},
+    {MetricKind::L1, "l1"},
+    {MetricKind::ChiSquare, "chi2"},
+    {MetricKind::Intersection, "intersecao"},
+    {MetricKind::Hellinger, "hellinger"},
+    {MetricKind::Cosine, "cosseno"},
+};
+
+} // namespace
+
+template <MetricKind Kind, size_t Dim>
+double metricScore(const float* a, const float* b, size_t dimension, double bound) {
+    static_assert(Kind != MetricKind::Euclidean, "use squaredEuclideanDistance<Dim>");
+    return bestScoreFn<typename OpOf<Kind>::type, Dim>()(a, b, dimension, bound);
+}
+
+#define INSTANTIATE_METRIC_SCORE(kind)                                                                      \
+    template double metricScore<kind, DYNAMIC_DIMENSION>(const float*, const float*, size_t, double);      \
+    template double metricScore<kind, 8>(const float*, const float*, size_t, double);                      \
+    template double metricScore<kind, 64>(const float*, const float*, size_t, double);                     \
+    template double metricScore<kind, 512>(const float*, const float*, size_t, double);
+
+INSTANTIATE_METRIC_SCORE(MetricKind::L1)
+INSTANTIATE_METRIC_SCORE(MetricKind::ChiSquare)
+INSTANTIATE_METRIC_SCORE(MetricKind::Intersection)
+INSTANTIATE_METRIC_SCORE(MetricKind::Hellinger)
+INSTANTIATE_METRIC_SCORE(MetricKind::Cosine)
+
+#undef INSTANTIATE_METRIC_SCORE
+
+double metricScore(MetricKind kind, const float* a, const float* b, size_t dimension, DistanceKernel kernel) {
+    switch (kind) {
+        case MetricKind::L1: return selectedScore<L1Op>(a, b, dimension, kernel);
+        case MetricKind::ChiSquare: return selectedScore<ChiSquareOp>(a, b, dimension, kernel);
+        case MetricKind::Intersection: return selectedScore<IntersectionOp>(a, b, dimension, kernel);
+        case MetricKind::Hellinger: return selectedScore<HellingerOp>(a, b, dimension, kernel);
+        case MetricKind::Cosine: return selectedScore<CosineOp>(a, b, dimension, kernel);
+        default: return squaredEuclideanDistance(a, b, dimension, std::numeric_limits<double>::infinity(), kernel);
+    }
+}
+
+const char* metricName(MetricKind kind) {
+    for (const MetricNameEntry& entry : kMetricNames) {
+        if (entry.kind == kind) return entry.name;
+    }
+    return "?";
+}
+
+bool metricFromName(std::string_view name, MetricKind& kind) {
+    for (const MetricNameEntry& entry : kMetricNames) {
+        if (name == entry.name) {
+            kind = entry.kind;
+            return true;
+        }
+    }
+    return false;
+}
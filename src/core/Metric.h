@@ -0,0 +1,149 @@
+// src/core/Metric.h
+
+#ifndef METRIC_H
+#define METRIC_H
+
+#include "Vector.h"
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string_view>
+
+/**
+ * @brief Funções de distância entre histogramas disponíveis nos índices.
+ */
+enum class MetricKind {
+    Euclidean,    // ||a - b||
+    L1,           // soma de |a - b|
+    ChiSquare,    // soma de (a - b)² / (a + b)
+    Intersection, // 1 - soma de min(a, b) / soma de b (Swain e Ballard)
+    Hellinger,    // ||sqrt(a) - sqrt(b)|| / sqrt(2)
+    Cosine        // 1 - a·b / (||a|| ||b||)
+};
+
+/**
+ * @brief Valor comparado nos laços de busca para a métrica `Kind` (o
+ * "score", crescente com a distância; veja as políticas abaixo).
+ *
+ * Mesmo contrato de squaredEuclideanDistance<Dim>: Dim fixa a dimensão em
+ * tempo de compilação (8, 64, 512 ou DYNAMIC_DIMENSION) e o kernel SIMD é
+ * escolhido na primeira chamada. Nas métricas com abandono antecipado a
+ * soma parcial é retornada assim que passa de `bound`; nas demais `bound` é
+ * ignorado. Euclidean não é aceito aqui (use squaredEuclideanDistance).
+ */
+template <MetricKind Kind, size_t Dim>
+double metricScore(const float* a, const float* b, size_t dimension,
+                   double bound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Score com um kernel específico (para os microbenchmarks); aceita
+ * todas as métricas, inclusive Euclidean (quadrado da distância).
+ */
+double metricScore(MetricKind kind, const float* a, const float* b, size_t dimension,
+                   DistanceKernel kernel = DistanceKernel::Auto);
+
+/*
+ * Políticas de métrica usadas como parâmetro de template pelos índices
+ * (BasicImageList, BasicMTree). Cada uma define:
+ *   - score<Dim>(a, b, n, bound): valor comparado nos laços;
+ *   - toDistance(score) / toScore(distance): conversão entre os dois;
+ *   - isMetric: vale a desigualdade triangular (exigido pela M-Tree);
+ *   - earlyAbandon: score é soma de termos >= 0 e respeita `bound`.
+ * Como a política é resolvida na compilação, o laço de busca chama o kernel
+ * da métrica diretamente, sem teste nem indireção extra por candidato.
+ */
+
+struct EuclideanMetric {
+    static constexpr MetricKind kind = MetricKind::Euclidean;
+    static constexpr bool isMetric = true;
+    static constexpr bool earlyAbandon = true;
+
+    // Quadrado da distância (veja squaredEuclideanDistance<Dim>)
+    template <size_t Dim>
+    static double score(const float* a, const float* b, size_t n,
+                        double bound = std::numeric_limits<double>::infinity()) {
+        return squaredEuclideanDistance<Dim>(a, b, n, bound);
+    }
+    static double toDistance(double score) { return std::sqrt(score); }
+    static double toScore(double distance) { return distance * distance; }
+};
+
+template <MetricKind Kind>
+struct HistogramMetric {
+    static constexpr MetricKind kind = Kind;
+
+    template <size_t Dim>
+    static double score(const float* a, const float* b, size_t n,
+                        double bound = std::numeric_limits<double>::infinity()) {
+        return metricScore<Kind, Dim>(a, b, n, bound);
+    }
+};
+
+struct L1Metric : HistogramMetric<MetricKind::L1> {
+    static constexpr bool isMetric = true;
+    static constexpr bool earlyAbandon = true;
+    static double toDistance(double score) { return score; }
+    static double toScore(double distance) { return distance; }
+};
+
+struct ChiSquareMetric : HistogramMetric<MetricKind::ChiSquare> {
+    static constexpr bool isMetric = false;
+    static constexpr bool earlyAbandon = true;
+    static double toDistance(double score) { return score; }
+    static double toScore(double distance) { return distance; }
+};
+
+struct IntersectionMetric : HistogramMetric<MetricKind::Intersection> {
+    static constexpr bool isMetric = false;
+    static constexpr bool earlyAbandon = false;
+    static double toDistance(double score) { return score; }
+    static double toScore(double distance) { return distance; }
+};
+
+// Score = soma de (sqrt(a) - sqrt(b))²
+struct HellingerMetric : HistogramMetric<MetricKind::Hellinger> {
+    static constexpr bool isMetric = true;
+    static constexpr bool earlyAbandon = true;
+    static double toDistance(double score) { return std::sqrt(0.5 * score); }
+    static double toScore(double distance) { return 2.0 * distance * distance; }
+};
+
+struct CosineMetric : HistogramMetric<MetricKind::Cosine> {
+    static constexpr bool isMetric = false;
+    static constexpr bool earlyAbandon = false;
+    static double toDistance(double score) { return score; }
+    static double toScore(double distance) { return distance; }
+};
+
+/**
+ * @brief Distância completa (sem limite) entre dois vetores de `n` floats.
+ */
+template <typename Metric>
+double metricDistance(const float* a, const float* b, size_t n) {
+    return Metric::toDistance(Metric::template score<DYNAMIC_DIMENSION>(a, b, n));
+}
+
+/**
+ * @brief Chama fn(Política()) com a política de `kind`; usado na linha de
+ * comando para instanciar os índices com a métrica escolhida uma única vez.
+ */
+template <typename Fn>
+decltype(auto) dispatchMetric(MetricKind kind, Fn&& fn) {
+    switch (kind) {
+        case MetricKind::L1: return fn(L1Metric());
+        case MetricKind::ChiSquare: return fn(ChiSquareMetric());
+        case MetricKind::Intersection: return fn(IntersectionMetric());
+        case MetricKind::Hellinger: return fn(HellingerMetric());
+        case MetricKind::Cosine: return fn(CosineMetric());
+        default: return fn(EuclideanMetric());
+    }
+}
+
+const char* metricName(MetricKind kind);
+
+/**
+ * @brief Converte o nome de metricName() de volta; false se for desconhecido.
+ */
+bool metricFromName(std::string_view name, MetricKind& kind);
+
+#endif // METRIC_H
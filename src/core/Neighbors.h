@@ -0,0 +1,95 @@
+// src/core/Neighbors.h
+
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Resultado de findKNearest/findInRange: id da imagem no FeatureStore
+ * e a distância até a consulta (na métrica do índice).
+ */
+struct Neighbor {
+    int id;
+    double distance;
+};
+
+/**
+ * @brief Ordem dos resultados: menor distância primeiro e, no empate, menor id.
+ */
+inline bool neighborBefore(const Neighbor& a, const Neighbor& b) {
+    return a.distance != b.distance ? a.distance < b.distance : a.id < b.id;
+}
+
+/**
+ * @brief Max-heap de capacidade fixa com os k melhores candidatos.
+ *
+ * Usa o vetor de quem chama como espaço: o construtor o esvazia e reserva k
+ * posições, então reaproveitar o mesmo vetor entre consultas não aloca nada
+ * depois da primeira. Os valores empilhados são os scores da métrica (por
+ * exemplo o quadrado da distância euclidiana); finish() ordena e converte.
+ */
+class NeighborHeap {
+public:
+    NeighborHeap(std::vector<Neighbor>& storage, size_t k) : items_(storage), k_(k) {
+        items_.clear();
+        items_.reserve(k_);
+    }
+
+    bool full() const { return items_.size() >= k_; }
+
+    /**
+     * @brief Score que um candidato não pode ultrapassar para entrar (o do
+     * k-ésimo melhor, ou infinito enquanto houver vaga). Serve de limite para
+     * o abandono antecipado e, convertido em distância, para a poda das árvores.
+     */
+    double bound() const {
+        if (!full()) return std::numeric_limits<double>::infinity();
+        return k_ == 0 ? -std::numeric_limits<double>::infinity() : items_.front().distance;
+    }
+
+    /**
+     * @brief Insere o candidato se ele for melhor que o pior guardado
+     * (empates pelo menor id, como na ordem final).
+     */
+    void push(int id, double score) {
+        const Neighbor candidate{id, score};
+        if (!full()) {
+            items_.push_back(candidate);
+            std::push_heap(items_.begin(), items_.end(), neighborBefore);
+        } else if (k_ > 0 && neighborBefore(candidate, items_.front())) {
+            std::pop_heap(items_.begin(), items_.end(), neighborBefore);
+            items_.back() = candidate;
+            std::push_heap(items_.begin(), items_.end(), neighborBefore);
+        }
+    }
+
+    /**
+     * @brief Deixa o vetor em ordem crescente, com os scores convertidos por
+     * toDistance (o heap não deve mais ser usado depois).
+     */
+    template <typename ToDistance>
+    void finish(ToDistance&& toDistance) {
+        std::sort_heap(items_.begin(), items_.end(), neighborBefore);
+        for (Neighbor& n : items_) n.distance = toDistance(n.distance);
+    }
+
+private:
+    std::vector<Neighbor>& items_;
+    size_t k_;
+};
+
+/**
+ * @brief Ordena os resultados de uma busca por raio e converte os scores
+ * (mesma ordem de NeighborHeap::finish).
+ */
+template <typename ToDistance>
+void sortNeighbors(std::vector<Neighbor>& neighbors, ToDistance&& toDistance) {
+    std::sort(neighbors.begin(), neighbors.end(), neighborBefore);
+    for (Neighbor& n : neighbors) n.distance = toDistance(n.distance);
+}
+
+#endif // NEIGHBORS_H
@@ -0,0 +1,340 @@
+// src/core/QuantizedStore.cpp
+
+#include "QuantizedStore.h"
+#include "Avx512.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Códigos por linha múltiplos de 64: uma linha de cache e um registrador AVX-512
+const size_t kCodeAlignment = 64;
+
+// Até 65536 bytes a soma (no máximo 127² por byte) cabe em 32 bits; vetores
+// maiores são somados em pedaços desse tamanho
+const size_t kChunkBytes = 65536;
+
+// Bytes comparados entre duas verificações do limite (abandono antecipado)
+const size_t kAbandonBytes = 256;
+
+// Linhas por chamada do kernel em QuantizedSearch::scan
+const size_t kScanRows = 64;
+
+// Distâncias de `count` linhas (codes + rows[r] * stride, ou linhas
+// consecutivas com rows == nullptr) até `query`. Uma linha cuja soma parcial
+// passa de `bound` para ali e devolve a soma parcial (> bound).
+using CodeTileFn = void (*)(const uint8_t*, const uint8_t*, size_t, const uint32_t*, size_t, uint64_t, uint64_t*);
+
+inline const uint8_t* codeRow(const uint8_t* codes, size_t stride, const uint32_t* rows, size_t r) {
+    return codes + (rows ? rows[r] : r) * stride;
+}
+
+void tileReference(const uint8_t* query, const uint8_t* codes, size_t stride, const uint32_t* rows, size_t count,
+                   uint64_t bound, uint64_t* out) {
+    for (size_t r = 0; r < count; ++r) {
+        const uint8_t* row = codeRow(codes, stride, rows, r);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < stride; ++i) {
+            const int d = static_cast<int>(query[i]) - static_cast<int>(row[i]);
+            sum += static_cast<uint64_t>(d * d);
+            if ((i + 1) % kAbandonBytes == 0 && sum > bound) break;
+        }
+        out[r] = sum;
+    }
+}
+
+#if ANALISE_X86_DISPATCH
+
+// Linhas comparadas juntas: cada uma tem o seu acumulador em registrador e as
+// somas horizontais das 8 são feitas de uma vez no fim de cada bloco
+const size_t kGroupRows = 8;
+
+inline void groupRows(const uint8_t* codes, size_t stride, const uint32_t* rows, size_t first, size_t count,
+                      const uint8_t** out) {
+    // O último grupo repete a última linha (resultado descartado)
+    for (size_t k = 0; k < kGroupRows; ++k) {
+        out[k] = codeRow(codes, stride, rows, std::min(first + k, count - 1));
+    }
+}
+
+// Soma parcial de cada linha no fim de um bloco; true se todas passaram do limite
+inline bool closeBlock(const uint32_t* lanes, uint64_t* total, uint64_t* partial, uint64_t bound, bool chunkEnd) {
+    bool allAbove = true;
+    for (size_t k = 0; k < kGroupRows; ++k) {
+        partial[k] = total[k] + lanes[k];
+        allAbove = allAbove && partial[k] > bound;
+        if (chunkEnd) total[k] = partial[k];
+    }
+    return allAbove;
+}
+
+// [soma(v[0]), ..., soma(v[7])]
+ANALISE_TARGET("avx2")
+inline __m256i reduceEightEpi32(const __m256i* v) {
+    const __m256i h01 = _mm256_hadd_epi32(v[0], v[1]);
+    const __m256i h23 = _mm256_hadd_epi32(v[2], v[3]);
+    const __m256i h45 = _mm256_hadd_epi32(v[4], v[5]);
+    const __m256i h67 = _mm256_hadd_epi32(v[6], v[7]);
+    const __m256i h0123 = _mm256_hadd_epi32(h01, h23);
+    const __m256i h4567 = _mm256_hadd_epi32(h45, h67);
+    return _mm256_add_epi32(_mm256_permute2x128_si256(h0123, h4567, 0x20),
+                            _mm256_permute2x128_si256(h0123, h4567, 0x31));
+}
+
+// |a - b| em bytes (a saturação zera um dos lados); como os códigos vão até
+// QUANTIZED_MAX_CODE, a diferença cabe em um byte com sinal e vpmaddubsw
+// eleva ao quadrado e soma os pares em 16 bits sem estourar (2·127² < 2^15)
+ANALISE_TARGET("avx2")
+void tileAvx2(const uint8_t* query, const uint8_t* codes, size_t stride, const uint32_t* rows, size_t count,
+              uint64_t bound, uint64_t* out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (size_t g = 0; g < count; g += kGroupRows) {
+        const uint8_t* row[kGroupRows];
+        groupRows(codes, stride, rows, g, count, row);
+        uint64_t total[kGroupRows] = {}, partial[kGroupRows] = {};
+        __m256i acc[kGroupRows];
+        for (auto& a : acc) a = zero;
+
+        for (size_t i = 0; i < stride;) {
+            const size_t end = std::min(stride, i + kAbandonBytes);
+            for (; i < end; i += 32) {
+                const __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query + i));
+                for (size_t k = 0; k < kGroupRows; ++k) {
+                    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row[k] + i));
+                    const __m256i diff = _mm256_or_si256(_mm256_subs_epu8(q, v), _mm256_subs_epu8(v, q));
+                    const __m256i pairs = _mm256_maddubs_epi16(diff, diff);
+                    acc[k] = _mm256_add_epi32(acc[k], _mm256_madd_epi16(pairs, ones));
+                }
+            }
+            alignas(32) uint32_t lanes[kGroupRows];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), reduceEightEpi32(acc));
+            const bool chunkEnd = i % kChunkBytes == 0;
+            if (closeBlock(lanes, total, partial, bound, chunkEnd)) break;
+            if (chunkEnd) {
+                for (auto& a : acc) a = zero;
+            }
+        }
+        for (size_t k = 0; k < kGroupRows && g + k < count; ++k) out[g + k] = partial[k];
+    }
+}
+
+ANALISE_TARGET("avx512f,avx512bw")
+void tileAvx512(const uint8_t* query, const uint8_t* codes, size_t stride, const uint32_t* rows, size_t count,
+                uint64_t bound, uint64_t* out) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ones = _mm512_set1_epi16(1);
+    for (size_t g = 0; g < count; g += kGroupRows) {
+        const uint8_t* row[kGroupRows];
+        groupRows(codes, stride, rows, g, count, row);
+        uint64_t total[kGroupRows] = {}, partial[kGroupRows] = {};
+        __m512i acc[kGroupRows];
+        for (auto& a : acc) a = zero;
+
+        for (size_t i = 0; i < stride;) {
+            const size_t end = std::min(stride, i + kAbandonBytes);
+            for (; i < end; i += 64) {
+                const __m512i q = _mm512_loadu_si512(query + i);
+                for (size_t k = 0; k < kGroupRows; ++k) {
+                    const __m512i v = _mm512_loadu_si512(row[k] + i);
+                    const __m512i diff = _mm512_or_si512(_mm512_subs_epu8(q, v), _mm512_subs_epu8(v, q));
+                    const __m512i pairs = _mm512_maddubs_epi16(diff, diff);
+                    acc[k] = _mm512_add_epi32(acc[k], _mm512_madd_epi16(pairs, ones));
+                }
+            }
+            __m256i halves[kGroupRows];
+            for (size_t k = 0; k < kGroupRows; ++k) halves[k] = avx512::foldHalves(acc[k]);
+            alignas(32) uint32_t lanes[kGroupRows];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), reduceEightEpi32(halves));
+            const bool chunkEnd = i % kChunkBytes == 0;
+            if (closeBlock(lanes, total, partial, bound, chunkEnd)) break;
+            if (chunkEnd) {
+                for (auto& a : acc) a = zero;
+            }
+        }
+        for (size_t k = 0; k < kGroupRows && g + k < count; ++k) out[g + k] = partial[k];
+    }
+}
+
+// Com VNNI, vpdpbusd faz o quadrado, a soma de 4 bytes e o acúmulo em uma instrução
+ANALISE_TARGET("avx512f,avx512bw,avx512vnni")
+void tileAvx512Vnni(const uint8_t* query, const uint8_t* codes, size_t stride, const uint32_t* rows, size_t count,
+                    uint64_t bound, uint64_t* out) {
+    const __m512i zero = _mm512_setzero_si512();
+    for (size_t g = 0; g < count; g += kGroupRows) {
+        const uint8_t* row[kGroupRows];
+        groupRows(codes, stride, rows, g, count, row);
+        uint64_t total[kGroupRows] = {}, partial[kGroupRows] = {};
+        __m512i acc[kGroupRows];
+        for (auto& a : acc) a = zero;
+
+        for (size_t i = 0; i < stride;) {
+            const size_t end = std::min(stride, i + kAbandonBytes);
+            for (; i < end; i += 64) {
+                const __m512i q = _mm512_loadu_si512(query + i);
+                for (size_t k = 0; k < kGroupRows; ++k) {
+                    const __m512i v = _mm512_loadu_si512(row[k] + i);
+                    const __m512i diff = _mm512_or_si512(_mm512_subs_epu8(q, v), _mm512_subs_epu8(v, q));
+                    acc[k] = _mm512_dpbusd_epi32(acc[k], diff, diff);
+                }
+            }
+            __m256i halves[kGroupRows];
+            for (size_t k = 0; k < kGroupRows; ++k) halves[k] = avx512::foldHalves(acc[k]);
+            alignas(32) uint32_t lanes[kGroupRows];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), reduceEightEpi32(halves));
+            const bool chunkEnd = i % kChunkBytes == 0;
+            if (closeBlock(lanes, total, partial, bound, chunkEnd)) break;
+            if (chunkEnd) {
+                for (auto& a : acc) a = zero;
+            }
+        }
+        for (size_t k = 0; k < kGroupRows && g + k < count; ++k) out[g + k] = partial[k];
+    }
+}
+
+#endif // ANALISE_X86_DISPATCH
+
+CodeTileFn codeTileFn(DistanceKernel kernel) {
+#if ANALISE_X86_DISPATCH
+    const CpuFeatures& cpu = cpuFeatures();
+    if (kernel == DistanceKernel::AVX512 && cpu.avx512bw) {
+        return cpu.avx512vnni ? tileAvx512Vnni : tileAvx512;
+    }
+    if ((kernel == DistanceKernel::AVX512 || kernel == DistanceKernel::AVX2) && cpu.avx2) {
+        return tileAvx2;
+    }
+#endif
+    (void)kernel;
+    return tileReference;
+}
+
+CodeTileFn bestCodeTileFn() {
+    static const CodeTileFn fn = codeTileFn(bestDistanceKernel());
+    return fn;
+}
+
+size_t codeStrideFor(size_t dimension) {
+    return (dimension + kCodeAlignment - 1) / kCodeAlignment * kCodeAlignment;
+}
+
+} // namespace
+
+uint64_t squaredCodeDistance(const uint8_t* a, const uint8_t* b, size_t bytes, DistanceKernel kernel) {
+    const CodeTileFn fn = (kernel == DistanceKernel::Auto || !isDistanceKernelSupported(kernel)) ? bestCodeTileFn()
+                                                                                                : codeTileFn(kernel);
+    uint64_t distance = 0;
+    fn(a, b, bytes, nullptr, 1, std::numeric_limits<uint64_t>::max(), &distance);
+    return distance;
+}
+
+QuantizedStore::QuantizedStore(const FeatureStore& store, QuantizationRange range)
+    : store_(&store), range_(range), size_(store.size()), dimension_(store.dimension()),
+      stride_(codeStrideFor(store.dimension())) {
+    minimum_.assign(dimension_, std::numeric_limits<float>::infinity());
+    std::vector<float> maximum(dimension_, -std::numeric_limits<float>::infinity());
+    for (uint32_t id = 0; id < size_; ++id) {
+        const float* f = store.features(id);
+        for (size_t d = 0; d < dimension_; ++d) {
+            minimum_[d] = std::min(minimum_[d], f[d]);
+            maximum[d] = std::max(maximum[d], f[d]);
+        }
+    }
+
+    if (range_ == QuantizationRange::Global && dimension_ > 0 && size_ > 0) {
+        const float low = *std::min_element(minimum_.begin(), minimum_.end());
+        const float high = *std::max_element(maximum.begin(), maximum.end());
+        std::fill(minimum_.begin(), minimum_.end(), low);
+        std::fill(maximum.begin(), maximum.end(), high);
+    }
+
+    scale_.resize(dimension_);
+    for (size_t d = 0; d < dimension_; ++d) {
+        scale_[d] = maximum[d] > minimum_[d] ? QUANTIZED_MAX_CODE / (maximum[d] - minimum_[d]) : 0.0f;
+        if (size_ == 0) minimum_[d] = 0.0f;
+    }
+
+    codes_.resize(size_ * stride_);
+    for (uint32_t id = 0; id < size_; ++id) {
+        encode(store.features(id), codes_.data() + static_cast<size_t>(id) * stride_);
+    }
+}
+
+void QuantizedStore::encode(const float* features, uint8_t* codes) const {
+    for (size_t d = 0; d < dimension_; ++d) {
+        const float v = std::min<float>(QUANTIZED_MAX_CODE, std::max(0.0f, (features[d] - minimum_[d]) * scale_[d]));
+        codes[d] = static_cast<uint8_t>(v + 0.5f);
+    }
+    std::memset(codes + dimension_, 0, stride_ - dimension_);
+}
+
+size_t QuantizedStore::memoryBytes() const {
+    return codes_.capacity() + (minimum_.capacity() + scale_.capacity()) * sizeof(float);
+}
+
+QuantizedSearch::QuantizedSearch(const QuantizedStore& quantized, const float* query, size_t shortlist)
+    : quantized_(&quantized), query_(query), queryCodes_(quantized.stride()), shortlist_(std::max<size_t>(1, shortlist)) {
+    quantized.encode(query, queryCodes_.data());
+    heap_.reserve(shortlist_);
+}
+
+void QuantizedSearch::scan(const uint32_t* ids, uint32_t first, size_t count, int ignoreId) {
+    const CodeTileFn fn = bestCodeTileFn();
+    const size_t stride = quantized_->stride();
+    uint64_t distances[kScanRows];
+
+    for (size_t start = 0; start < count; start += kScanRows) {
+        const size_t rows = std::min(kScanRows, count - start);
+
+        // Com a lista cheia, linhas piores que a pior da lista param no
+        // primeiro bloco que passa do limite (e não entram: o limite só diminui)
+        const uint64_t bound = heap_.size() < shortlist_ ? std::numeric_limits<uint64_t>::max() : heap_.front().distance;
+        fn(queryCodes_.data(), ids ? quantized_->codes(0) : quantized_->codes(first + static_cast<uint32_t>(start)),
+           stride, ids ? ids + start : nullptr, rows, bound, distances);
+
+        for (size_t r = 0; r < rows; ++r) {
+            const uint32_t id = ids ? ids[start + r] : first + static_cast<uint32_t>(start + r);
+            if (static_cast<int>(id) == ignoreId) continue;
+
+            const Candidate candidate{distances[r], scanned_++, id};
+            if (heap_.size() < shortlist_) {
+                heap_.push_back(candidate);
+                std::push_heap(heap_.begin(), heap_.end());
+            } else if (candidate < heap_.front()) {
+                std::pop_heap(heap_.begin(), heap_.end());
+                heap_.back() = candidate;
+                std::push_heap(heap_.begin(), heap_.end());
+            }
+        }
+    }
+}
+
+template <size_t Dim>
+int QuantizedSearch::rerank(double& bestSquared) const {
+    // Na ordem do scan, para desempatar como a busca exata
+    std::vector<Candidate> candidates(heap_);
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.order < b.order; });
+
+    const FeatureStore& store = quantized_->source();
+    int best = -1;
+    for (const Candidate& c : candidates) {
+        const double distance = squaredEuclideanDistance<Dim>(query_, store.features(c.id), store.dimension(),
+                                                              bestSquared);
+        if (distance < bestSquared) {
+            bestSquared = distance;
+            best = static_cast<int>(c.id);
+        }
+    }
+    return best;
+}
+
+template int QuantizedSearch::rerank<DYNAMIC_DIMENSION>(double&) const;
+template int QuantizedSearch::rerank<8>(double&) const;
+template int QuantizedSearch::rerank<64>(double&) const;
+template int QuantizedSearch::rerank<512>(double&) const;
@@ -0,0 +1,145 @@
+// src/core/QuantizedStore.h
+
+#ifndef QUANTIZED_STORE_H
+#define QUANTIZED_STORE_H
+
+#include "FeatureStore.h"
+#include "Vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Maior código: 7 bits de resolução em 1 byte. Assim |a - b| cabe em um
+ * byte com sinal e os kernels usam vpmaddubsw/vpdpbusd, que elevam ao quadrado
+ * e somam em uma instrução (com 0..255 seriam precisas extensões para 16 bits).
+ */
+const int QUANTIZED_MAX_CODE = 127;
+
+/**
+ * @brief Faixa usada para mapear cada característica em 0..QUANTIZED_MAX_CODE.
+ */
+enum class QuantizationRange {
+    Global,      // um único mínimo/máximo: a distância inteira é proporcional à euclidiana
+    PerDimension // mínimo/máximo por dimensão: mais resolução nos bins de pouca variação
+};
+
+/**
+ * @brief Tamanho padrão da lista curta reordenada com os floats exatos.
+ */
+const size_t QUANTIZED_SHORTLIST = 32;
+
+/**
+ * @brief Quadrado da distância entre dois vetores de códigos de 8 bits
+ * (valores até QUANTIZED_MAX_CODE).
+ *
+ * `bytes` deve ser múltiplo de 64 (stride() do QuantizedStore; o preenchimento
+ * é zero nos dois vetores e não contribui). Soma exata em inteiros: o
+ * resultado é o mesmo em todos os kernels. AVX512 usa VNNI quando disponível
+ * e exige AVX-512BW (sem ele, cai para AVX2).
+ */
+uint64_t squaredCodeDistance(const uint8_t* a, const uint8_t* b, size_t bytes,
+                             DistanceKernel kernel = DistanceKernel::Auto);
+
+/**
+ * @brief Cópia de 8 bits por característica de um FeatureStore.
+ *
+ * Cada valor vira round((x - mínimo) * QUANTIZED_MAX_CODE / (máximo - mínimo)), com a faixa
+ * calculada sobre todas as imagens do store na construção. Os códigos ocupam
+ * 1/4 da memória dos floats, então uma varredura sobre eles lê 4x menos
+ * bytes; a ordem que eles dão é aproximada e serve para escolher uma lista
+ * curta de candidatos, reordenada depois com os floats exatos (veja
+ * QuantizedSearch).
+ *
+ * O store deve viver mais que esta cópia, e imagens acrescentadas a ele
+ * depois da construção não estão codificadas.
+ */
+class QuantizedStore {
+public:
+    explicit QuantizedStore(const FeatureStore& store, QuantizationRange range = QuantizationRange::Global);
+
+    /**
+     * @brief Codifica `dimension()` floats em `codes` (stride() bytes, com o
+     * preenchimento zerado). Valores fora da faixa são saturados em 0 ou
+     * QUANTIZED_MAX_CODE.
+     */
+    void encode(const float* features, uint8_t* codes) const;
+
+    const uint8_t* codes(uint32_t id) const { return codes_.data() + static_cast<size_t>(id) * stride_; }
+
+    const FeatureStore& source() const { return *store_; }
+
+    /**
+     * @brief Indica se esta cópia é de `store` e cobre todas as suas imagens.
+     */
+    bool covers(const FeatureStore& store) const { return store_ == &store && size_ == store.size(); }
+    QuantizationRange range() const { return range_; }
+
+    size_t size() const { return size_; }
+    size_t dimension() const { return dimension_; }
+    size_t stride() const { return stride_; }
+
+    /**
+     * @brief Bytes dos códigos e das faixas (sem o FeatureStore de origem).
+     */
+    size_t memoryBytes() const;
+
+private:
+    const FeatureStore* store_;
+    QuantizationRange range_;
+    std::vector<uint8_t, AlignedAllocator<uint8_t>> codes_;
+    std::vector<float> minimum_; // por dimensão (repetido no modo Global)
+    std::vector<float> scale_;   // QUANTIZED_MAX_CODE / (máximo - mínimo), 0 se a faixa for vazia
+    size_t size_ = 0;
+    size_t dimension_ = 0;
+    size_t stride_ = 0;
+};
+
+/**
+ * @brief Busca do vizinho mais próximo em duas fases sobre um QuantizedStore.
+ *
+ * scan() percorre candidatos pelos códigos de 8 bits e guarda os `shortlist`
+ * de menor distância inteira (pode ser chamado várias vezes, por exemplo uma
+ * por balde); rerank() calcula a distância exata em float só para eles. Com
+ * menos candidatos que `shortlist` o resultado é exato; com mais, a imagem
+ * certa só se perde se os erros de arredondamento a tirarem da lista curta.
+ */
+class QuantizedSearch {
+public:
+    QuantizedSearch(const QuantizedStore& quantized, const float* query, size_t shortlist);
+
+    /**
+     * @brief Considera ids[0..count) ou, com `ids == nullptr`, first..first+count-1.
+     * `ignoreId` é pulado.
+     */
+    void scan(const uint32_t* ids, uint32_t first, size_t count, int ignoreId = -1);
+
+    /**
+     * @brief Id da lista curta com menor distância exata ao quadrado <
+     * bestSquared (atualizando-o), ou -1. Empates ficam com o primeiro
+     * candidato na ordem em que foi visto por scan().
+     */
+    template <size_t Dim>
+    int rerank(double& bestSquared) const;
+
+    size_t scanned() const { return scanned_; }
+
+private:
+    struct Candidate {
+        uint64_t distance;
+        uint64_t order; // posição na sequência de scan(), para desempate
+        uint32_t id;
+        bool operator<(const Candidate& other) const {
+            return distance != other.distance ? distance < other.distance : order < other.order;
+        }
+    };
+
+    const QuantizedStore* quantized_;
+    const float* query_;
+    std::vector<uint8_t, AlignedAllocator<uint8_t>> queryCodes_;
+    std::vector<Candidate> heap_; // max-heap: o pior candidato da lista no topo
+    size_t shortlist_;
+    uint64_t scanned_ = 0;
+};
+
+#endif // QUANTIZED_STORE_H
@@ -0,0 +1,453 @@
+// src/core/ReadAhead.cpp
+
+#include "ReadAhead.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define READ_AHEAD_POSIX 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define READ_AHEAD_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#ifdef READ_AHEAD_IO_URING
+
+/**
+ * Anel io_uring mínimo sobre as syscalls (sem depender da liburing): só
+ * leituras (IORING_OP_READ) e espera por conclusões.
+ */
+class ReadAhead::Ring {
+public:
+    explicit Ring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return; // kernel antigo, seccomp ou io_uring desativado
+
+        sqSize_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+
+        void* sq = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq == MAP_FAILED) {
+            ::close(fd);
+            return;
+        }
+        void* cq = sq;
+        if (!single) {
+            cq = mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cq == MAP_FAILED) {
+                munmap(sq, sqSize_);
+                ::close(fd);
+                return;
+            }
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            if (!single) munmap(cq, cqSize_);
+            munmap(sq, sqSize_);
+            ::close(fd);
+            return;
+        }
+
+        unsigned char* s = static_cast<unsigned char*>(sq);
+        unsigned char* c = static_cast<unsigned char*>(cq);
+        sqRing_ = sq;
+        cqRing_ = cq;
+        sqTail_ = reinterpret_cast<unsigned*>(s + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(s + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(s + params.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned*>(c + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(c + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(c + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(c + params.cq_off.cqes);
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+        fd_ = fd;
+    }
+
+    ~Ring() {
+        if (fd_ < 0) return;
+        munmap(sqes_, sqesSize_);
+        if (cqRing_ != sqRing_) munmap(cqRing_, cqSize_);
+        munmap(sqRing_, sqSize_);
+        ::close(fd_);
+    }
+
+    bool valid() const { return fd_ >= 0; }
+
+    // Enfileira a leitura; só é enviada ao kernel no próximo wait()
+    void queueRead(int fd, void* buffer, size_t length, uint64_t offset, uint64_t userData) {
+        const unsigned tail = *sqTail_;
+        const unsigned index = tail & sqMask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = static_cast<uint32_t>(std::min<size_t>(length, 1u << 30));
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit_;
+    }
+
+    // Envia as leituras enfileiradas e espera pelo menos uma conclusão
+    bool wait() {
+        for (;;) {
+            long r = syscall(__NR_io_uring_enter, fd_, toSubmit_, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (r >= 0) {
+                const unsigned submitted = std::min<unsigned>(toSubmit_, static_cast<unsigned>(r));
+                toSubmit_ -= submitted;
+                inKernel_ += submitted;
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) return false;
+        }
+    }
+
+    // Espera (sem submeter mais nada) até que todas as leituras já enviadas
+    // ao kernel terminem, descartando os resultados. Depois disso nenhum
+    // buffer passado a queueRead() ainda pode ser escrito pelo kernel.
+    bool drain() {
+        while (inKernel_ > 0) {
+            long r = syscall(__NR_io_uring_enter, fd_, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) return false;
+            reap([](uint64_t, int) {});
+        }
+        return true;
+    }
+
+    // Chama fn(userData, resultado) para cada conclusão disponível
+    template <typename Fn>
+    void reap(Fn&& fn) {
+        unsigned head = *cqHead_;
+        while (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = cqes_[head & cqMask_];
+            const uint64_t userData = cqe.user_data;
+            const int result = cqe.res;
+            ++head;
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            if (inKernel_ > 0) --inKernel_;
+            fn(userData, result);
+        }
+    }
+
+private:
+    int fd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqSize_ = 0, cqSize_ = 0, sqesSize_ = 0;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned toSubmit_ = 0; // enfileiradas, ainda não enviadas
+    unsigned inKernel_ = 0; // enviadas, conclusão ainda não colhida
+};
+
+#else
+
+class ReadAhead::Ring {
+public:
+    bool valid() const { return false; }
+};
+
+#endif // READ_AHEAD_IO_URING
+
+ReadAhead::ReadAhead(std::vector<std::string> paths, size_t depth)
+    : paths_(std::move(paths)), slots_(std::max<size_t>(1, depth)) {
+    for (int i = static_cast<int>(slots_.size()) - 1; i >= 0; --i) free_.push_back(i);
+
+#ifdef READ_AHEAD_IO_URING
+    ring_.reset(new Ring(static_cast<unsigned>(slots_.size())));
+    if (!ring_->valid()) ring_.reset();
+#endif
+
+    if (!paths_.empty()) {
+        reader_ = std::thread(&ReadAhead::readerLoop, this);
+    }
+}
+
+ReadAhead::~ReadAhead() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    freeCv_.notify_all();
+    if (reader_.joinable()) reader_.join();
+}
+
+const char* ReadAhead::backendName() const {
+    return ring_ && !ringFailed_.load() ? "io_uring" : "read";
+}
+
+bool ReadAhead::next(File& file) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Cada chamada reserva um dos arquivos ainda não entregues antes de esperar,
+    // para que consumidores em excesso não fiquem bloqueados para sempre
+    if (delivered_ == paths_.size()) return false;
+    ++delivered_;
+    readyCv_.wait(lock, [this] { return !ready_.empty(); });
+
+    const int s = ready_.front();
+    ready_.pop_front();
+    const Slot& slot = slots_[s];
+    file.index = slot.index;
+    file.data = slot.ok ? slot.buffer.data() : nullptr;
+    file.size = slot.ok ? slot.size : 0;
+    file.slot = s;
+    return true;
+}
+
+void ReadAhead::release(const File& file) {
+    if (file.slot < 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(file.slot);
+    }
+    freeCv_.notify_one();
+}
+
+int ReadAhead::acquireSlot(bool wait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wait) {
+        freeCv_.wait(lock, [this] { return stopping_ || !free_.empty(); });
+    }
+    if (stopping_ || free_.empty()) return -1;
+    const int s = free_.back();
+    free_.pop_back();
+    return s;
+}
+
+void ReadAhead::publish(int slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(slot);
+    }
+    readyCv_.notify_one();
+}
+
+bool ReadAhead::readWhole(const std::string& path, Slot& slot) {
+    slot.size = 0;
+#ifdef READ_AHEAD_POSIX
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+    if (ok) {
+        try {
+            slot.buffer.resize(static_cast<size_t>(st.st_size));
+        } catch (const std::bad_alloc&) {
+            ok = false;
+        }
+    }
+    size_t done = 0;
+    while (ok && done < slot.buffer.size()) {
+        ssize_t r = ::read(fd, slot.buffer.data() + done, slot.buffer.size() - done);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) ok = false;
+        else done += static_cast<size_t>(r);
+    }
+    ::close(fd);
+    slot.size = ok ? done : 0;
+    return ok;
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    std::streamsize length = in.tellg();
+    if (length <= 0) return false;
+    slot.buffer.resize(static_cast<size_t>(length));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(slot.buffer.data()), length)) return false;
+    slot.size = static_cast<size_t>(length);
+    return true;
+#endif
+}
+
+void ReadAhead::readerLoop() {
+    size_t first = 0;
+#ifdef READ_AHEAD_IO_URING
+    if (ring_) {
+        first = ringLoop();
+    }
+#endif
+    readLoop(first);
+}
+
+void ReadAhead::readLoop(size_t first) {
+    size_t hinted = first;
+    for (size_t i = first; i < paths_.size(); ++i) {
+        const int s = acquireSlot(true);
+        if (s < 0) return;
+
+#if defined(READ_AHEAD_POSIX) && defined(POSIX_FADV_WILLNEED)
+        // Pede ao kernel para já trazer para o page cache os próximos arquivos
+        // da janela, enquanto este é lido e os anteriores são decodificados
+        const size_t window = std::min(paths_.size(), i + slots_.size());
+        for (; hinted < window; ++hinted) {
+            int fd = ::open(paths_[hinted].c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            ::close(fd);
+        }
+#else
+        (void)hinted;
+#endif
+
+        Slot& slot = slots_[s];
+        slot.index = i;
+        slot.ok = readWhole(paths_[i], slot);
+        publish(s);
+    }
+}
+
+size_t ReadAhead::ringLoop() {
+#ifdef READ_AHEAD_IO_URING
+    std::vector<int> fds(slots_.size(), -1);
+    std::vector<size_t> done(slots_.size(), 0);
+    size_t nextPath = 0;
+    size_t inFlight = 0;
+    bool stopped = false;
+    bool fallback = false;
+
+    auto finish = [&](int s, bool ok) {
+        ::close(fds[s]);
+        fds[s] = -1;
+        slots_[s].ok = ok;
+        --inFlight;
+        publish(s);
+    };
+
+    // Lê com pread() o que falta do slot (a partir do que o anel já entregou)
+    auto readRest = [&](int s) {
+        Slot& slot = slots_[s];
+        size_t offset = done[s];
+        while (offset < slot.size) {
+            ssize_t r = pread(fds[s], slot.buffer.data() + offset, slot.size - offset, static_cast<off_t>(offset));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            offset += static_cast<size_t>(r);
+        }
+        return true;
+    };
+
+    for (;;) {
+        // Enche o anel com os próximos arquivos enquanto houver buffers livres;
+        // só bloqueia esperando um buffer se não houver nada em voo
+        while (!stopped && nextPath < paths_.size()) {
+            const int s = acquireSlot(inFlight == 0);
+            if (s < 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopped = stopping_;
+                break;
+            }
+
+            Slot& slot = slots_[s];
+            slot.index = nextPath;
+            slot.ok = false;
+            slot.size = 0;
+            const std::string& path = paths_[nextPath++];
+
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            bool ok = fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0;
+            if (ok) {
+                try {
+                    slot.buffer.resize(static_cast<size_t>(st.st_size));
+                } catch (const std::bad_alloc&) {
+                    ok = false;
+                }
+            }
+            if (!ok) {
+                if (fd >= 0) ::close(fd);
+                publish(s);
+                continue;
+            }
+
+            slot.size = slot.buffer.size();
+            fds[s] = fd;
+            done[s] = 0;
+            ring_->queueRead(fd, slot.buffer.data(), slot.size, 0, static_cast<uint64_t>(s));
+            ++inFlight;
+        }
+
+        if (inFlight == 0) {
+            if (stopped || nextPath >= paths_.size()) return paths_.size();
+            continue;
+        }
+
+        if (!ring_->wait()) {
+            fallback = true; // io_uring_enter falhou
+        } else {
+            ring_->reap([&](uint64_t userData, int result) {
+                const int s = static_cast<int>(userData);
+                Slot& slot = slots_[s];
+                if (result == -EINTR || result == -EAGAIN) {
+                    ring_->queueRead(fds[s], slot.buffer.data() + done[s], slot.size - done[s], done[s], userData);
+                    return;
+                }
+                if (result <= 0) {
+                    // A leitura deste slot já terminou no kernel: refaz com pread().
+                    // EINVAL/EOPNOTSUPP indicam um kernel sem IORING_OP_READ, então
+                    // o anel inteiro é abandonado.
+                    if (result == -EINVAL || result == -EOPNOTSUPP) fallback = true;
+                    finish(s, readRest(s));
+                    return;
+                }
+                done[s] += static_cast<size_t>(result);
+                if (done[s] < slot.size) {
+                    // Leitura curta: pede o restante
+                    ring_->queueRead(fds[s], slot.buffer.data() + done[s], slot.size - done[s], done[s], userData);
+                    return;
+                }
+                finish(s, true);
+            });
+        }
+
+        if (fallback) {
+            // Antes de tocar nos buffers em voo, espera o kernel terminar com eles.
+            // Se nem isso for possível, o kernel ainda pode escrevê-los: os buffers
+            // são abandonados (no máximo `depth`, só neste caso) e o slot relê
+            // tudo em um buffer novo.
+            const bool drained = ring_->drain();
+            for (size_t s = 0; s < slots_.size(); ++s) {
+                if (fds[s] < 0) continue;
+                Slot& slot = slots_[s];
+                if (!drained) {
+                    static_cast<void>(new std::vector<unsigned char>(std::move(slot.buffer))); // fica para o kernel
+                    slot.buffer.assign(slot.size, 0);
+                    done[s] = 0;
+                }
+                finish(static_cast<int>(s), readRest(static_cast<int>(s)));
+            }
+            ringFailed_.store(true);
+            return nextPath;
+        }
+    }
+#else
+    return 0;
+#endif
+}
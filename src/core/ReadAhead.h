@@ -0,0 +1,96 @@
+// src/core/ReadAhead.h
+
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Estágio de leitura antecipada: lê os arquivos à frente dos decodificadores.
+ *
+ * Uma thread dedicada lê os arquivos de `paths` em ordem para um conjunto fixo
+ * de `depth` buffers. Os consumidores pegam os arquivos prontos com next() e
+ * devolvem o buffer com release(). Quando todos os buffers estão cheios ou em
+ * uso, a leitura espera (back-pressure), então a memória fica limitada a
+ * `depth` arquivos.
+ *
+ * No Linux as leituras são submetidas em lote via io_uring (até `depth` em voo).
+ * Se o kernel não oferecer io_uring, a thread lê com read() e avisa o kernel
+ * com posix_fadvise(WILLNEED) sobre os próximos arquivos da fila. Se o anel
+ * falhar no meio (io_uring_enter com erro, ou IORING_OP_READ recusado), as
+ * leituras em voo são concluídas com pread() e o resto segue com read().
+ */
+class ReadAhead {
+public:
+    struct File {
+        size_t index = 0;                    // posição em `paths`
+        const unsigned char* data = nullptr; // nullptr se a leitura falhou
+        size_t size = 0;
+        int slot = -1;
+    };
+
+    ReadAhead(std::vector<std::string> paths, size_t depth);
+    ~ReadAhead();
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    /**
+     * @brief Bloqueia até o próximo arquivo lido. Retorna false quando todos já foram entregues.
+     * Os arquivos podem sair fora de ordem; use File::index.
+     */
+    bool next(File& file);
+
+    /**
+     * @brief Devolve o buffer de `file` para novas leituras.
+     */
+    void release(const File& file);
+
+    const std::string& path(size_t index) const { return paths_[index]; }
+
+    /**
+     * @brief "io_uring" ou "read" (backend escolhido em tempo de execução).
+     */
+    const char* backendName() const;
+
+private:
+    struct Slot {
+        std::vector<unsigned char> buffer;
+        size_t index = 0;
+        size_t size = 0;
+        bool ok = false;
+    };
+    class Ring;
+
+    std::vector<std::string> paths_;
+    std::vector<Slot> slots_;
+    std::unique_ptr<Ring> ring_;
+    std::atomic<bool> ringFailed_{false}; // o anel foi abandonado; segue com read()
+
+    std::mutex mutex_;
+    std::condition_variable readyCv_;
+    std::condition_variable freeCv_;
+    std::deque<int> ready_;
+    std::vector<int> free_;
+    size_t delivered_ = 0;
+    bool stopping_ = false;
+
+    std::thread reader_;
+
+    void readerLoop();
+    void readLoop(size_t first);
+    size_t ringLoop(); // devolve o primeiro arquivo ainda não lido se o anel falhar
+    int acquireSlot(bool wait);
+    void publish(int slot);
+    bool readWhole(const std::string& path, Slot& slot);
+};
+
+#endif // READ_AHEAD_H
@@ -0,0 +1,62 @@
+// src/core/ThreadPool.cpp
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t numThreads) : stopping_(false) {
+    if (numThreads == 0) {
+        numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(numThreads - 1);
+    for (size_t i = 1; i < numThreads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::runOnWorkers(size_t numTasks, const std::function<void()>& task) {
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    size_t pending = numTasks;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < numTasks; ++i) {
+            tasks_.emplace_back([&]() {
+                task();
+                std::lock_guard<std::mutex> doneLock(doneMutex);
+                if (--pending == 0) doneCv.notify_one();
+            });
+        }
+    }
+    cv_.notify_all();
+
+    // A thread chamadora também consome índices
+    task();
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCv.wait(lock, [&] { return pending == 0; });
+}
@@ -0,0 +1,87 @@
+// src/core/ThreadPool.h
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Pool fixo de threads para executar laços paralelos (parallelFor).
+ *
+ * A thread que chama parallelFor também trabalha, então um pool de N threads
+ * cria apenas N - 1 workers. Os índices são distribuídos dinamicamente por um
+ * contador atômico, o que equilibra arquivos de tamanhos muito diferentes.
+ * Chamadas aninhadas de parallelFor a partir de um worker não são suportadas.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param numThreads Número total de threads (0 = std::thread::hardware_concurrency()).
+     */
+    explicit ThreadPool(size_t numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Executa fn(i) para todo i em [0, count) e bloqueia até terminar.
+     * A primeira exceção lançada por fn é propagada para quem chamou.
+     */
+    template <typename Fn>
+    void parallelFor(size_t count, Fn&& fn);
+
+    size_t size() const { return workers_.size() + 1; }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+
+    void workerLoop();
+    void runOnWorkers(size_t numTasks, const std::function<void()>& task);
+};
+
+template <typename Fn>
+void ThreadPool::parallelFor(size_t count, Fn&& fn) {
+    if (count == 0) return;
+
+    if (workers_.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto body = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                next.store(count); // interrompe os demais
+            }
+        }
+    };
+
+    size_t helpers = std::min(workers_.size(), count - 1);
+    runOnWorkers(helpers, body);
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif // THREAD_POOL_H
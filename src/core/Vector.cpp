@@ -1,18 +1,260 @@
 // src/core/Vector.cpp
 
 #include "Vector.h"
+#include "Avx512.h"
+#include "CpuFeatures.h"
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 
-double calculateEuclideanDistance(const FeatureVector& v1, const FeatureVector& v2) {
-    if (v1.size() != v2.size()) {
-        throw std::invalid_argument("Vetores devem ter o mesmo tamanho para calcular a distancia.");
-    }
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
 
+const double kNoBound = std::numeric_limits<double>::infinity();
+
+// Soma dos quadrados das diferenças; a raiz fica para quem chama. Os kernels
+// verificam `bound` a cada DISTANCE_BLOCK floats e retornam a soma parcial
+// assim que ela o ultrapassa. Os acumuladores seguem os mesmos de um bloco
+// para o outro, então o resultado completo não depende de `bound`.
+using SquaredDistanceFn = double (*)(const float*, const float*, size_t, double);
+
+// Dim != DYNAMIC_DIMENSION fixa n em tempo de compilação (laços desenrolados)
+template <size_t Dim>
+double squaredReference(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
     double sum_of_squares = 0.0;
-    for (size_t i = 0; i < v1.size(); ++i) {
-        sum_of_squares += (v1[i] - v2[i]) * (v1[i] - v2[i]);
+    for (size_t start = 0; start < n; start += DISTANCE_BLOCK) {
+        const size_t end = std::min(n, start + DISTANCE_BLOCK);
+        for (size_t i = start; i < end; ++i) {
+            sum_of_squares += (a[i] - b[i]) * (a[i] - b[i]);
+        }
+        if (sum_of_squares > bound) break;
+    }
+    return sum_of_squares;
+}
+
+#if ANALISE_X86_DISPATCH
+
+ANALISE_TARGET("sse2")
+inline float horizontalSum(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+// Dois acumuladores independentes escondem a latência da soma
+template <size_t Dim>
+ANALISE_TARGET("sse2")
+double squaredSse2(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    while (i + DISTANCE_BLOCK <= n) {
+        for (const size_t end = i + DISTANCE_BLOCK; i < end; i += 8) {
+            __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+            __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+        }
+        if (i < n) {
+            const float partial = horizontalSum(_mm_add_ps(acc0, acc1));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(d, d));
+    }
+
+    float sum = horizontalSum(_mm_add_ps(acc0, acc1));
+    for (; i < n; ++i) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+ANALISE_TARGET("avx2,fma")
+inline float horizontalSum(__m256 v) {
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+
+template <size_t Dim>
+ANALISE_TARGET("avx2,fma")
+double squaredAvx2(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+    while (i + DISTANCE_BLOCK <= n) {
+        for (const size_t end = i + DISTANCE_BLOCK; i < end; i += 32) {
+            __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+            __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+            __m256 d2 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16));
+            __m256 d3 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24));
+            acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+            acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+            acc2 = _mm256_fmadd_ps(d2, d2, acc2);
+            acc3 = _mm256_fmadd_ps(d3, d3, acc3);
+        }
+        if (i < n) {
+            const float partial = horizontalSum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc0 = _mm256_fmadd_ps(d, d, acc0);
+    }
+
+    float sum = horizontalSum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; ++i) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+template <size_t Dim>
+ANALISE_TARGET("avx512f")
+double squaredAvx512(const float* a, const float* b, size_t n, double bound) {
+    if (Dim != DYNAMIC_DIMENSION) n = Dim;
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+    size_t i = 0;
+    // Um bloco de DISTANCE_BLOCK (64) floats por iteração
+    for (; i + 64 <= n; i += 64) {
+        __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+        __m512 d2 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32));
+        __m512 d3 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48));
+        acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+        acc2 = _mm512_fmadd_ps(d2, d2, acc2);
+        acc3 = _mm512_fmadd_ps(d3, d3, acc3);
+        if (i + 64 < n) {
+            const float partial = avx512::reduceAdd(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+            if (partial > bound) return partial;
+        }
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc0 = _mm512_fmadd_ps(d, d, acc0);
+    }
+    // Final com máscara: as lanes fora do vetor são carregadas como zero
+    if (i < n) {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+        acc1 = _mm512_fmadd_ps(d, d, acc1);
     }
 
-    return std::sqrt(sum_of_squares);
-}
\ No newline at end of file
+    return avx512::reduceAdd(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+}
+
+#endif // ANALISE_X86_DISPATCH
+
+template <size_t Dim>
+SquaredDistanceFn squaredDistanceFn(DistanceKernel kernel) {
+    switch (kernel) {
+#if ANALISE_X86_DISPATCH
+        case DistanceKernel::SSE2: return squaredSse2<Dim>;
+        case DistanceKernel::AVX2: return squaredAvx2<Dim>;
+        case DistanceKernel::AVX512: return squaredAvx512<Dim>;
+#endif
+        default: return squaredReference<Dim>;
+    }
+}
+
+// Kernel de DistanceKernel::Auto para cada dimensão, escolhido na primeira chamada
+template <size_t Dim>
+SquaredDistanceFn bestSquaredDistanceFn() {
+    static const SquaredDistanceFn fn = squaredDistanceFn<Dim>(bestDistanceKernel());
+    return fn;
+}
+
+SquaredDistanceFn selectedSquaredDistanceFn(DistanceKernel kernel) {
+    if (kernel != DistanceKernel::Auto && isDistanceKernelSupported(kernel)) {
+        return squaredDistanceFn<DYNAMIC_DIMENSION>(kernel);
+    }
+    return bestSquaredDistanceFn<DYNAMIC_DIMENSION>();
+}
+
+} // namespace
+
+double calculateEuclideanDistance(const FeatureVector& v1, const FeatureVector& v2) {
+    requireSameDimension(v1.size(), v2.size());
+
+    return std::sqrt(bestSquaredDistanceFn<DYNAMIC_DIMENSION>()(v1.data(), v2.data(), v1.size(), kNoBound));
+}
+
+double euclideanDistance(const float* a, const float* b, size_t dimension, DistanceKernel kernel) {
+    return std::sqrt(selectedSquaredDistanceFn(kernel)(a, b, dimension, kNoBound));
+}
+
+double squaredEuclideanDistance(const float* a, const float* b, size_t dimension, double bound,
+                                DistanceKernel kernel) {
+    return selectedSquaredDistanceFn(kernel)(a, b, dimension, bound);
+}
+
+template <size_t Dim>
+double squaredEuclideanDistance(const float* a, const float* b, size_t dimension, double bound) {
+    return bestSquaredDistanceFn<Dim>()(a, b, dimension, bound);
+}
+
+template double squaredEuclideanDistance<DYNAMIC_DIMENSION>(const float*, const float*, size_t, double);
+template double squaredEuclideanDistance<8>(const float*, const float*, size_t, double);
+template double squaredEuclideanDistance<64>(const float*, const float*, size_t, double);
+template double squaredEuclideanDistance<512>(const float*, const float*, size_t, double);
+
+double squaredEuclideanDistance(const FeatureVector& v1, const FeatureVector& v2, double bound) {
+    requireSameDimension(v1.size(), v2.size());
+
+    return squaredEuclideanDistance(v1.data(), v2.data(), v1.size(), bound);
+}
+
+bool isDistanceKernelSupported(DistanceKernel kernel) {
+    switch (kernel) {
+        case DistanceKernel::Reference:
+        case DistanceKernel::Auto:
+            return true;
+#if ANALISE_X86_DISPATCH
+        case DistanceKernel::SSE2:
+            return cpuFeatures().sse2;
+        case DistanceKernel::AVX2:
+            return cpuFeatures().avx2 && cpuFeatures().fma;
+        case DistanceKernel::AVX512:
+            return cpuFeatures().avx512f;
+#endif
+        default:
+            return false;
+    }
+}
+
+DistanceKernel bestDistanceKernel() {
+    if (isDistanceKernelSupported(DistanceKernel::AVX512)) return DistanceKernel::AVX512;
+    if (isDistanceKernelSupported(DistanceKernel::AVX2)) return DistanceKernel::AVX2;
+    if (isDistanceKernelSupported(DistanceKernel::SSE2)) return DistanceKernel::SSE2;
+    return DistanceKernel::Reference;
+}
+
+const char* distanceKernelName(DistanceKernel kernel) {
+    switch (kernel) {
+        case DistanceKernel::Reference: return "referencia";
+        case DistanceKernel::SSE2: return "sse2";
+        case DistanceKernel::AVX2: return "avx2";
+        case DistanceKernel::AVX512: return "avx512";
+        case DistanceKernel::Auto: return "auto";
+    }
+    return "?";
+}
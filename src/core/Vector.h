@@ -3,13 +3,151 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
-using FeatureVector = std::vector<float>;
+/**
+ * @brief Alocador com alinhamento fixo (64 bytes = uma linha de cache).
+ */
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+/**
+ * @brief Vetor de características. Os dados começam em uma linha de cache,
+ * então os kernels SIMD nunca cruzam linhas desnecessariamente.
+ */
+using FeatureVector = std::vector<float, AlignedAllocator<float>>;
+
+/**
+ * @brief Marca a versão com dimensão em tempo de execução nos templates por dimensão.
+ */
+const size_t DYNAMIC_DIMENSION = 0;
+
+/**
+ * @brief Implementações disponíveis da distância euclidiana.
+ */
+enum class DistanceKernel {
+    Reference, // laço original: acumula em double
+    SSE2,      // 8 floats por iteração
+    AVX2,      // 32 floats por iteração (FMA)
+    AVX512,    // 64 floats por iteração, final com máscara
+    Auto       // melhor kernel suportado pela CPU (escolhido uma vez)
+};
 
 /**
  * @brief Calcula a distância Euclidiana entre dois vetores de características.
  */
 double calculateEuclideanDistance(const FeatureVector& v1, const FeatureVector& v2);
 
-#endif // VECTOR_H
\ No newline at end of file
+/**
+ * @brief Distância euclidiana entre dois vetores de `dimension` floats.
+ *
+ * Sem verificação de tamanho: quem chama garante que os dois têm `dimension`
+ * posições. Os kernels SIMD acumulam em float (em várias lanes), então o
+ * resultado pode diferir da referência nos últimos dígitos.
+ */
+double euclideanDistance(const float* a, const float* b, size_t dimension,
+                         DistanceKernel kernel = DistanceKernel::Auto);
+
+/**
+ * @brief Floats comparados entre duas verificações do limite em
+ * squaredEuclideanDistance (múltiplo da largura de todos os kernels SIMD).
+ */
+const size_t DISTANCE_BLOCK = 64;
+
+/**
+ * @brief Quadrado da distância euclidiana, com abandono antecipado.
+ *
+ * Para ordenar candidatos a raiz é desnecessária. O vetor é comparado em
+ * blocos de DISTANCE_BLOCK floats; assim que a soma parcial passa de `bound`,
+ * a função retorna essa soma (que já é > bound) sem ler o resto. Um candidato
+ * só pode ser melhor que o atual se o resultado for <= bound, e nesse caso o
+ * valor é exato.
+ */
+double squaredEuclideanDistance(const float* a, const float* b, size_t dimension,
+                                double bound = std::numeric_limits<double>::infinity(),
+                                DistanceKernel kernel = DistanceKernel::Auto);
+
+/**
+ * @brief Versão para FeatureVector (verifica os tamanhos, como calculateEuclideanDistance).
+ */
+double squaredEuclideanDistance(const FeatureVector& v1, const FeatureVector& v2,
+                                double bound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Quadrado da distância com a dimensão como constante de compilação.
+ *
+ * Especializações: 8, 64 e 512 (histogramas RGB com 2, 4 e 8 bins por canal),
+ * com os laços desenrolados pelo compilador; `dimension` é ignorado. Com
+ * DYNAMIC_DIMENSION equivale à versão com `dimension` em tempo de execução.
+ * Os resultados são idênticos aos da versão sem template.
+ */
+template <size_t Dim>
+double squaredEuclideanDistance(const float* a, const float* b, size_t dimension,
+                                double bound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Lança std::invalid_argument se as dimensões forem diferentes
+ * (mesma verificação de calculateEuclideanDistance, para os laços com kernels sem verificação).
+ */
+inline void requireSameDimension(size_t a, size_t b) {
+    if (a != b) {
+        throw std::invalid_argument("Vetores devem ter o mesmo tamanho para calcular a distancia.");
+    }
+}
+
+/**
+ * @brief Chama fn(std::integral_constant<size_t, Dim>()) com Dim = dimension
+ * se houver especialização para ela, ou DYNAMIC_DIMENSION caso contrário.
+ * Usado pelos índices para escolher o laço de busca uma vez por consulta.
+ */
+template <typename Fn>
+decltype(auto) dispatchDimension(size_t dimension, Fn&& fn) {
+    switch (dimension) {
+        case 8: return fn(std::integral_constant<size_t, 8>());
+        case 64: return fn(std::integral_constant<size_t, 64>());
+        case 512: return fn(std::integral_constant<size_t, 512>());
+        default: return fn(std::integral_constant<size_t, DYNAMIC_DIMENSION>());
+    }
+}
+
+/**
+ * @brief Indica se o kernel pode ser executado na CPU atual.
+ */
+bool isDistanceKernelSupported(DistanceKernel kernel);
+
+/**
+ * @brief Kernel escolhido por DistanceKernel::Auto.
+ */
+DistanceKernel bestDistanceKernel();
+
+const char* distanceKernelName(DistanceKernel kernel);
+
+#endif // VECTOR_H
@@ -13,20 +13,37 @@
 #include <filesystem>
 #include <algorithm>
 #include <random>
+#include <cstdlib>
+#include <memory>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <thread>
 
 #include "core/Image.h"
 #include "core/Vector.h"
 #include "core/Timer.h"
+#include "core/ThreadPool.h"
+#include "core/FeatureCache.h"
+#include "core/FeatureMatrix.h"
+#include "core/FeatureStore.h"
+#include "core/HalfStore.h"
+#include "core/Metric.h"
+#include "core/QuantizedStore.h"
 #include "structure/List.h"
 #include "structure/HashTable.h"
 #include "structure/QuadTree.h"
 #include "structure/LSH.h"
 #include "structure/MTree.h"
+#include "structure/PQ.h"
 
 using namespace std;
 
 int randImageGlobal = 0;
 
+// Nome do arquivo de cache gravado dentro de cada pasta de imagens
+const char *const FEATURE_CACHE_FILE = ".feature_cache.bin";
+
 bool isImageFile(const string &filename)
 {
     string extension = filesystem::path(filename).extension().string();
@@ -34,47 +51,173 @@ bool isImageFile(const string &filename)
     return extension == ".jpg" || extension == ".jpeg" || extension == ".png";
 }
 
-ImageList processImagesFromFolder(const string &folder_path)
+struct Options
+{
+    size_t threads = 0; // 0 = todos os núcleos disponíveis
+    bool useCache = true;
+    size_t readAhead = 16; // buffers do estágio de leitura antecipada (0 = desligado)
+    bool quantize = false; // Lista, HashTable e LSH buscam pelos códigos de 8 bits
+    QuantizationRange quantizationRange = QuantizationRange::Global;
+    size_t shortlist = QUANTIZED_SHORTLIST;
+    bool half = false; // Lista e HashTable varrem cópias de 16 bits
+    HalfFormat halfFormat = HalfFormat::FP16;
+    int pqSubspaces = 8; // PQ: subespaços (bytes por imagem com 8 bits)
+    int pqBits = 8;
+    MetricKind metric = MetricKind::Euclidean; // Lista e M-Tree
+    bool live = false; // consultas durante a construção de Lista, LSH e M-Tree
+    ExtractionOptions extraction;
+};
+
+FeatureStore processImagesFromFolder(const string &folder_path, ThreadPool &pool, const Options &options)
 {
-    ImageList imageList;
+    const bool use_cache = options.useCache;
+
+    FeatureStore store;
 
     cout << "\nProcessando imagens da pasta: " << folder_path << endl;
     cout << "------------------------------------" << endl;
 
+    // Coleta os caminhos primeiro para que a ordem da lista seja a mesma da
+    // varredura serial, independente de qual thread termina antes.
+    vector<string> paths;
     try
     {
-        Timer timer;
         for (const auto &entry : filesystem::directory_iterator(folder_path))
         {
             if (entry.is_regular_file() && isImageFile(entry.path().string()))
             {
-                string img_path = entry.path().string();
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+    catch (const filesystem::filesystem_error &e)
+    {
+        throw runtime_error("Erro ao acessar a pasta: " + string(e.what()));
+    }
 
-                // cout << "Processando: " << entry.path().filename().string() << endl;
+    // Reaproveita as características de imagens que não mudaram desde a última execução
+    FeatureCache cache((filesystem::path(folder_path) / FEATURE_CACHE_FILE).string(), extractionConfigKey(options.extraction));
+    if (use_cache)
+    {
+        cache.load();
+    }
 
-                timer.start();
-                FeatureVector features = extractFeatures(img_path);
-                const double extraction_time = timer.elapsed_milliseconds();
+    // As características aceitas vão direto para o store, sem cópias intermediárias:
+    // cached[i] aponta para o mapeamento do cache e as extraídas ficam na matriz
+    vector<const float *> cached(paths.size(), nullptr);
+    vector<double> cached_times(paths.size(), 0.0);
+    vector<uint64_t> fileSizes(paths.size(), 0);
+    vector<int64_t> mtimes(paths.size(), 0);
+    vector<size_t> pending;
+    vector<double> error_bounds(paths.size(), 0.0);
 
-                //cout << "  -> Vetor de caracteristicas extraido com " << features.size() << " dimensoes." << endl;
-                //cout << "  -> Tempo de extracao: " << extraction_time << " ms" << endl;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (use_cache && FeatureCache::fileStamp(paths[i], fileSizes[i], mtimes[i]))
+        {
+            cached[i] = cache.lookup(paths[i], fileSizes[i], mtimes[i], &cached_times[i]);
+        }
 
-                ImageData img_data(img_path, features, extraction_time);
-                imageList.addImage(img_data);
-            }
+        if (!cached[i])
+        {
+            pending.push_back(i);
         }
     }
-    catch (const filesystem::filesystem_error &e)
+
+    // Extrai as imagens pendentes em lote, direto para uma matriz contígua
+    vector<string> pendingPaths;
+    pendingPaths.reserve(pending.size());
+    for (size_t i : pending)
     {
-        throw runtime_error("Erro ao acessar a pasta: " + string(e.what()));
+        pendingPaths.push_back(paths[i]);
     }
 
-    if (imageList.empty())
+    FeatureMatrix matrix;
+    vector<ExtractionRecord> records;
+    extractFeaturesBatch(pendingPaths, options.extraction, matrix, records, &pool, options.readAhead);
+
+    vector<size_t> pending_row(paths.size(), 0);
+    for (size_t p = 0; p < pending.size(); p++)
+    {
+        const size_t i = pending[p];
+        pending_row[i] = p;
+        if (!records[p].ok)
+        {
+            cerr << "Aviso: " << records[p].error << endl;
+            continue;
+        }
+        error_bounds[i] = records[p].error_bound;
+    }
+
+    // Monta o store na ordem da varredura; ids[i] = id da imagem i (ou -1 se falhou)
+    size_t path_bytes = 0;
+    for (const string &path : paths)
+    {
+        path_bytes += path.size();
+    }
+    store.reserve(paths.size(), pending.empty() ? cache.dimension() : matrix.cols(), path_bytes);
+
+    vector<int64_t> ids(paths.size(), -1);
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (cached[i])
+        {
+            ids[i] = store.add(paths[i], cached[i], cache.dimension(), cached_times[i]);
+        }
+        else if (records[pending_row[i]].ok)
+        {
+            const size_t p = pending_row[i];
+            ids[i] = store.add(paths[i], matrix.row(p), matrix.cols(), records[p].time_ms);
+        }
+    }
+
+    if (options.extraction.sample_stride > 1 && !pending.empty())
+    {
+        double mean_bound = 0.0;
+        for (size_t i : pending)
+        {
+            mean_bound += error_bounds[i];
+        }
+        cout << "Amostragem (passo " << options.extraction.sample_stride << "): erro RMS esperado <= "
+             << mean_bound / pending.size() << " (media das imagens extraidas)" << endl;
+    }
+
+    if (use_cache)
+    {
+        cout << "Cache de caracteristicas: " << (paths.size() - pending.size()) << " de " << paths.size()
+             << " imagens reaproveitadas" << endl;
+
+        // Regrava o cache se houve imagens novas, modificadas ou removidas
+        if (!pending.empty() || cache.loadedCount() != paths.size())
+        {
+            FeatureCache updated((filesystem::path(folder_path) / FEATURE_CACHE_FILE).string(), extractionConfigKey(options.extraction));
+            for (size_t i = 0; i < paths.size(); i++)
+            {
+                if (ids[i] < 0)
+                {
+                    continue;
+                }
+                const uint32_t id = static_cast<uint32_t>(ids[i]);
+                updated.add(paths[i], fileSizes[i], mtimes[i], store.features(id), store.dimension(),
+                            store.extractionTime(id));
+            }
+            try
+            {
+                updated.save();
+            }
+            catch (const exception &e)
+            {
+                cerr << "Aviso: " << e.what() << endl;
+            }
+        }
+    }
+
+    if (store.empty())
     {
         throw runtime_error("Nenhuma imagem válida encontrada na pasta especificada.");
     }
 
-    return imageList;
+    return store;
 }
 
 ImageData loadReferenceImage(const string &reference_folder)
@@ -97,7 +240,18 @@ ImageData loadReferenceImage(const string &reference_folder)
     throw runtime_error("Nenhuma imagem válida encontrada na pasta de referência.");
 }
 
-void testSimilarity(const ImageList &imageList, const ImageData &refImage)
+// Rótulo da distância no relatório: fora da euclidiana o nome da métrica vem
+// junto, para a Lista e a M-Tree não parecerem comparáveis quando não são
+template <typename Metric>
+string distanceLabel()
+{
+    if (is_same_v<Metric, EuclideanMetric>)
+        return " | Distancia: ";
+    return string(" | Distancia ") + metricName(Metric::kind) + ": ";
+}
+
+template <typename Metric>
+void testSimilarity(const BasicImageList<Metric> &imageList, const ImageData &refImage)
 {
     if (imageList.size() < 2)
     {
@@ -109,20 +263,24 @@ void testSimilarity(const ImageList &imageList, const ImageData &refImage)
     int nearestIndex = imageList.findNearest(refImage.features, -1);
     if (nearestIndex >= 0)
     {
-        const ImageData &nearest = imageList.getImage(nearestIndex);
+        const ImageRef nearest = imageList.getImage(nearestIndex);
         cout << "Comparando:" << endl;
         cout << "  Imagem referência: " << filesystem::path(refImage.path).filename().string() << endl;
         cout << "  Imagem mais próxima: " << filesystem::path(nearest.path).filename().string() << endl;
         Timer timer;
         timer.start();
-        const double distance = calculateEuclideanDistance(refImage.features, nearest.features);
-        cout << "Distancia euclidiana: " << distance << endl;
+        const double distance = metricDistance<Metric>(refImage.features.data(), nearest.features, nearest.dimension);
+        cout << "Distancia " << metricName(Metric::kind) << ": " << distance << endl;
         const double calculationTime = timer.elapsed_milliseconds();
         cout << "Tempo de calculo: " << calculationTime << " ms" << endl;
     }
 }
 
-void testListSearch(const ImageList &imageList, const ImageData &refImage)
+// nearestIndex e searchTime vêm da busca em lote (findNearestBatch) feita
+// antes do laço das referências; o tempo é o do lote dividido pelas consultas
+template <typename Metric>
+void testListSearch(const BasicImageList<Metric> &imageList, const ImageData &refImage, const int nearestIndex,
+                    const double searchTime)
 {
     if (imageList.size() < 2)
     {
@@ -131,21 +289,17 @@ void testListSearch(const ImageList &imageList, const ImageData &refImage)
     }
     //cout << "\n=== Teste de Busca com Lista ===" << endl;
     cout << endl <<"Imagem de consulta: " << filesystem::path(refImage.path).filename().string() << endl;
-    Timer timer;
-    timer.start();
-    const int nearestIndex = imageList.findNearest(refImage.features, -1);
-    const double searchTime = timer.elapsed_milliseconds();
     if (nearestIndex >= 0)
     {
-        const ImageData &result = imageList.getImage(nearestIndex);
+        const ImageRef result = imageList.getImage(nearestIndex);
         //cout << "  -> Imagem mais proxima: " << filesystem::path(result.path).filename().string() << endl;
         //cout << "  -> Tempo de busca: " << searchTime << " ms" << endl;
         //cout << "  -> Comparacoes realizadas: " << imageList.size() << endl;
-        //cout << "  -> Distancia: " << calculateEuclideanDistance(refImage.features, result.features) << endl;
+        //cout << "  -> Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension) << endl;
 
         cout << "[Lista]     -> "
             << filesystem::path(result.path).filename().string()
-            << " | Distancia: " << calculateEuclideanDistance(refImage.features, result.features)
+            << distanceLabel<Metric>() << metricDistance<Metric>(refImage.features.data(), result.features, result.dimension)
             << " | Tempo: " << searchTime << " ms"
             << " | Comparacoes: " << imageList.size() 
             << endl;        
@@ -167,15 +321,15 @@ void testHashTableSearch(const HashTable &hashTable, const ImageData &refImage)
     const double searchTime = timer.elapsed_milliseconds();
     if (nearestIndex >= 0)
     {
-        const ImageData &result = hashTable.getImage(nearestIndex);
+        const ImageRef result = hashTable.getImage(nearestIndex);
        // cout << "  -> Imagem mais proxima: " << filesystem::path(result.path).filename().string() << endl;
        // cout << "  -> Tempo de busca: " << searchTime << " ms" << endl;
        // cout << "  -> Comparacoes realizadas: " << hashTable.size() << endl;
-       // cout << "  -> Distancia: " << calculateEuclideanDistance(refImage.features, result.features) << endl;
+       // cout << "  -> Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension) << endl;
 
         cout << "[HashTable] -> "
             << filesystem::path(result.path).filename().string()
-            << " | Distancia: " << calculateEuclideanDistance(refImage.features, result.features)
+            << " | Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension)
             << " | Tempo: " << searchTime << " ms"
             << " | Comparacoes: " << hashTable.size()
             << endl;
@@ -198,15 +352,15 @@ void testQuadTreeSearch(const QuadTree &quadTree, const ImageData &refImage)
     const double searchTime = timer.elapsed_milliseconds();
     if (nearestIndex >= 0)
     {
-        const ImageData &result = quadTree.getImage(nearestIndex);
+        const ImageRef result = quadTree.getImage(nearestIndex);
         //cout << "  -> Imagem mais proxima: " << filesystem::path(result.path).filename().string() << endl;
         //cout << "  -> Tempo de busca: " << searchTime << " ms" << endl;
         //cout << "  -> Comparacoes realizadas: " << comparisons << endl;
-        //cout << "  -> Distancia: " << calculateEuclideanDistance(refImage.features, result.features) << endl;
+        //cout << "  -> Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension) << endl;
 
         cout << "[QuadTree]  -> "
             << filesystem::path(result.path).filename().string()
-            << " | Distancia: " << calculateEuclideanDistance(refImage.features, result.features)
+            << " | Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension)
             << " | Tempo: " << searchTime << " ms"
             << " | Comparacoes: " << comparisons
             << endl;
@@ -232,15 +386,15 @@ void testLSHSearch(const LSH &lsh, const ImageData &refImage)
 
     if (nearestIndex >= 0)
     {
-        const ImageData &result = lsh.getImage(nearestIndex);
+        const ImageRef result = lsh.getImage(nearestIndex);
         //cout << "  -> Imagem mais proxima: " << filesystem::path(result.path).filename().string() << endl;
         //cout << "  -> Tempo de busca: " << searchTime << " ms" << endl;
         //cout << "  -> Candidatos analisados (Comparacoes): " << comparisons << endl;
-        //cout << "  -> Distancia: " << calculateEuclideanDistance(refImage.features, result.features) << endl;
+        //cout << "  -> Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension) << endl;
 
         cout << "[LSH]       -> "
             << filesystem::path(result.path).filename().string()
-            << " | Distancia: " << calculateEuclideanDistance(refImage.features, result.features)
+            << " | Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension)
             << " | Tempo: " << searchTime << " ms"
             << " | Candidatos: " << comparisons
             << endl;
@@ -251,7 +405,8 @@ void testLSHSearch(const LSH &lsh, const ImageData &refImage)
     }
 }
 
-void testMTreeSearch(const MTree &mtree, const ImageData &refImage)
+template <typename Metric>
+void testMTreeSearch(const BasicMTree<Metric> &mtree, const ImageData &refImage)
 {
     if (mtree.size() < 2)
     {
@@ -271,15 +426,15 @@ void testMTreeSearch(const MTree &mtree, const ImageData &refImage)
     
     if (nearestIndex >= 0)
     {
-        const ImageData &result = mtree.getImage(nearestIndex);
+        const ImageRef result = mtree.getImage(nearestIndex);
         //cout << "  -> Imagem mais proxima: " << filesystem::path(result.path).filename().string() << endl;
         //cout << "  -> Tempo de busca: " << searchTime << " ms" << endl;
         //cout << "  -> Comparacoes realizadas: " << comparisons << endl;
-        //cout << "  -> Distancia: " << calculateEuclideanDistance(refImage.features, result.features) << endl;
+        //cout << "  -> Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension) << endl;
 
         cout << "[M-Tree]    -> "
             << filesystem::path(result.path).filename().string()
-            << " | Distancia: " << calculateEuclideanDistance(refImage.features, result.features)
+            << distanceLabel<Metric>() << metricDistance<Metric>(refImage.features.data(), result.features, result.dimension)
             << " | Tempo: " << searchTime << " ms"
             << " | Comparacoes: " << comparisons
             << endl;
@@ -288,87 +443,545 @@ void testMTreeSearch(const MTree &mtree, const ImageData &refImage)
     }
 }
 
-
-int main()
+// Retorna o id encontrado pelo PQ (para o recall contra a busca exata da lista)
+int testPQSearch(const PQ &pq, const ImageData &refImage)
 {
-    const string images_folder = "images";
-    const string reference_folder = "imageReference";
+    if (pq.size() < 2)
+        return -1;
 
-    try
+    Timer timer;
+    timer.start();
+
+    int comparisons = 0;
+    const int nearestIndex = pq.findNearest(refImage.features, -1, &comparisons);
+    const double searchTime = timer.elapsed_milliseconds();
+
+    if (nearestIndex >= 0)
     {
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_int_distribution<> distrib(1, 10000);
-        BoundingBox globalRegion = {0, 255, 0, 255};
-        QuadTree quadTree(globalRegion, 4, 10);
+        const ImageRef result = pq.getImage(nearestIndex);
+        cout << "[PQ]        -> "
+            << filesystem::path(result.path).filename().string()
+            << " | Distancia: " << euclideanDistance(refImage.features.data(), result.features, result.dimension)
+            << " | Tempo: " << searchTime << " ms"
+            << " | Comparacoes: " << comparisons
+            << endl;
+    }
+    return nearestIndex;
+}
 
-        cout << "=== Sistema de Busca de Imagens ===" << endl;
+// Deriva da busca em 16 bits nos conjuntos carregados: cada referência contra
+// a base e cada imagem da base contra as demais, pelos floats e pela cópia
+void reportHalfDrift(const FeatureStore &store, const FeatureStore &referenceStore, const HalfStore &half)
+{
+    const size_t dimension = store.dimension();
+    size_t same = 0, queries = 0;
+    double worstExcess = 0.0, worstError = 0.0;
 
-        const ImageList imageList = processImagesFromFolder(images_folder);
-        const ImageList imageListReference = processImagesFromFolder(reference_folder);
-        cout << "\nTotal de imagens carregadas na lista de imagem: " << imageList.size() << endl;
-        cout << "\nTotal de imagens carregadas na lista de imagem de referencia: " << imageListReference.size() << endl;
+    auto compare = [&](const float *query, int ignoreId)
+    {
+        double exactSquared = numeric_limits<double>::infinity();
+        int exact = -1;
+        for (uint32_t id = 0; id < store.size(); id++)
+        {
+            if (static_cast<int>(id) == ignoreId)
+                continue;
+            const double d = squaredEuclideanDistance(query, store.features(id), dimension, exactSquared);
+            if (d < exactSquared)
+            {
+                exactSquared = d;
+                exact = static_cast<int>(id);
+            }
+        }
 
-        //ImageData referenceImage = loadReferenceImage(reference_folder);
+        double halfSquared = numeric_limits<double>::infinity();
+        const int found = half.nearestAmong<DYNAMIC_DIMENSION>(query, nullptr, 0, store.size(), ignoreId, halfSquared);
+        if (exact < 0 || found < 0)
+            return;
+
+        // Quanto o vizinho escolhido está mais longe que o exato, e o erro da
+        // distância calculada pela cópia em relação aos floats
+        const double exactDistance = sqrt(exactSquared);
+        const double foundDistance = euclideanDistance(query, store.features(found), dimension);
+        queries++;
+        same += found == exact;
+        if (exactDistance > 0.0)
+            worstExcess = max(worstExcess, (foundDistance - exactDistance) / exactDistance);
+        if (foundDistance > 0.0)
+            worstError = max(worstError, fabs(sqrt(halfSquared) - foundDistance) / foundDistance);
+    };
+
+    for (uint32_t i = 0; i < referenceStore.size(); i++)
+        compare(referenceStore.features(i), -1);
+    for (uint32_t i = 0; i < store.size(); i++)
+        compare(store.features(i), static_cast<int>(i));
+
+    if (queries == 0)
+        return;
+    cout << "\nDeriva do " << halfFormatName(half.format()) << " contra float32 (" << queries
+         << " consultas): " << same << "/" << queries << " vizinhos iguais (" << 100.0 * same / queries
+         << "%), vizinho ate " << 100.0 * worstExcess << "% mais distante, erro da distancia ate "
+         << 100.0 * worstError << "%" << endl;
+}
+
+void printUsage(const char *program)
+{
+    cout << "Uso: " << program << " [--threads N] [--no-cache] [--read-ahead N] [--bins N] [--hsv N] [--grid N] [--grid-bins N]"
+         << " [--sample-stride N] [--quasi-random] [--jpeg-scale N] [--quantize global|dim] [--shortlist N]"
+         << " [--half fp16|bf16] [--pq-subspaces N] [--pq-bits 4|8] [--metric NOME] [--live]" << endl;
+    cout << "  --threads N   Threads usadas na extração de características (padrão: todos os núcleos)" << endl;
+    cout << "  --no-cache    Ignora o cache de características gravado em cada pasta" << endl;
+    cout << "  --read-ahead N     Arquivos lidos à frente dos decodificadores (padrão: 16; 0 = desligado)" << endl;
+    cout << "  --bins N           Bins por canal do histograma RGB (padrão: 4 = 64 dimensões; 8 = 512; 16 = 4096)" << endl;
+    cout << "  --hsv N            Acrescenta um histograma HSV com N bins por canal (padrão: 0, desligado)" << endl;
+    cout << "  --grid N           Acrescenta histogramas RGB por célula de uma grade N x N (padrão: 0, desligado)" << endl;
+    cout << "  --grid-bins N      Bins por canal de cada célula da grade (padrão: 2)" << endl;
+    cout << "  --sample-stride N  Estima o histograma com 1 a cada N x N pixels (padrão: 1, todos)" << endl;
+    cout << "  --quasi-random     Amostra os pixels pela sequência R2 em vez de uma grade" << endl;
+    cout << "  --jpeg-scale N     Decodifica JPEGs em 1/N da resolução (2, 4 ou 8 = só coeficientes DC)" << endl;
+    cout << "  --quantize MODO    Lista, HashTable e LSH varrem cópias de 8 bits das características, com faixa"
+         << " global ou por dimensão (dim), e reordenam os melhores com os floats" << endl;
+    cout << "  --shortlist N      Candidatos reordenados com os floats na busca quantizada (padrão: 32)" << endl;
+    cout << "  --half FORMATO     Lista e HashTable varrem cópias de 16 bits (fp16 ou bf16) das características"
+         << " e a deriva contra float32 é medida nos conjuntos carregados" << endl;
+    cout << "  --pq-subspaces N   Subespaços do índice PQ (padrão: 8)" << endl;
+    cout << "  --pq-bits N        Bits por código do PQ: 8 ou 4 (fast-scan) (padrão: 8)" << endl;
+    cout << "  --metric NOME      Distância da Lista e da M-Tree: euclidiana, l1, chi2, intersecao, hellinger"
+         << " ou cosseno (padrão: euclidiana; fora dela HashTable, QuadTree, LSH e PQ não são comparados,"
+         << " e com chi2, intersecao ou cosseno a M-Tree usa a euclidiana)" << endl;
+    cout << "  --live             Antes das buscas, insere as imagens em Lista, LSH e M-Tree em uma thread"
+         << " enquanto as referências são consultadas em outra" << endl;
+}
 
-        // construção da HashTable
-        HashTable hashTable(101);
-        for (size_t i = 0; i < imageList.size(); i++)
+Options parseArguments(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        const string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = static_cast<size_t>(stoul(argv[++i]));
+        }
+        else if (arg == "--no-cache")
+        {
+            options.useCache = false;
+        }
+        else if (arg == "--read-ahead" && i + 1 < argc)
+        {
+            options.readAhead = static_cast<size_t>(stoul(argv[++i]));
+        }
+        else if (arg == "--bins" && i + 1 < argc)
+        {
+            options.extraction.bins_per_channel = stoi(argv[++i]);
+            if (options.extraction.bins_per_channel < 1 || options.extraction.bins_per_channel > 64)
+            {
+                throw invalid_argument("--bins deve estar entre 1 e 64");
+            }
+        }
+        else if (arg == "--hsv" && i + 1 < argc)
+        {
+            options.extraction.hsv_bins = stoi(argv[++i]);
+            if (options.extraction.hsv_bins < 0 || options.extraction.hsv_bins > 32)
+            {
+                throw invalid_argument("--hsv deve estar entre 0 e 32");
+            }
+        }
+        else if (arg == "--grid" && i + 1 < argc)
+        {
+            options.extraction.grid_size = stoi(argv[++i]);
+            if (options.extraction.grid_size < 0 || options.extraction.grid_size > 16)
+            {
+                throw invalid_argument("--grid deve estar entre 0 e 16");
+            }
+        }
+        else if (arg == "--grid-bins" && i + 1 < argc)
+        {
+            options.extraction.grid_bins = stoi(argv[++i]);
+            if (options.extraction.grid_bins < 1 || options.extraction.grid_bins > 16)
+            {
+                throw invalid_argument("--grid-bins deve estar entre 1 e 16");
+            }
+        }
+        else if (arg == "--sample-stride" && i + 1 < argc)
+        {
+            options.extraction.sample_stride = max(1, stoi(argv[++i]));
+        }
+        else if (arg == "--quasi-random")
+        {
+            options.extraction.sampling_pattern = SamplingPattern::QuasiRandom;
+        }
+        else if (arg == "--jpeg-scale" && i + 1 < argc)
         {
-            hashTable.addImage(imageList.getImage(i));
+            options.extraction.jpeg_scale = stoi(argv[++i]);
+            if (options.extraction.jpeg_scale != 1 && options.extraction.jpeg_scale != 2 &&
+                options.extraction.jpeg_scale != 4 && options.extraction.jpeg_scale != 8)
+            {
+                throw invalid_argument("--jpeg-scale deve ser 1, 2, 4 ou 8");
+            }
+        }
+        else if (arg == "--quantize" && i + 1 < argc)
+        {
+            const string mode = argv[++i];
+            if (mode != "global" && mode != "dim")
+            {
+                throw invalid_argument("--quantize deve ser global ou dim");
+            }
+            options.quantize = true;
+            options.quantizationRange = mode == "dim" ? QuantizationRange::PerDimension : QuantizationRange::Global;
+        }
+        else if (arg == "--shortlist" && i + 1 < argc)
+        {
+            options.shortlist = max<size_t>(1, stoul(argv[++i]));
+        }
+        else if (arg == "--half" && i + 1 < argc)
+        {
+            const string format = argv[++i];
+            if (format != "fp16" && format != "bf16")
+            {
+                throw invalid_argument("--half deve ser fp16 ou bf16");
+            }
+            options.half = true;
+            options.halfFormat = format == "bf16" ? HalfFormat::BF16 : HalfFormat::FP16;
+        }
+        else if (arg == "--pq-subspaces" && i + 1 < argc)
+        {
+            options.pqSubspaces = stoi(argv[++i]);
+            if (options.pqSubspaces < 1)
+            {
+                throw invalid_argument("--pq-subspaces deve ser pelo menos 1");
+            }
         }
+        else if (arg == "--pq-bits" && i + 1 < argc)
+        {
+            options.pqBits = stoi(argv[++i]);
+            if (options.pqBits != 4 && options.pqBits != 8)
+            {
+                throw invalid_argument("--pq-bits deve ser 4 ou 8");
+            }
+        }
+        else if (arg == "--metric" && i + 1 < argc)
+        {
+            if (!metricFromName(argv[++i], options.metric))
+            {
+                throw invalid_argument("--metric deve ser euclidiana, l1, chi2, intersecao, hellinger ou cosseno");
+            }
+        }
+        else if (arg == "--live")
+        {
+            options.live = true;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage(argv[0]);
+            exit(0);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            throw invalid_argument("Argumento desconhecido: " + arg);
+        }
+    }
+    if (options.quantize && options.metric != MetricKind::Euclidean)
+    {
+        throw invalid_argument("--quantize só pode ser usado com --metric euclidiana");
+    }
+    if (options.half && (options.quantize || options.metric != MetricKind::Euclidean))
+    {
+        throw invalid_argument("--half não pode ser combinado com --quantize e só vale com --metric euclidiana");
+    }
+    return options;
+}
+
+// --live: uma thread copia as imagens para um store novo e as insere na
+// Lista, no LSH e na M-Tree enquanto esta consulta as referências sem parar;
+// cada consulta vê um retrato (as imagens publicadas quando ela começou)
+void runLiveIngestion(const FeatureStore &store, const FeatureStore &referenceStore)
+{
+    cout << "\n=== Ingestao ao vivo ===" << endl;
+
+    FeatureStore live;
+    ImageList imageList(live);
+    LSH lshIndex(live, static_cast<int>(store.dimension()), 5, 12);
+    MTree mtree(live, 10);
 
-        // construção da QuadTree
-        for (size_t i = 0; i < imageList.size(); i++)
+    atomic<bool> done(false);
+    Timer timer;
+    timer.start();
+    thread writer([&]()
+                  {
+        for (uint32_t id = 0; id < store.size(); id++)
         {
-            FeatureVector pos = {imageList.getImage(i).features[0], imageList.getImage(i).features[1]};
-            quadTree.insert(imageList.getImage(i), pos, i);
+            const uint32_t liveId = live.add(store.path(id), store.features(id), store.dimension(),
+                                             store.extractionTime(id));
+            imageList.addImage(liveId);
+            lshIndex.addImage(liveId);
+            mtree.insert(liveId);
         }
+        done.store(true, memory_order_release); });
 
-        // Construção do LSH
-        int vecDim = imageList.size() > 0 ? imageList.getImage(0).features.size() : 64;
-        LSH lshIndex(vecDim, 5, 12);
-        //cout << "Construindo índice LSH..." << endl;
-        for (size_t i = 0; i < imageList.size(); i++)
+    // Rodadas durante a inserção e uma última com tudo publicado
+    vector<FeatureVector> queries;
+    for (uint32_t i = 0; i < referenceStore.size(); i++)
+        queries.push_back(referenceStore.copyFeatures(i));
+
+    size_t rounds = 0, minVisible = store.size(), maxVisible = 0;
+    bool finished = false;
+    while (!finished)
+    {
+        finished = done.load(memory_order_acquire);
+        for (const FeatureVector &query : queries)
         {
-            lshIndex.addImage(imageList.getImage(i));
+            const size_t visible = imageList.size();
+            minVisible = min(minVisible, visible);
+            maxVisible = max(maxVisible, visible);
+            int comparisons = 0;
+            imageList.findNearest(query, -1);
+            lshIndex.findNearest(query, -1, &comparisons);
+            mtree.findNearest(query, -1, comparisons);
         }
+        rounds++;
+    }
+    writer.join();
+    const double elapsed = timer.elapsed_milliseconds();
+
+    cout << "Imagens inseridas: " << live.size() << " em " << elapsed << " ms, com " << rounds
+         << " rodadas de consultas no meio (retratos de " << minVisible << " a " << maxVisible << " imagens)" << endl;
+
+    // Com a inserção concluída os índices respondem como os montados antes das buscas
+    for (uint32_t i = 0; i < referenceStore.size(); i++)
+    {
+        int comparisons = 0;
+        const int listNearest = imageList.findNearest(queries[i], -1);
+        const int treeNearest = mtree.findNearest(queries[i], -1, comparisons);
+        const int lshNearest = lshIndex.findNearest(queries[i], -1, &comparisons);
+        cout << filesystem::path(string(referenceStore.path(i))).filename().string() << " -> Lista: "
+             << (listNearest >= 0 ? filesystem::path(string(live.path(listNearest))).filename().string() : "-")
+             << " | M-Tree: "
+             << (treeNearest >= 0 ? filesystem::path(string(live.path(treeNearest))).filename().string() : "-")
+             << " | LSH: "
+             << (lshNearest >= 0 ? filesystem::path(string(live.path(lshNearest))).filename().string() : "-")
+             << endl;
+    }
+}
 
-        // Construção da M-Tree
-        MTree mtree(10); // capacidade de 10 entradas por nó
-        //cout << "Construindo índice M-Tree..." << endl;
-        for (size_t i = 0; i < imageList.size(); i++)
+// Índices e buscas com a métrica escolhida em --metric. HashTable, QuadTree,
+// LSH e PQ só sabem buscar pela euclidiana: com outra métrica eles ficam de
+// fora da comparação, que passa a ser só entre a Lista e a M-Tree.
+template <typename Metric>
+void runSearches(const FeatureStore &store, const FeatureStore &referenceStore, ThreadPool &pool,
+                 const Options &options)
+{
+    constexpr bool euclidean = is_same_v<Metric, EuclideanMetric>;
+    cout << "Metrica da Lista e da M-Tree: " << metricName(Metric::kind) << endl;
+    if (!euclidean)
+    {
+        cout << "Aviso: HashTable, QuadTree, LSH e PQ só buscam pela euclidiana; com --metric "
+             << metricName(Metric::kind) << " eles não são construídos nem comparados." << endl;
+    }
+    if (!Metric::isMetric)
+    {
+        cout << "Aviso: " << metricName(Metric::kind)
+             << " não satisfaz a desigualdade triangular; a M-Tree é construída com a euclidiana e a sua"
+                " distância não é comparável à da Lista."
+             << endl;
+    }
+
+    // construção da lista
+    BasicImageList<Metric> imageList(store);
+    for (uint32_t id = 0; id < store.size(); id++)
+    {
+        imageList.addImage(id);
+    }
+
+    // Índices só euclidianos: vazios (e fora do relatório) com outra métrica
+    const uint32_t euclideanCount = euclidean ? static_cast<uint32_t>(store.size()) : 0;
+
+    // construção da HashTable
+    HashTable hashTable(store, 101);
+    for (uint32_t id = 0; id < euclideanCount; id++)
+    {
+        hashTable.addImage(id);
+    }
+
+    // construção da QuadTree
+    BoundingBox globalRegion = {0, 255, 0, 255};
+    QuadTree quadTree(store, globalRegion, 4, 10);
+    for (uint32_t id = 0; id < euclideanCount; id++)
+    {
+        FeatureVector pos = {store.features(id)[0], store.features(id)[1]};
+        quadTree.insert(id, pos);
+    }
+
+    // Construção do LSH
+    int vecDim = store.size() > 0 ? static_cast<int>(store.dimension()) : 64;
+    LSH lshIndex(store, vecDim, 5, 12);
+    //cout << "Construindo índice LSH..." << endl;
+    for (uint32_t id = 0; id < euclideanCount; id++)
+    {
+        lshIndex.addImage(id);
+    }
+
+    // Construção da M-Tree (métricas sem desigualdade triangular usam a euclidiana)
+    using TreeMetric = conditional_t<Metric::isMetric, Metric, EuclideanMetric>;
+    BasicMTree<TreeMetric> mtree(store, 10); // capacidade de 10 entradas por nó
+    //cout << "Construindo índice M-Tree..." << endl;
+    // Sem leitores ainda: um único lote, publicado uma vez
+    vector<uint32_t> treeIds(store.size());
+    for (uint32_t id = 0; id < store.size(); id++)
+    {
+        treeIds[id] = id;
+    }
+    mtree.insertBatch(treeIds.data(), treeIds.size());
+
+    // Construção do PQ (dicionários treinados no próprio conjunto)
+    const int pqSubspaces = store.empty() ? options.pqSubspaces
+                                          : min(options.pqSubspaces, static_cast<int>(store.dimension()));
+    PQ pq(store, pqSubspaces, options.pqBits);
+    if (euclidean)
+    {
+        pq.train(4096, 16, 42, &pool);
+    }
+    for (uint32_t id = 0; id < euclideanCount; id++)
+    {
+        pq.addImage(id);
+    }
+
+    // Cópia de 8 bits opcional: as varreduras leem 1/4 dos bytes
+    unique_ptr<QuantizedStore> quantized;
+    if (options.quantize)
+    {
+        quantized = make_unique<QuantizedStore>(store, options.quantizationRange);
+        imageList.useQuantized(quantized.get(), options.shortlist);
+        hashTable.useQuantized(quantized.get(), options.shortlist);
+        lshIndex.useQuantized(quantized.get(), options.shortlist);
+        cout << "Quantização de 8 bits: " << quantized->memoryBytes() / 1024 << " KiB (floats: "
+             << store.memoryBytes() / 1024 << " KiB)" << endl;
+    }
+
+    // Cópia de 16 bits opcional: as varreduras leem metade dos bytes
+    unique_ptr<HalfStore> half;
+    if (options.half)
+    {
+        half = make_unique<HalfStore>(store, options.halfFormat);
+        imageList.useHalf(half.get());
+        hashTable.useHalf(half.get());
+        cout << "Cópia " << halfFormatName(half->format()) << ": " << half->memoryBytes() / 1024
+             << " KiB (floats: " << store.memoryBytes() / 1024 << " KiB)" << endl;
+    }
+
+    /** /
+    cout << "\nTotal de imagens armazenadas na HashTable: " << hashTable.size() << endl;
+    cout << "\nTotal de imagens armazenadas na QuadTree: " << quadTree.size() << endl;
+    cout << "Total de imagens na LSH: " << lshIndex.size() << endl; 
+    cout << "Total de imagens na M-Tree: " << mtree.size() << endl;
+    /**/
+    // Todas as referências contra a lista de uma vez: cada bloco da base é
+    // lido uma vez para o lote inteiro em vez de uma vez por consulta
+    Timer batchTimer;
+    batchTimer.start();
+    // (o lote é sempre exato; com a quantização ou os 16 bits as consultas vão uma a uma)
+    vector<int> listNearest;
+    if (quantized || half)
+    {
+        FeatureVector query;
+        for (uint32_t i = 0; i < referenceStore.size(); i++)
         {
-            mtree.insert(imageList.getImage(i), static_cast<int>(i));
+            query.assign(referenceStore.features(i), referenceStore.features(i) + referenceStore.dimension());
+            listNearest.push_back(imageList.findNearest(query, -1, &pool));
         }
+    }
+    else
+    {
+        listNearest = imageList.findNearestBatch(referenceStore, &pool);
+    }
+    const double listSearchTime =
+        referenceStore.empty() ? 0.0 : batchTimer.elapsed_milliseconds() / referenceStore.size();
 
-        /** /
-        cout << "\nTotal de imagens armazenadas na HashTable: " << hashTable.size() << endl;
-        cout << "\nTotal de imagens armazenadas na QuadTree: " << quadTree.size() << endl;
-        cout << "Total de imagens na LSH: " << lshIndex.size() << endl; 
-        cout << "Total de imagens na M-Tree: " << mtree.size() << endl;
-        /**/
-        ImageData referenceImage;
-        for (int i = 0; i < imageListReference.size(); i++) 
+    ImageData referenceImage;
+    size_t pqHits = 0, pqQueries = 0;
+    for (uint32_t i = 0; i < referenceStore.size(); i++) 
+    {
+        // A consulta é a única cópia, feita direto da linha do store para os
+        // buffers de referenceImage (reaproveitados: sem alocação por imagem)
+        referenceImage.path.assign(referenceStore.path(i));
+        referenceImage.features.assign(referenceStore.features(i),
+                                       referenceStore.features(i) + referenceStore.dimension());
+        referenceImage.extraction_time = referenceStore.extractionTime(i);
+        //testSimilarity(imageList, referenceImage);
+        testListSearch(imageList, referenceImage, listNearest[i], listSearchTime);
+        if (euclidean)
         {
-            referenceImage = imageListReference.getImage(i);
-            //testSimilarity(imageList, referenceImage);
-            testListSearch(imageList, referenceImage);  
             testHashTableSearch(hashTable, referenceImage);
             testQuadTreeSearch(quadTree, referenceImage);
             testLSHSearch(lshIndex, referenceImage);
-            testMTreeSearch(mtree, referenceImage);
         }
+        testMTreeSearch(mtree, referenceImage);
+        if (euclidean)
+        {
+            // O PQ aproxima a distância euclidiana: o recall só compara com ela
+            const int pqNearest = testPQSearch(pq, referenceImage);
+            if (pq.size() >= 2)
+            {
+                pqQueries++;
+                pqHits += pqNearest == listNearest[i];
+            }
+        }
+    }
 
-        /** / 
-        //testSimilarity(imageList, referenceImage);
-        //testListSearch(imageList, referenceImage);
-        //testHashTableSearch(hashTable, referenceImage);
-        //testQuadTreeSearch(quadTree, referenceImage);
-        //testLSHSearch(lshIndex, referenceImage);
-        //testMTreeSearch(mtree, referenceImage);
-        /**/
+    if (pqQueries > 0)
+    {
+        cout << "\nRecall@1 do PQ (" << pq.subspaces() << " subespacos, " << pq.bits() << " bits, "
+             << pq.codeBytes() / pq.size() << " bytes por imagem) contra a Lista: " << pqHits << "/"
+             << pqQueries << " (" << 100.0 * pqHits / pqQueries << "%)" << endl;
+    }
+
+    if (half)
+    {
+        reportHalfDrift(store, referenceStore, *half);
+    }
+
+    /** / 
+    //testSimilarity(imageList, referenceImage);
+    //testListSearch(imageList, referenceImage);
+    //testHashTableSearch(hashTable, referenceImage);
+    //testQuadTreeSearch(quadTree, referenceImage);
+    //testLSHSearch(lshIndex, referenceImage);
+    //testMTreeSearch(mtree, referenceImage);
+    /**/
+}
+
+int main(int argc, char *argv[])
+{
+    const string images_folder = "images";
+    const string reference_folder = "imageReference";
+
+    try
+    {
+        const Options options = parseArguments(argc, argv);
+        ThreadPool pool(options.threads);
+
+        random_device rd;
+        mt19937 gen(rd());
+        uniform_int_distribution<> distrib(1, 10000);
+        cout << "=== Sistema de Busca de Imagens ===" << endl;
+
+        cout << "Threads de extração: " << pool.size() << endl;
+
+        // Uma única cópia de cada conjunto; os índices abaixo guardam só ids
+        const FeatureStore store = processImagesFromFolder(images_folder, pool, options);
+        const FeatureStore referenceStore = processImagesFromFolder(reference_folder, pool, options);
+        cout << "\nTotal de imagens carregadas na lista de imagem: " << store.size() << endl;
+        cout << "\nTotal de imagens carregadas na lista de imagem de referencia: " << referenceStore.size() << endl;
+
+        //ImageData referenceImage = loadReferenceImage(reference_folder);
+
+        if (options.live)
+        {
+            runLiveIngestion(store, referenceStore);
+        }
 
+        dispatchMetric(options.metric, [&](auto metric)
+                       { runSearches<decltype(metric)>(store, referenceStore, pool, options); });
     }
     catch (const exception &e)
     {
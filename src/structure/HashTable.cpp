@@ -1,59 +1,226 @@
 // src/structure/HashTable.cpp
 
 #include "HashTable.h"
+#include "../core/DistanceTile.h"
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <limits>
+#include <stdexcept>
 #include <filesystem>
 
-HashTable::HashTable(size_t capacity)
-    : buckets(std::max<size_t>(1, capacity)), count(0) {}
+namespace {
 
-size_t HashTable::hashFunction(const std::string& key) const {
-    return std::hash<std::string>{}(key) % buckets.size();
+// Nome do arquivo sem alocar (mesmos separadores de std::filesystem::path)
+std::string_view fileName(std::string_view path) {
+    const char separators[] = {'/', static_cast<char>(std::filesystem::path::preferred_separator), '\0'};
+    const size_t slash = path.find_last_of(separators);
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
 }
 
-void HashTable::addImage(const ImageData& image) {
-    std::string key = std::filesystem::path(image.path).filename().string();
-    size_t idx = hashFunction(key);
-    buckets[idx].push_back(image);
-    ++count;
+// 32 bits do hash do nome; std::hash devolve size_t, então dobra os 64 bits
+uint32_t fingerprintOf(std::string_view name) {
+    const uint64_t h = std::hash<std::string_view>{}(name);
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+} // namespace
+
+HashTable::Table::Table(size_t capacity)
+    : slots(capacity, Slot{0, NOT_PRESENT}), mask(capacity ? capacity - 1 : 0) {}
+
+// Robin Hood: quem está mais longe da posição ideal fica com a vaga. Empates
+// seguem adiante, então entradas de mesma chave ficam na ordem de inserção.
+void HashTable::Table::place(Slot slot) {
+    size_t pos = slot.fingerprint & mask;
+    for (size_t distance = 0;; pos = (pos + 1) & mask, ++distance) {
+        Slot& current = slots[pos];
+        if (current.id == NOT_PRESENT) {
+            current = slot;
+            ++count;
+            return;
+        }
+        const size_t currentDistance = (pos - (current.fingerprint & mask)) & mask;
+        if (currentDistance < distance) {
+            std::swap(current, slot);
+            distance = currentDistance;
+        }
+    }
+}
+
+HashTable::HashTable(const FeatureStore& store, size_t capacity) : store(&store) {
+    size_t slots = 16;
+    while (slots * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR < capacity) slots *= 2;
+    table = Table(slots);
+}
+
+void HashTable::addImage(uint32_t id) {
+    if (contains(id)) {
+        throw std::invalid_argument("Imagem já inserida na HashTable.");
+    }
+
+    if (!draining.slots.empty()) drainStep(REHASH_STEP);
+    if ((table.count + 1) * MAX_LOAD_DENOMINATOR > table.slots.size() * MAX_LOAD_NUMERATOR) grow();
+    table.place({fingerprintOf(fileName(store->path(id))), id});
+
+    if (position.size() <= id) position.resize(static_cast<size_t>(id) + 1, NOT_PRESENT);
+    position[id] = static_cast<uint32_t>(ids.size());
+    sequential = sequential && id == ids.size();
+    ids.push_back(id);
+}
+
+// Dobra a tabela sem reinserir tudo de uma vez: a antiga continua valendo nas
+// consultas e cada addImage seguinte migra REHASH_STEP posições dela
+void HashTable::grow() {
+    drainStep(draining.slots.size()); // termina um rehash anterior, se houver
+    draining = std::move(table);
+    drainCursor = 0;
+    table = Table(draining.slots.size() * 2);
+}
+
+void HashTable::drainStep(size_t slots) {
+    const size_t end = std::min(draining.slots.size(), drainCursor + slots);
+    for (; drainCursor < end; ++drainCursor) {
+        const Slot& slot = draining.slots[drainCursor];
+        if (slot.id != NOT_PRESENT) table.place(slot);
+    }
+    if (drainCursor == draining.slots.size()) {
+        draining = Table();
+        drainCursor = 0;
+    }
+}
+
+// Percorre a sequência da chave até uma posição vazia ou uma entrada mais
+// perto da posição ideal do que a chave estaria (Robin Hood garante que ela
+// não aparece depois) e guarda a correspondência inserida primeiro
+void HashTable::probe(const Table& t, uint32_t fingerprint, std::string_view path, bool wholePath, int& best) const {
+    if (t.slots.empty()) return;
+    size_t pos = fingerprint & t.mask;
+    for (size_t distance = 0;; pos = (pos + 1) & t.mask, ++distance) {
+        const Slot& slot = t.slots[pos];
+        if (slot.id == NOT_PRESENT || ((pos - (slot.fingerprint & t.mask)) & t.mask) < distance) return;
+        if (slot.fingerprint != fingerprint) continue;
+        if (best >= 0 && position[slot.id] >= position[best]) continue;
+
+        const std::string_view stored = store->path(slot.id);
+        if (wholePath ? stored == path : fileName(stored) == path) best = static_cast<int>(slot.id);
+    }
+}
+
+int HashTable::findByPath(std::string_view path) const {
+    const std::string_view name = fileName(path);
+    const bool wholePath = name.size() != path.size();
+    const uint32_t fingerprint = fingerprintOf(name);
+
+    // Durante um rehash cada entrada está em pelo menos uma das tabelas; as
+    // migradas perdem a ordem de inserção, então vale a menor posição em ids
+    int best = -1;
+    probe(table, fingerprint, wholePath ? path : name, wholePath, best);
+    probe(draining, fingerprint, wholePath ? path : name, wholePath, best);
+    return best;
+}
+
+void HashTable::useQuantized(const QuantizedStore* q, size_t shortlistSize) {
+    if (q && !q->covers(*store)) {
+        throw std::invalid_argument("QuantizedStore não corresponde ao FeatureStore da HashTable.");
+    }
+    quantized = q;
+    shortlist = shortlistSize;
+}
+
+void HashTable::useHalf(const HalfStore* h) {
+    if (h && !h->covers(*store)) {
+        throw std::invalid_argument("HalfStore não corresponde ao FeatureStore da HashTable.");
+    }
+    half = h;
 }
 
 int HashTable::findNearest(const FeatureVector& query, int ignoreIndex) const {
-    if (count == 0) return -1;
+    if (ids.empty()) return -1;
+
+    requireSameDimension(query.size(), store->dimension());
 
+    return dispatchDimension(query.size(), [&](auto dim) {
+        return findNearestFixed<decltype(dim)::value>(query, ignoreIndex);
+    });
+}
+
+template <size_t Dim>
+int HashTable::findNearestFixed(const FeatureVector& query, int ignoreIndex) const {
     int nearestIndex = -1;
-    double minDistance = std::numeric_limits<double>::max();
-    int globalIndex = 0;
-
-    for (const auto& bucket : buckets) {
-        for (const auto& img : bucket) {
-            if (globalIndex == ignoreIndex) {
-                ++globalIndex;
-                continue;
-            }
-
-            double distance = calculateEuclideanDistance(query, img.features);
-            if (nearestIndex == -1 || distance < minDistance) {
-                minDistance = distance;
-                nearestIndex = globalIndex;
-            }
-            ++globalIndex;
+    double minDistance = std::numeric_limits<double>::infinity(); // quadrado da distância
+
+    // Um único intervalo: as linhas do store direto quando os ids são 0..n-1
+    const uint32_t* scanIds = sequential ? nullptr : ids.data();
+
+    if (quantized) {
+        QuantizedSearch search(*quantized, query.data(), shortlist);
+        search.scan(scanIds, 0, ids.size(), ignoreIndex);
+        return search.rerank<Dim>(minDistance);
+    }
+
+    if (half) {
+        return half->nearestAmong<Dim>(query.data(), scanIds, 0, ids.size(), ignoreIndex, minDistance);
+    }
+
+    // Vetores curtos: varredura em blocos (veja preferTileScan)
+    if (preferTileScan(query.size())) {
+        const float queryNorm = squaredNorm(query.data(), query.size());
+        return store->nearestAmong<Dim>(query.data(), queryNorm, scanIds, 0, ids.size(), ignoreIndex, minDistance);
+    }
+
+    for (uint32_t id : ids) {
+        if (static_cast<int>(id) == ignoreIndex) continue;
+
+        double distance = squaredEuclideanDistance<Dim>(query.data(), store->features(id), query.size(), minDistance);
+        if (nearestIndex == -1 || distance < minDistance) {
+            minDistance = distance;
+            nearestIndex = static_cast<int>(id);
         }
     }
 
     return nearestIndex;
 }
 
-const ImageData& HashTable::getImage(int index) const {
-    int globalIndex = 0;
-    for (const auto& bucket : buckets) {
-        for (const auto& img : bucket) {
-            if (globalIndex == index) {
-                return img;
-            }
-            ++globalIndex;
+void HashTable::findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out,
+                             int ignoreIndex) const {
+    NeighborHeap heap(out, std::min(k, ids.size()));
+    if (ids.empty()) return;
+
+    requireSameDimension(query.size(), store->dimension());
+
+    dispatchDimension(query.size(), [&](auto dim) {
+        for (uint32_t id : ids) {
+            if (static_cast<int>(id) == ignoreIndex) continue;
+            heap.push(static_cast<int>(id), squaredEuclideanDistance<decltype(dim)::value>(
+                                                query.data(), store->features(id), query.size(), heap.bound()));
         }
+    });
+    heap.finish([](double squared) { return std::sqrt(squared); });
+}
+
+void HashTable::findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                            int ignoreIndex) const {
+    out.clear();
+    if (ids.empty()) return;
+
+    requireSameDimension(query.size(), store->dimension());
+
+    const double bound = radius * radius;
+    dispatchDimension(query.size(), [&](auto dim) {
+        for (uint32_t id : ids) {
+            if (static_cast<int>(id) == ignoreIndex) continue;
+            const double squared = squaredEuclideanDistance<decltype(dim)::value>(query.data(), store->features(id),
+                                                                                  query.size(), bound);
+            if (squared <= bound) out.push_back({static_cast<int>(id), squared});
+        }
+    });
+    sortNeighbors(out, [](double squared) { return std::sqrt(squared); });
+}
+
+ImageRef HashTable::getImage(int index) const {
+    if (index < 0 || !contains(static_cast<uint32_t>(index))) {
+        throw std::out_of_range("Índice inválido em HashTable::getImage");
     }
-    throw std::out_of_range("Índice inválido em HashTable::getImage");
+    return store->image(static_cast<uint32_t>(index));
 }
@@ -1,25 +1,105 @@
 //src/structure/HashTable.h
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "../core/FeatureStore.h"
+#include "../core/HalfStore.h"
+#include "../core/Neighbors.h"
+#include "../core/QuantizedStore.h"
 #include "../core/Vector.h"
 #include "List.h"
 
+// Tabela hash indexada pelo nome do arquivo, com endereçamento aberto (Robin Hood):
+// cada posição guarda só a impressão de 32 bits do hash e o id do FeatureStore.
+// As buscas por similaridade varrem o vetor denso de ids (ordem de inserção);
+// a tabela só serve às consultas por caminho.
 class HashTable {
 public:
-    explicit HashTable(size_t capacity = 101);
+    // capacity: número de imagens esperado; a tabela cresce sozinha além disso
+    explicit HashTable(const FeatureStore& store, size_t capacity = 101);
+
+    void addImage(uint32_t id);
+
+    // Id da imagem com este caminho, ou -1. Um nome sem diretório casa com
+    // o nome do arquivo (a chave da tabela); com diretório, com o caminho
+    // inteiro. Com nomes repetidos, vale a primeira imagem inserida.
+    int findByPath(std::string_view path) const;
+    bool contains(std::string_view path) const { return findByPath(path) >= 0; }
+
+    // O(1): o id do store está na tabela
+    bool contains(uint32_t id) const { return id < position.size() && position[id] != NOT_PRESENT; }
+
+    // Busca pelos códigos de 8 bits e reordena a lista curta (veja ImageList::useQuantized)
+    void useQuantized(const QuantizedStore* quantized, size_t shortlist = QUANTIZED_SHORTLIST);
+
+    // Varre a cópia de 16 bits (veja ImageList::useHalf)
+    void useHalf(const HalfStore* half);
 
-    void addImage(const ImageData& image);
     int findNearest(const FeatureVector& query, int ignoreIndex = -1) const;
-    const ImageData& getImage(int index) const;
 
-    size_t size() const { return count; }
-    bool empty() const { return count == 0; }
+    // k mais próximos e busca por raio, pelos floats de todos os baldes
+    // (veja ImageList::findKNearest e ImageList::findInRange)
+    void findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out, int ignoreIndex = -1) const;
+    std::vector<Neighbor> findKNearest(const FeatureVector& query, size_t k, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findKNearest(query, k, out, ignoreIndex);
+        return out;
+    }
+    void findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                     int ignoreIndex = -1) const;
+    std::vector<Neighbor> findInRange(const FeatureVector& query, double radius, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findInRange(query, radius, out, ignoreIndex);
+        return out;
+    }
+    ImageRef getImage(int index) const;
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
 
 private:
-    std::vector<std::vector<ImageData>> buckets;
-    size_t count;
+    static constexpr uint32_t NOT_PRESENT = UINT32_MAX;
+
+    // Ocupação máxima (7/8) antes de dobrar a tabela
+    static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+    static constexpr size_t MAX_LOAD_DENOMINATOR = 8;
+
+    // Posições da tabela antiga migradas a cada addImage durante o rehash;
+    // com 2 ou mais a migração termina antes de a tabela nova encher
+    static constexpr size_t REHASH_STEP = 16;
+
+    struct Slot {
+        uint32_t fingerprint; // hash do nome; os bits baixos dão a posição ideal
+        uint32_t id;          // NOT_PRESENT: posição vazia
+    };
+
+    struct Table {
+        std::vector<Slot> slots; // tamanho potência de dois
+        size_t mask = 0;
+        size_t count = 0;
+
+        explicit Table(size_t capacity = 0);
+        void place(Slot slot);
+    };
+
+    const FeatureStore* store;
+    Table table;        // recebe as inserções
+    Table draining;     // tabela anterior, esvaziada aos poucos depois de cada crescimento
+    size_t drainCursor = 0;
+    std::vector<uint32_t> ids;      // ids na ordem de inserção (o que as buscas varrem)
+    std::vector<uint32_t> position; // id do store -> posição em ids (ou NOT_PRESENT)
+    bool sequential = true;         // ids == 0..size()-1: varre as linhas do store direto
+    const QuantizedStore* quantized = nullptr;
+    size_t shortlist = QUANTIZED_SHORTLIST;
+    const HalfStore* half = nullptr;
+
+    void grow();
+    void drainStep(size_t slots);
+    void probe(const Table& t, uint32_t fingerprint, std::string_view path, bool wholePath, int& best) const;
 
-    size_t hashFunction(const std::string& key) const;
-};
\ No newline at end of file
+    template <size_t Dim>
+    int findNearestFixed(const FeatureVector& query, int ignoreIndex) const;
+};
@@ -1,13 +1,20 @@
 // src/structure/LSH.cpp
 #include "LSH.h"
+#include "../core/Epoch.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <stdexcept>
 #include <iostream>
 
-LSH::LSH(int dimension, int num_tables, int num_bits) 
-    : dimension_(dimension), num_tables_(num_tables), num_bits_(num_bits) {
+LSH::LSH(const FeatureStore& store, int dimension, int num_tables, int num_bits) 
+    : store_(&store), dimension_(dimension), num_tables_(num_tables), num_bits_(num_bits) {
     
+    directory_mask_ = (size_t(1) << std::min(num_bits, LSH_DIRECTORY_BITS)) - 1;
     tables_.resize(num_tables);
+    for (auto& table : tables_) {
+        table = std::make_unique<Bucket[]>(directory_mask_ + 1);
+    }
     planes_.resize(num_tables);
 
     std::mt19937 gen(42); // Seed fixa para reprodutibilidade no relatório
@@ -25,10 +32,10 @@ LSH::LSH(int dimension, int num_tables, int num_bits)
     }
 }
 
-size_t LSH::computeHash(const FeatureVector& feature, int tableIdx) const {
+size_t LSH::computeHash(const float* feature, size_t size, int tableIdx) const {
     size_t hash = 0;
     // Verifica compatibilidade de dimensão
-    size_t dim = std::min((size_t)dimension_, feature.size());
+    size_t dim = std::min((size_t)dimension_, size);
 
     for (int i = 0; i < num_bits_; ++i) {
         float dot_product = 0.0f;
@@ -44,56 +51,146 @@ size_t LSH::computeHash(const FeatureVector& feature, int tableIdx) const {
     return hash;
 }
 
-void LSH::addImage(const ImageData& img) {
-    int idx = data_store_.size();
-    data_store_.push_back(img);
-
+void LSH::addImage(uint32_t id) {
+    const size_t sequence = count_.load(std::memory_order_relaxed);
     for (int i = 0; i < num_tables_; ++i) {
-        size_t hash = computeHash(img.features, i);
-        tables_[i][hash].push_back(idx);
+        size_t hash = computeHash(store_->features(id), store_->dimension(), i);
+        tables_[i][hash & directory_mask_].push_back({hash, id, static_cast<uint32_t>(sequence)});
+    }
+    // Publica a imagem depois de ela estar em todas as tabelas
+    count_.store(sequence + 1, std::memory_order_release);
+}
+
+void LSH::useQuantized(const QuantizedStore* quantized, size_t shortlist) {
+    if (quantized && !quantized->covers(*store_)) {
+        throw std::invalid_argument("QuantizedStore não corresponde ao FeatureStore do LSH.");
     }
+    quantized_ = quantized;
+    shortlist_ = shortlist;
 }
 
-const ImageData& LSH::getImage(int index) const {
-    return data_store_[index];
+ImageRef LSH::getImage(int index) const {
+    return store_->image(static_cast<uint32_t>(index));
 }
 
 size_t LSH::size() const {
-    return data_store_.size();
+    return count_.load(std::memory_order_acquire);
 }
 
 int LSH::findNearest(const FeatureVector& query, int k_ignored, int* comparisons_out) const {
+    EpochGuard guard;
+    return dispatchDimension(query.size(), [&](auto dim) {
+        return findNearestFixed<decltype(dim)::value>(query, comparisons_out);
+    });
+}
+
+template <size_t Dim>
+int LSH::findNearestFixed(const FeatureVector& query, int* comparisons_out) const {
     int comparisons = 0;
-    double min_dist = std::numeric_limits<double>::max();
+    double min_dist = std::numeric_limits<double>::infinity(); // quadrado da distância
     int nearest_idx = -1;
 
     // Usamos um set para não comparar a mesma imagem duas vezes (se ela cair em múltiplos buckets)
     std::unordered_set<int> candidates_checked;
 
+    // Com os códigos de 8 bits os candidatos são juntados e varridos de uma vez
+    std::vector<uint32_t> quantized_candidates;
+
+    // Retrato: só as imagens que já estavam em todas as tabelas
+    const size_t visible = size();
+
     for (int i = 0; i < num_tables_; ++i) {
-        size_t hash = computeHash(query, i);
+        size_t hash = computeHash(query.data(), query.size(), i);
         
-        // Verifica se existe bucket para esse hash
-        auto it = tables_[i].find(hash);
-        if (it != tables_[i].end()) {
-            const std::vector<int>& bucket_candidates = it->second;
+        const Bucket& bucket = tables_[i][hash & directory_mask_];
+        const size_t bucket_size = bucket.size();
+        const BucketEntry* entries = bucket.data();
+        for (size_t j = 0; j < bucket_size; ++j) {
+            if (entries[j].hash != hash || entries[j].sequence >= visible) continue;
+            const int idx = static_cast<int>(entries[j].id);
+
+            // Evita reprocessar o mesmo candidato
+            if (candidates_checked.count(idx)) continue;
+            candidates_checked.insert(idx);
+            
+            comparisons++;
+
+            if (quantized_) {
+                quantized_candidates.push_back(static_cast<uint32_t>(idx));
+                continue;
+            }
             
-            for (int idx : bucket_candidates) {
-                // Evita reprocessar o mesmo candidato
-                if (candidates_checked.count(idx)) continue;
-                candidates_checked.insert(idx);
-                
-                comparisons++;
-                
-                double dist = calculateEuclideanDistance(query, data_store_[idx].features);
-                if (dist < min_dist) {
-                    min_dist = dist;
-                    nearest_idx = idx;
-                }
+            requireSameDimension(query.size(), store_->dimension());
+            double dist = squaredEuclideanDistance<Dim>(query.data(), store_->features(idx), query.size(), min_dist);
+            if (dist < min_dist) {
+                min_dist = dist;
+                nearest_idx = idx;
             }
         }
     }
 
+    if (quantized_ && !quantized_candidates.empty()) {
+        requireSameDimension(query.size(), store_->dimension());
+        QuantizedSearch search(*quantized_, query.data(), shortlist_);
+        search.scan(quantized_candidates.data(), 0, quantized_candidates.size());
+        nearest_idx = search.rerank<Dim>(min_dist);
+    }
+
     if (comparisons_out) *comparisons_out = comparisons;
     return nearest_idx;
-}
\ No newline at end of file
+}
+
+void LSH::collectCandidates(const FeatureVector& query, size_t visible, std::vector<uint32_t>& out) const {
+    out.clear();
+    std::unordered_set<uint32_t> seen;
+    for (int i = 0; i < num_tables_; ++i) {
+        const size_t hash = computeHash(query.data(), query.size(), i);
+        const Bucket& bucket = tables_[i][hash & directory_mask_];
+        const size_t bucket_size = bucket.size();
+        const BucketEntry* entries = bucket.data();
+        for (size_t j = 0; j < bucket_size; ++j) {
+            if (entries[j].hash != hash || entries[j].sequence >= visible) continue;
+            if (seen.insert(entries[j].id).second) out.push_back(entries[j].id);
+        }
+    }
+}
+
+void LSH::findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out, int ignoreIndex) const {
+    EpochGuard guard;
+    std::vector<uint32_t> candidates;
+    collectCandidates(query, size(), candidates);
+    NeighborHeap heap(out, std::min(k, candidates.size()));
+    if (candidates.empty()) return;
+
+    requireSameDimension(query.size(), store_->dimension());
+
+    dispatchDimension(query.size(), [&](auto dim) {
+        for (uint32_t id : candidates) {
+            if (static_cast<int>(id) == ignoreIndex) continue;
+            heap.push(static_cast<int>(id), squaredEuclideanDistance<decltype(dim)::value>(
+                                                query.data(), store_->features(id), query.size(), heap.bound()));
+        }
+    });
+    heap.finish([](double squared) { return std::sqrt(squared); });
+}
+
+void LSH::findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out, int ignoreIndex) const {
+    EpochGuard guard;
+    std::vector<uint32_t> candidates;
+    collectCandidates(query, size(), candidates);
+    out.clear();
+    if (candidates.empty()) return;
+
+    requireSameDimension(query.size(), store_->dimension());
+
+    const double bound = radius * radius;
+    dispatchDimension(query.size(), [&](auto dim) {
+        for (uint32_t id : candidates) {
+            if (static_cast<int>(id) == ignoreIndex) continue;
+            const double squared = squaredEuclideanDistance<decltype(dim)::value>(query.data(), store_->features(id),
+                                                                                  query.size(), bound);
+            if (squared <= bound) out.push_back({static_cast<int>(id), squared});
+        }
+    });
+    sortNeighbors(out, [](double squared) { return std::sqrt(squared); });
+}
@@ -2,10 +2,16 @@
 #ifndef LSH_H
 #define LSH_H
 
+#include "../core/AppendArray.h"
+#include "../core/FeatureStore.h"
+#include "../core/QuantizedStore.h"
 #include "../core/Image.h"
+#include "../core/Neighbors.h"
 #include "../core/Vector.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include <unordered_map>
 #include <unordered_set>
 #include <random>
 #include "List.h"
@@ -18,40 +24,96 @@
 // Se já estiver definido em outro lugar, apenas certifique-se que LSH.h o enxergue.
 #endif
 
+/**
+ * @brief Bits do hash usados para escolher o balde de cada tabela (no máximo
+ * 2^12 baldes por tabela; com num_bits maior os baldes filtram pelo hash completo).
+ */
+const int LSH_DIRECTORY_BITS = 12;
+
+/*
+ * Uma thread pode chamar addImage() enquanto outras consultam. O diretório de
+ * baldes de cada tabela tem tamanho fixo e cada balde é um AppendArray, então
+ * nada que um leitor esteja vendo é movido. Cada imagem recebe um número de
+ * sequência e count_ só é publicado depois que ela está em todas as tabelas:
+ * a consulta lê count_ uma vez e ignora as entradas com sequência maior, ou
+ * seja, vê exatamente as imagens completas naquele instante.
+ */
 class LSH {
 private:
-    // Armazena cópias dos dados para garantir que o índice retornado seja válido internamente
-    std::vector<ImageData> data_store_;
+    // Entrada de um balde: hash completo, id no store e ordem de inserção
+    struct BucketEntry {
+        uint64_t hash;
+        uint32_t id;
+        uint32_t sequence;
+    };
+    using Bucket = AppendArray<BucketEntry>;
+
+    // Imagens compartilhadas: as tabelas guardam só os ids do store
+    const FeatureStore* store_;
+    std::atomic<size_t> count_{0};
+
+    // Opcional: candidatos comparados pelos códigos de 8 bits e reordenados
+    const QuantizedStore* quantized_ = nullptr;
+    size_t shortlist_ = QUANTIZED_SHORTLIST;
     
     // Hiperplanos aleatórios: [num_tables][num_bits][dimension]
     std::vector<std::vector<std::vector<float>>> planes_;
     
-    // Tabelas Hash: [table_index] -> (Hash -> Lista de Índices na data_store_)
-    // Usamos string ou size_t como chave do hash
-    std::vector<std::unordered_map<size_t, std::vector<int>>> tables_;
+    // Tabelas Hash: [table_index][hash & directory_mask_] -> entradas do balde
+    std::vector<std::unique_ptr<Bucket[]>> tables_;
+    size_t directory_mask_;
 
     int num_tables_; // L
     int num_bits_;   // K
     int dimension_;  // D
 
     // Gera um hash para um vetor usando a tabela específica
-    size_t computeHash(const FeatureVector& feature, int tableIdx) const;
+    size_t computeHash(const float* feature, size_t size, int tableIdx) const;
+
+    template <size_t Dim>
+    int findNearestFixed(const FeatureVector& query, int* comparisons_out) const;
+
+    // Ids dos baldes da consulta em todas as tabelas, sem repetição, na ordem
+    // de visita, entre as `visible` primeiras imagens inseridas
+    void collectCandidates(const FeatureVector& query, size_t visible, std::vector<uint32_t>& out) const;
 
 public:
     /**
+     * @param store Imagens indexadas (deve viver mais que o índice)
      * @param dimension Dimensão do vetor de características (ex: 64)
      * @param num_tables Número de tabelas hash (L). Aumenta chance de encontrar (Recall). Recomendado: 5 a 10.
      * @param num_bits Número de bits do hash (K). Aumenta seletividade (Precisão). Recomendado: log2(N).
      */
-    LSH(int dimension, int num_tables = 5, int num_bits = 10);
+    LSH(const FeatureStore& store, int dimension, int num_tables = 5, int num_bits = 10);
+
+    void addImage(uint32_t id);
 
-    void addImage(const ImageData& img);
+    // Compara os candidatos pelos códigos de 8 bits e reordena a lista curta
+    // com os floats (veja ImageList::useQuantized); nullptr volta à busca exata
+    void useQuantized(const QuantizedStore* quantized, size_t shortlist = QUANTIZED_SHORTLIST);
 
-    // Retorna o índice da imagem mais próxima dentro da estrutura LSH
+    // Retorna o id (no store) da imagem mais próxima
     // Retorna -1 se nada for encontrado
     int findNearest(const FeatureVector& query, int k_ignored = -1, int* comparisons_out = nullptr) const;
 
-    const ImageData& getImage(int index) const;
+    // k mais próximos e busca por raio entre os candidatos dos baldes da
+    // consulta, pelos floats (aproximadas: imagens fora desses baldes não
+    // aparecem). Veja ImageList::findKNearest.
+    void findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out, int ignoreIndex = -1) const;
+    std::vector<Neighbor> findKNearest(const FeatureVector& query, size_t k, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findKNearest(query, k, out, ignoreIndex);
+        return out;
+    }
+    void findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                     int ignoreIndex = -1) const;
+    std::vector<Neighbor> findInRange(const FeatureVector& query, double radius, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findInRange(query, radius, out, ignoreIndex);
+        return out;
+    }
+
+    ImageRef getImage(int index) const;
     
     size_t size() const;
 };
@@ -1,32 +1,282 @@
 // src/structure/list.cpp
 
 #include "List.h"
+#include "../core/DistanceTile.h"
+#include "../core/Epoch.h"
 #include "../core/Vector.h"
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
+#include <type_traits>
 
-void ImageList::addImage(const ImageData& image) {
-    images.push_back(image);
+template <typename Metric>
+void BasicImageList<Metric>::addImage(uint32_t id) {
+    // Antes de publicar o id: quem vir o tamanho novo vê também a flag
+    if (id != ids.size()) sequential.store(false, std::memory_order_relaxed);
+    ids.push_back(id);
 }
 
-int ImageList::findNearest(const FeatureVector& query, const int ignoreIndex) const {
-    if (images.empty()) return -1;
+template <typename Metric>
+typename BasicImageList<Metric>::Snapshot BasicImageList<Metric>::snapshot() const {
+    const size_t count = ids.size();
+    return Snapshot{ids.data(), count, sequential.load(std::memory_order_relaxed)};
+}
+
+template <typename Metric>
+void BasicImageList<Metric>::useQuantized(const QuantizedStore* q, size_t shortlistSize) {
+    if (q && !std::is_same_v<Metric, EuclideanMetric>) {
+        throw std::invalid_argument("A busca quantizada só está disponível com a distância euclidiana.");
+    }
+    if (q && !q->covers(*store)) {
+        throw std::invalid_argument("QuantizedStore não corresponde ao FeatureStore da lista.");
+    }
+    quantized = q;
+    shortlist = shortlistSize;
+}
+
+template <typename Metric>
+void BasicImageList<Metric>::useHalf(const HalfStore* h) {
+    if (h && !std::is_same_v<Metric, EuclideanMetric>) {
+        throw std::invalid_argument("A busca em 16 bits só está disponível com a distância euclidiana.");
+    }
+    if (h && !h->covers(*store)) {
+        throw std::invalid_argument("HalfStore não corresponde ao FeatureStore da lista.");
+    }
+    half = h;
+}
+
+template <typename Metric>
+int BasicImageList<Metric>::findNearest(const FeatureVector& query, const int ignoreIndex, ThreadPool* pool) const {
+    EpochGuard guard;
+    const Snapshot view = snapshot();
+    if (view.count == 0) return -1;
+
+    // O store garante a mesma dimensão para todas as imagens
+    requireSameDimension(query.size(), store->dimension());
+
+    return dispatchDimension(query.size(), [&](auto dim) {
+        return findNearestFixed<decltype(dim)::value>(query.data(), ignoreIndex, pool, view);
+    });
+}
+
+template <typename Metric>
+template <size_t Dim>
+int BasicImageList<Metric>::findNearestFixed(const float* query, const int ignoreIndex, ThreadPool* pool,
+                                             const Snapshot& view) const {
+    double minDistance = std::numeric_limits<double>::infinity();
+
+    // Códigos de 8 bits: lê 1/4 dos bytes e só a lista curta usa os floats
+    // (uma lista curta única, então sempre em série)
+    if constexpr (std::is_same_v<Metric, EuclideanMetric>) {
+        if (quantized) {
+            QuantizedSearch search(*quantized, query, shortlist);
+            search.scan(view.sequential ? nullptr : view.ids, 0, view.count, ignoreIndex);
+            return search.rerank<Dim>(minDistance);
+        }
+    }
+
+    const size_t chunkRows =
+        std::max<size_t>(DISTANCE_BLOCK, PARALLEL_SCAN_CHUNK_BYTES / (store->stride() * sizeof(float)));
+    const size_t chunks = (view.count + chunkRows - 1) / chunkRows;
+    if (!pool || pool->size() == 1 || chunks < PARALLEL_SCAN_MIN_CHUNKS) {
+        return nearestInRange<Dim>(query, view, 0, view.count, ignoreIndex, minDistance);
+    }
 
+    // Cada fatia começa do zero (sem limite compartilhado entre as threads),
+    // então o seu mínimo não depende do escalonamento
+    std::vector<double> chunkBest(chunks, std::numeric_limits<double>::infinity());
+    std::vector<int> chunkNearest(chunks, -1);
+    pool->parallelFor(chunks, [&](size_t c) {
+        const size_t begin = c * chunkRows;
+        chunkNearest[c] = nearestInRange<Dim>(query, view, begin, std::min(view.count, begin + chunkRows),
+                                              ignoreIndex, chunkBest[c]);
+    });
+
+    // Redução determinística: fatias em ordem, empates com a primeira posição
     int nearestIndex = -1;
-    double minDistance = std::numeric_limits<double>::max();
+    for (size_t c = 0; c < chunks; ++c) {
+        if (chunkNearest[c] >= 0 && (nearestIndex == -1 || chunkBest[c] < minDistance)) {
+            minDistance = chunkBest[c];
+            nearestIndex = chunkNearest[c];
+        }
+    }
+    return nearestIndex;
+}
+
+template <typename Metric>
+template <size_t Dim>
+int BasicImageList<Metric>::nearestInRange(const float* query, const Snapshot& view, const size_t begin,
+                                           const size_t end, const int ignoreIndex, double& minDistance) const {
+    const size_t dimension = store->dimension();
+    const uint32_t* rangeIds = view.sequential ? nullptr : view.ids + begin;
+    const uint32_t first = view.sequential ? static_cast<uint32_t>(begin) : 0;
 
-    for (int i = 0; i < images.size(); ++i) {
-        if (i == ignoreIndex) continue; // Pula a imagem de consulta
+    if constexpr (std::is_same_v<Metric, EuclideanMetric>) {
+        // 16 bits: metade dos bytes, convertidos para float dentro do kernel
+        if (half) {
+            return half->nearestAmong<Dim>(query, rangeIds, first, end - begin, ignoreIndex, minDistance);
+        }
 
-        double distance = calculateEuclideanDistance(query, images[i].features);
+        // Vetores curtos: blocos de linhas com ||x||² pré-calculado, uma passada de
+        // produtos escalares limitada pela banda de memória (veja nearestInTile)
+        if (preferTileScan(dimension)) {
+            const float queryNorm = squaredNorm(query, dimension);
+            return store->nearestAmong<Dim>(query, queryNorm, rangeIds, first, end - begin, ignoreIndex,
+                                            minDistance);
+        }
+    }
+
+    int nearestIndex = -1;
+    for (size_t i = begin; i < end; ++i) {
+        const uint32_t id = view.ids[i];
+        if (static_cast<int>(id) == ignoreIndex) continue; // Pula a imagem de consulta
+
+        // Score da métrica com abandono (quando ela permite): a ordem é a mesma
+        // e candidatos piores que o atual param no primeiro bloco que ultrapassa o limite
+        double distance = Metric::template score<Dim>(query, store->features(id), dimension, minDistance);
         if (nearestIndex == -1 || distance < minDistance) {
             minDistance = distance;
-            nearestIndex = i;
+            nearestIndex = static_cast<int>(id);
         }
     }
 
     return nearestIndex;
 }
 
-const ImageData& ImageList::getImage(const int index) const {
-    return images[index];
+template <typename Metric>
+void BasicImageList<Metric>::findKNearest(const FeatureVector& query, const size_t k, std::vector<Neighbor>& out,
+                                          const int ignoreIndex) const {
+    EpochGuard guard;
+    const Snapshot view = snapshot();
+    NeighborHeap heap(out, std::min(k, view.count));
+    if (view.count == 0) return;
+
+    requireSameDimension(query.size(), store->dimension());
+
+    dispatchDimension(query.size(), [&](auto dim) {
+        for (size_t i = 0; i < view.count; ++i) {
+            const uint32_t id = view.ids[i];
+            if (static_cast<int>(id) == ignoreIndex) continue;
+            heap.push(static_cast<int>(id), Metric::template score<decltype(dim)::value>(
+                                                query.data(), store->features(id), query.size(), heap.bound()));
+        }
+    });
+    heap.finish(Metric::toDistance);
 }
+
+template <typename Metric>
+void BasicImageList<Metric>::findInRange(const FeatureVector& query, const double radius, std::vector<Neighbor>& out,
+                                         const int ignoreIndex) const {
+    EpochGuard guard;
+    const Snapshot view = snapshot();
+    out.clear();
+    if (view.count == 0) return;
+
+    requireSameDimension(query.size(), store->dimension());
+
+    const double bound = Metric::toScore(radius);
+    dispatchDimension(query.size(), [&](auto dim) {
+        for (size_t i = 0; i < view.count; ++i) {
+            const uint32_t id = view.ids[i];
+            if (static_cast<int>(id) == ignoreIndex) continue;
+            const double score = Metric::template score<decltype(dim)::value>(query.data(), store->features(id),
+                                                                              query.size(), bound);
+            if (score <= bound) out.push_back({static_cast<int>(id), score});
+        }
+    });
+    sortNeighbors(out, Metric::toDistance);
+}
+
+template <typename Metric>
+std::vector<int> BasicImageList<Metric>::findNearestBatch(const FeatureStore& queries, ThreadPool* pool) const {
+    EpochGuard guard;
+    const Snapshot view = snapshot();
+    std::vector<int> nearest(queries.size(), -1);
+    if (view.count == 0 || queries.empty()) return nearest;
+
+    requireSameDimension(queries.dimension(), store->dimension());
+
+    // Sem a decomposição em normas e produtos escalares: uma varredura por consulta
+    if constexpr (!std::is_same_v<Metric, EuclideanMetric>) {
+        dispatchDimension(store->dimension(), [&](auto dim) {
+            auto body = [&](size_t q) {
+                nearest[q] =
+                    findNearestFixed<decltype(dim)::value>(queries.features(static_cast<uint32_t>(q)), -1, nullptr, view);
+            };
+            if (pool) {
+                pool->parallelFor(queries.size(), body);
+            } else {
+                for (size_t q = 0; q < queries.size(); ++q) body(q);
+            }
+        });
+        return nearest;
+    }
+
+    const size_t queryCount = queries.size();
+    const size_t blockRows = distanceBatchBlockRows(store->stride());
+    const size_t blocks = (view.count + blockRows - 1) / blockRows;
+
+    // Cada fatia contígua de blocos guarda o seu próprio mínimo por consulta
+    const size_t slices = std::min(blocks, pool ? pool->size() * 4 : size_t(1));
+    std::vector<double> sliceBest(slices * queryCount, std::numeric_limits<double>::infinity());
+    std::vector<int> sliceNearest(slices * queryCount, -1);
+
+    DistanceTile queryTile;
+    queryTile.base = queries.features(0);
+    queryTile.stride = queries.stride();
+    queryTile.norms = queries.squaredNorms();
+    queryTile.ids = nullptr;
+    queryTile.count = queryCount;
+
+    auto body = [&](size_t slice) {
+        double* best = sliceBest.data() + slice * queryCount;
+        int* found = sliceNearest.data() + slice * queryCount;
+        std::vector<size_t> position(queryCount);
+
+        for (size_t b = slice * blocks / slices; b < (slice + 1) * blocks / slices; ++b) {
+            const size_t start = b * blockRows;
+            DistanceTile block;
+            block.stride = store->stride();
+            block.count = std::min(blockRows, view.count - start);
+            block.ids = view.sequential ? nullptr : view.ids + start;
+            block.base = view.sequential ? store->features(static_cast<uint32_t>(start)) : store->features(0);
+            block.norms = view.sequential ? store->squaredNorms() + start : store->squaredNorms();
+
+            std::fill(position.begin(), position.end(), TILE_NO_CANDIDATE);
+            nearestInTileBatch(queryTile, block, store->dimension(), best, position.data());
+            for (size_t q = 0; q < queryCount; ++q) {
+                if (position[q] != TILE_NO_CANDIDATE) found[q] = static_cast<int>(view.ids[start + position[q]]);
+            }
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(slices, body);
+    } else {
+        body(0);
+    }
+
+    // Redução determinística: fatias em ordem, empates com a primeira
+    for (size_t q = 0; q < queryCount; ++q) {
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t slice = 0; slice < slices; ++slice) {
+            if (sliceNearest[slice * queryCount + q] >= 0 && sliceBest[slice * queryCount + q] < best) {
+                best = sliceBest[slice * queryCount + q];
+                nearest[q] = sliceNearest[slice * queryCount + q];
+            }
+        }
+    }
+    return nearest;
+}
+
+template <typename Metric>
+ImageRef BasicImageList<Metric>::getImage(const int index) const {
+    return store->image(static_cast<uint32_t>(index));
+}
+
+template class BasicImageList<EuclideanMetric>;
+template class BasicImageList<L1Metric>;
+template class BasicImageList<ChiSquareMetric>;
+template class BasicImageList<IntersectionMetric>;
+template class BasicImageList<HellingerMetric>;
+template class BasicImageList<CosineMetric>;
@@ -3,10 +3,31 @@
 #ifndef LIST_H
 #define LIST_H
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include "../core/AppendArray.h"
+#include "../core/FeatureStore.h"
+#include "../core/HalfStore.h"
+#include "../core/Metric.h"
+#include "../core/Neighbors.h"
+#include "../core/QuantizedStore.h"
+#include "../core/ThreadPool.h"
 #include "../core/Vector.h"
 
+/**
+ * @brief Bytes de características por fatia na busca paralela de
+ * ImageList::findNearest (cabe no cache L2 de um núcleo).
+ */
+const size_t PARALLEL_SCAN_CHUNK_BYTES = 256 << 10;
+
+/**
+ * @brief Com menos fatias que isto findNearest roda em série mesmo com pool
+ * (acordar as threads custaria mais que a varredura).
+ */
+const size_t PARALLEL_SCAN_MIN_CHUNKS = 4;
+
 struct ImageData {
     std::string path;
     FeatureVector features;
@@ -17,18 +38,133 @@ struct ImageData {
         : path(p), features(f), extraction_time(t) {}
 };
 
-class ImageList {
-    std::vector<ImageData> images;
+/**
+ * @brief Lista linear de imagens de um FeatureStore (guarda só os ids).
+ * findNearest devolve o id da imagem no store; `ignoreIndex` também é um id.
+ *
+ * `Metric` é a política de distância (veja Metric.h). Os caminhos que
+ * dependem da forma da distância euclidiana (blocos com normas, lote em
+ * produto de matrizes e códigos de 8 bits) só existem em ImageList; com as
+ * demais métricas a varredura chama o kernel da métrica diretamente.
+ *
+ * Uma thread pode chamar addImage() enquanto outras consultam: os ids ficam
+ * em um AppendArray e cada consulta lê uma vez o prefixo publicado (o
+ * retrato), então vê a lista como estava em algum instante entre o início e
+ * o fim da chamada. Os ids acrescentados precisam já estar publicados no
+ * store. useQuantized e useHalf cobrem as imagens existentes quando foram
+ * chamados; com inserções concorrentes use a busca pelos floats.
+ */
+template <typename Metric>
+class BasicImageList {
+    const FeatureStore* store;
+    AppendArray<uint32_t> ids;
+    std::atomic<bool> sequential{true}; // ids == 0..size()-1: varre as linhas do store direto
+    const QuantizedStore* quantized = nullptr;
+    size_t shortlist = QUANTIZED_SHORTLIST;
+    const HalfStore* half = nullptr;
+
+    // Prefixo publicado da lista, lido uma vez por consulta
+    struct Snapshot {
+        const uint32_t* ids;
+        size_t count;
+        bool sequential;
+    };
+    Snapshot snapshot() const;
+
+    // Laço de busca com a dimensão como constante de compilação (veja dispatchDimension)
+    template <size_t Dim>
+    int findNearestFixed(const float* query, int ignoreIndex, ThreadPool* pool, const Snapshot& view) const;
+
+    // Melhor entre as posições [begin, end) do retrato com score < minDistance
+    // (atualizando-o), ou -1; empates ficam com a primeira posição
+    template <size_t Dim>
+    int nearestInRange(const float* query, const Snapshot& view, size_t begin, size_t end, int ignoreIndex,
+                       double& minDistance) const;
 
 public:
-    void addImage(const ImageData& image);
+    using metric_type = Metric;
+
+    explicit BasicImageList(const FeatureStore& store) : store(&store) {}
+
+    void addImage(uint32_t id);
 
-    int findNearest(const FeatureVector& query, int ignoreIndex) const;
+    /**
+     * @brief Passa a buscar pelos códigos de 8 bits de `quantized` e reordenar
+     * os `shortlist` melhores com os floats (veja QuantizedSearch); nullptr
+     * volta à busca exata. A cópia deve cobrir o store da lista e viver mais
+     * que ela; std::invalid_argument se não cobrir ou se a métrica não for a
+     * euclidiana (os códigos aproximam só essa distância).
+     */
+    void useQuantized(const QuantizedStore* quantized, size_t shortlist = QUANTIZED_SHORTLIST);
 
-    const ImageData& getImage(int index) const;
+    /**
+     * @brief Passa a varrer a cópia de 16 bits `half` (metade dos bytes dos
+     * floats, sem reordenação; veja HalfStore); nullptr volta aos floats.
+     * Mesmas condições de useQuantized. useQuantized tem precedência.
+     */
+    void useHalf(const HalfStore* half);
 
-    size_t size() const { return images.size(); }
-    bool empty() const { return images.empty(); }
+    /**
+     * @brief Vizinho mais próximo de `query` (busca exata, a referência dos
+     * demais índices).
+     *
+     * Com `pool`, a lista é dividida em fatias de PARALLEL_SCAN_CHUNK_BYTES
+     * distribuídas entre as threads; cada fatia guarda o seu melhor e a
+     * redução percorre as fatias em ordem, então o resultado é o mesmo da
+     * busca em série, com empates resolvidos pela menor posição na lista.
+     * Listas com menos de PARALLEL_SCAN_MIN_CHUNKS fatias e a busca
+     * quantizada rodam em série. Não pode ser chamado de dentro de uma
+     * tarefa do mesmo pool.
+     */
+    int findNearest(const FeatureVector& query, int ignoreIndex, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief Os `k` vizinhos mais próximos em ordem crescente de distância
+     * (empates pelo menor id), sempre pelos floats (ignora useQuantized e
+     * useHalf). Candidatos piores que o k-ésimo atual são abandonados no
+     * primeiro bloco que o ultrapassa. `out` é reaproveitado entre chamadas:
+     * com capacidade para k resultados não há alocação.
+     */
+    void findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out, int ignoreIndex = -1) const;
+    std::vector<Neighbor> findKNearest(const FeatureVector& query, size_t k, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findKNearest(query, k, out, ignoreIndex);
+        return out;
+    }
+
+    /**
+     * @brief Todas as imagens a distância <= `radius` de `query`, em ordem
+     * crescente (mesmas regras de findKNearest).
+     */
+    void findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                     int ignoreIndex = -1) const;
+    std::vector<Neighbor> findInRange(const FeatureVector& query, double radius, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findInRange(query, radius, out, ignoreIndex);
+        return out;
+    }
+
+    /**
+     * @brief Vizinho mais próximo de cada imagem de `queries` (mesma dimensão).
+     *
+     * As consultas e a base são cruzadas em blocos, como um produto de
+     * matrizes (veja nearestInTileBatch): cada bloco da base é lido uma vez
+     * para todo o lote em vez de uma vez por consulta. Com `pool`, os blocos
+     * são divididos entre as threads e os mínimos parciais são combinados em
+     * ordem fixa, então o resultado não depende do escalonamento. Sempre
+     * exata, com as mesmas distâncias e empates de findNearest (ignora
+     * useQuantized e useHalf). Retorna um id por consulta (-1 se a lista
+     * estiver vazia). Com métricas não euclidianas cada consulta é uma
+     * varredura completa, e `pool` divide as consultas entre as threads.
+     */
+    std::vector<int> findNearestBatch(const FeatureStore& queries, ThreadPool* pool = nullptr) const;
+
+    ImageRef getImage(int index) const;
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
 };
 
+using ImageList = BasicImageList<EuclideanMetric>;
+
 #endif // LIST_H
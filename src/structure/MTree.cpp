@@ -1,194 +1,223 @@
 // src/structure/MTree.cpp
 
 #include "MTree.h"
+#include "../core/Epoch.h"
 #include <cmath>
 #include <algorithm>
 #include <iostream>
 
-MTree::MTree(int capacity) 
-    : root_(nullptr), capacity_(capacity), count_(0) {
+template <typename Metric>
+BasicMTree<Metric>::BasicMTree(const FeatureStore& store, int capacity) 
+    : root_(nullptr), store_(&store), capacity_(capacity), count_(0) {
     if (capacity_ < 2) {
         capacity_ = 2; // mínimo para permitir split
     }
 }
 
-void MTree::insert(const ImageData& image, int index) {
-    // Armazena a imagem no dataStore
-    if (static_cast<size_t>(index) >= dataStore_.size()) {
-        dataStore_.resize(index + 1);
-    }
-    dataStore_[index] = image;
-    
-    MTreeEntry entry(image, index);
-    
-    if (!root_) {
-        // Árvore vazia: cria nó raiz folha
-        root_ = std::make_shared<MTreeNode>(true);
-        root_->entries.push_back(entry);
-        root_->coveringRadii.push_back(0.0);
-        count_++;
-        return;
-    }
-    
-    // Insere recursivamente
-    FeatureVector dummyParent;
-    insertRecursive(root_, entry);
-    count_++;
+template <typename Metric>
+double BasicMTree<Metric>::distance(const MTreeEntry& a, const MTreeEntry& b) const {
+    return metricDistance<Metric>(features(a), features(b), store_->dimension());
 }
 
-void MTree::insertRecursive(std::shared_ptr<MTreeNode>& node, const MTreeEntry& entry) {
+template <typename Metric>
+void BasicMTree<Metric>::insertBatch(const uint32_t* ids, size_t count) {
+    if (count == 0) return;
     
-    if (node->isLeaf) {
-        // Nó folha: adiciona a entrada diretamente
-        node->entries.push_back(entry);
-        node->coveringRadii.push_back(0.0);
+    std::shared_ptr<MTreeNode> root = root_;
+    for (size_t i = 0; i < count; i++) {
+        MTreeEntry entry(static_cast<int>(ids[i]));
         
-        // Verifica se precisa de split
-        if (static_cast<int>(node->entries.size()) > capacity_) {
-            if (node == root_) {
-                splitRoot();
-            }
+        if (!root) {
+            // Árvore vazia: cria nó raiz folha
+            root = markFresh(std::make_shared<MTreeNode>(true));
+            root->entries.push_back(entry);
+            root->coveringRadii.push_back(0.0);
+            continue;
+        }
+        
+        // Insere recursivamente (copiando só os nós ainda publicados)
+        root = insertRecursive(root, entry);
+        
+        // Verifica se a raiz precisa de split
+        if (static_cast<int>(root->entries.size()) > capacity_) {
+            root = markFresh(splitRoot(*root));
+            markFresh(root->children[0]);
+            markFresh(root->children[1]);
         }
+    }
+    
+    publish(std::move(root));
+    // Os nós do lote agora são visíveis. Enquanto o lote durou, nenhum nó
+    // publicado foi liberado (a versão antiga segue em root_ até publish),
+    // então um endereço em fresh_ nunca é o de um nó que um leitor alcança.
+    fresh_.clear();
+    count_.store(count_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+template <typename Metric>
+std::shared_ptr<MTreeNode> BasicMTree<Metric>::markFresh(std::shared_ptr<MTreeNode> node) {
+    fresh_.insert(node.get());
+    return node;
+}
+
+template <typename Metric>
+std::shared_ptr<MTreeNode> BasicMTree<Metric>::writable(const std::shared_ptr<MTreeNode>& node) {
+    if (fresh_.count(node.get())) return node;
+    return markFresh(std::make_shared<MTreeNode>(*node));
+}
+
+template <typename Metric>
+void BasicMTree<Metric>::publish(std::shared_ptr<MTreeNode> root) {
+    std::shared_ptr<MTreeNode> old = std::move(root_);
+    root_ = std::move(root);
+    published_.store(root_.get(), std::memory_order_release);
+    
+    // Consultas em andamento podem estar na versão anterior
+    if (old) {
+        defaultEpochDomain().retireObject(new std::shared_ptr<MTreeNode>(std::move(old)));
+    }
+}
+
+template <typename Metric>
+std::shared_ptr<MTreeNode> BasicMTree<Metric>::insertRecursive(const std::shared_ptr<MTreeNode>& node,
+                                                               const MTreeEntry& entry) {
+    std::shared_ptr<MTreeNode> copy = writable(node);
+    
+    if (copy->isLeaf) {
+        // Nó folha: adiciona a entrada diretamente (o split fica com quem chamou)
+        copy->entries.push_back(entry);
+        copy->coveringRadii.push_back(0.0);
     } else {
         // Nó interno: escolhe a melhor subárvore
-        int bestIdx = chooseBestSubtree(node, entry.features);
+        int bestIdx = chooseBestSubtree(*copy, entry);
         
-        if (bestIdx < 0 || bestIdx >= static_cast<int>(node->children.size())) {
+        if (bestIdx < 0 || bestIdx >= static_cast<int>(copy->children.size())) {
             // Fallback: adiciona como nova entrada
-            node->entries.push_back(entry);
-            node->coveringRadii.push_back(0.0);
-            auto newChild = std::make_shared<MTreeNode>(true);
+            copy->entries.push_back(entry);
+            copy->coveringRadii.push_back(0.0);
+            auto newChild = markFresh(std::make_shared<MTreeNode>(true));
             newChild->entries.push_back(entry);
             newChild->coveringRadii.push_back(0.0);
-            node->children.push_back(newChild);
-            return;
+            copy->children.push_back(newChild);
+            return copy;
         }
         
         // Calcula distância ao routing object
-        double distToRouting = calculateEuclideanDistance(
-            entry.features, node->entries[bestIdx].features);
+        double distToRouting = distance(entry, copy->entries[bestIdx]);
         
         // Insere recursivamente na subárvore escolhida
-        insertRecursive(node->children[bestIdx], entry);
+        copy->children[bestIdx] = insertRecursive(copy->children[bestIdx], entry);
         
         // Atualiza o raio de cobertura se necessário
-        if (distToRouting > node->coveringRadii[bestIdx]) {
-            node->coveringRadii[bestIdx] = distToRouting;
+        if (distToRouting > copy->coveringRadii[bestIdx]) {
+            copy->coveringRadii[bestIdx] = distToRouting;
         }
         
         // Verifica se o filho precisa de split
-        if (static_cast<int>(node->children[bestIdx]->entries.size()) > capacity_) {
-            splitChild(node, bestIdx);
+        if (static_cast<int>(copy->children[bestIdx]->entries.size()) > capacity_) {
+            const size_t before = copy->children.size();
+            splitChild(*copy, bestIdx);
+            if (copy->children.size() > before) {
+                markFresh(copy->children[bestIdx]);
+                markFresh(copy->children.back());
+            }
         }
     }
+    return copy;
 }
 
-void MTree::splitRoot() {
-    if (!root_ || root_->entries.size() < 2) return;
-    
-    auto [p1, p2] = promote(root_->entries);
-    
-    std::vector<MTreeEntry> group1, group2;
-    partition(root_->entries, p1, p2, group1, group2);
-    
-    auto newNode1 = std::make_shared<MTreeNode>(root_->isLeaf);
-    auto newNode2 = std::make_shared<MTreeNode>(root_->isLeaf);
+template <typename Metric>
+void BasicMTree<Metric>::splitNode(const MTreeNode& node, Half& first, Half& second) const {
+    auto [p1, p2] = promote(node.entries);
     
-    newNode1->entries = std::move(group1);
-    newNode2->entries = std::move(group2);
+    std::vector<size_t> group1, group2;
+    partition(node.entries, p1, p2, group1, group2);
     
-    newNode1->coveringRadii.resize(newNode1->entries.size(), 0.0);
-    newNode2->coveringRadii.resize(newNode2->entries.size(), 0.0);
+    first = makeHalf(node, group1, node.entries[p1]);
+    second = makeHalf(node, group2, node.entries[p2]);
+}
+
+template <typename Metric>
+typename BasicMTree<Metric>::Half BasicMTree<Metric>::makeHalf(const MTreeNode& node, const std::vector<size_t>& group,
+                                                              const MTreeEntry& routing) const {
+    Half half;
+    half.routing = routing;
+    half.routing.distanceToParent = 0.0;
+    half.node = std::make_shared<MTreeNode>(node.isLeaf);
+    
+    // Num nó interno as subárvores acompanham suas entradas, e o raio de
+    // cobertura precisa incluir a bola de cada uma (distância + raio do filho)
+    for (size_t i : group) {
+        MTreeEntry e = node.entries[i];
+        e.distanceToParent = distance(e, routing);
+        double reach = e.distanceToParent;
+        
+        half.node->entries.push_back(e);
+        if (node.isLeaf) {
+            half.node->coveringRadii.push_back(0.0);
+        } else {
+            double childRadius = (i < node.coveringRadii.size()) ? node.coveringRadii[i] : 0.0;
+            half.node->coveringRadii.push_back(childRadius);
+            half.node->children.push_back(node.children[i]);
+            reach += childRadius;
+        }
+        half.radius = std::max(half.radius, reach);
+    }
+    return half;
+}
+
+template <typename Metric>
+std::shared_ptr<MTreeNode> BasicMTree<Metric>::splitRoot(const MTreeNode& root) const {
+    Half first, second;
+    splitNode(root, first, second);
     
     // Cria nova raiz
     auto newRoot = std::make_shared<MTreeNode>(false);
     
-    MTreeEntry rep1 = newNode1->entries[0];
-    MTreeEntry rep2 = newNode2->entries[0];
-    
-    // Calcula raios de cobertura
-    double radius1 = 0.0, radius2 = 0.0;
-    for (const auto& e : newNode1->entries) {
-        double d = calculateEuclideanDistance(e.features, rep1.features);
-        radius1 = std::max(radius1, d);
-    }
-    for (const auto& e : newNode2->entries) {
-        double d = calculateEuclideanDistance(e.features, rep2.features);
-        radius2 = std::max(radius2, d);
-    }
-    
-    newRoot->entries.push_back(rep1);
-    newRoot->entries.push_back(rep2);
-    newRoot->coveringRadii.push_back(radius1);
-    newRoot->coveringRadii.push_back(radius2);
-    newRoot->children.push_back(newNode1);
-    newRoot->children.push_back(newNode2);
+    newRoot->entries.push_back(first.routing);
+    newRoot->entries.push_back(second.routing);
+    newRoot->coveringRadii.push_back(first.radius);
+    newRoot->coveringRadii.push_back(second.radius);
+    newRoot->children.push_back(first.node);
+    newRoot->children.push_back(second.node);
     
-    root_ = newRoot;
+    return newRoot;
 }
 
-void MTree::splitChild(std::shared_ptr<MTreeNode>& parent, int childIdx) {
-    if (childIdx < 0 || childIdx >= static_cast<int>(parent->children.size())) return;
-    
-    auto child = parent->children[childIdx];
-    if (child->entries.size() < 2) return;
-    
-    auto [p1, p2] = promote(child->entries);
-    
-    std::vector<MTreeEntry> group1, group2;
-    partition(child->entries, p1, p2, group1, group2);
+template <typename Metric>
+void BasicMTree<Metric>::splitChild(MTreeNode& parent, int childIdx) const {
+    if (childIdx < 0 || childIdx >= static_cast<int>(parent.children.size())) return;
     
-    auto newNode1 = std::make_shared<MTreeNode>(child->isLeaf);
-    auto newNode2 = std::make_shared<MTreeNode>(child->isLeaf);
+    const MTreeNode& child = *parent.children[childIdx];
+    if (child.entries.size() < 2) return;
     
-    newNode1->entries = std::move(group1);
-    newNode2->entries = std::move(group2);
-    
-    newNode1->coveringRadii.resize(newNode1->entries.size(), 0.0);
-    newNode2->coveringRadii.resize(newNode2->entries.size(), 0.0);
-    
-    MTreeEntry rep1 = newNode1->entries[0];
-    MTreeEntry rep2 = newNode2->entries[0];
-    
-    // Calcula novos raios
-    double radius1 = 0.0, radius2 = 0.0;
-    for (const auto& e : newNode1->entries) {
-        double d = calculateEuclideanDistance(e.features, rep1.features);
-        radius1 = std::max(radius1, d);
-    }
-    for (const auto& e : newNode2->entries) {
-        double d = calculateEuclideanDistance(e.features, rep2.features);
-        radius2 = std::max(radius2, d);
-    }
+    Half first, second;
+    splitNode(child, first, second);
     
     // Atualiza o primeiro filho
-    parent->entries[childIdx] = rep1;
-    parent->coveringRadii[childIdx] = radius1;
-    parent->children[childIdx] = newNode1;
-    
-    // Adiciona o segundo filho
-    parent->entries.push_back(rep2);
-    parent->coveringRadii.push_back(radius2);
-    parent->children.push_back(newNode2);
-    
-    // Se o parent também estourou a capacidade e é a raiz
-    if (static_cast<int>(parent->entries.size()) > capacity_ && parent == root_) {
-        splitRoot();
-    }
+    parent.entries[childIdx] = first.routing;
+    parent.coveringRadii[childIdx] = first.radius;
+    parent.children[childIdx] = first.node;
+    
+    // Adiciona o segundo filho (se o parent estourar, quem o contém faz o split)
+    parent.entries.push_back(second.routing);
+    parent.coveringRadii.push_back(second.radius);
+    parent.children.push_back(second.node);
 }
 
-int MTree::chooseBestSubtree(const std::shared_ptr<MTreeNode>& node,
-                              const FeatureVector& features) const {
-    if (node->entries.empty()) return -1;
+template <typename Metric>
+int BasicMTree<Metric>::chooseBestSubtree(const MTreeNode& node,
+                              const MTreeEntry& entry) const {
+    if (node.entries.empty()) return -1;
     
     int bestIdx = 0;
     double minDistance = std::numeric_limits<double>::max();
     double minEnlargement = std::numeric_limits<double>::max();
     bool foundInside = false;
     
-    for (size_t i = 0; i < node->entries.size(); i++) {
-        double dist = calculateEuclideanDistance(features, node->entries[i].features);
-        double radius = (i < node->coveringRadii.size()) ? node->coveringRadii[i] : 0.0;
+    for (size_t i = 0; i < node.entries.size(); i++) {
+        double dist = distance(entry, node.entries[i]);
+        double radius = (i < node.coveringRadii.size()) ? node.coveringRadii[i] : 0.0;
         
         if (dist <= radius) {
             // Objeto está dentro do raio de cobertura
@@ -210,7 +239,8 @@ int MTree::chooseBestSubtree(const std::shared_ptr<MTreeNode>& node,
     return bestIdx;
 }
 
-std::pair<int, int> MTree::promote(const std::vector<MTreeEntry>& entries) const {
+template <typename Metric>
+std::pair<int, int> BasicMTree<Metric>::promote(const std::vector<MTreeEntry>& entries) const {
     // Estratégia: escolhe os dois objetos mais distantes entre si
     int n = static_cast<int>(entries.size());
     int p1 = 0, p2 = (n > 1) ? 1 : 0;
@@ -218,7 +248,7 @@ std::pair<int, int> MTree::promote(const std::vector<MTreeEntry>& entries) const
     
     for (int i = 0; i < n; i++) {
         for (int j = i + 1; j < n; j++) {
-            double dist = calculateEuclideanDistance(entries[i].features, entries[j].features);
+            double dist = distance(entries[i], entries[j]);
             if (dist > maxDist) {
                 maxDist = dist;
                 p1 = i;
@@ -230,30 +260,27 @@ std::pair<int, int> MTree::promote(const std::vector<MTreeEntry>& entries) const
     return {p1, p2};
 }
 
-void MTree::partition(const std::vector<MTreeEntry>& entries,
+template <typename Metric>
+void BasicMTree<Metric>::partition(const std::vector<MTreeEntry>& entries,
                       int promote1, int promote2,
-                      std::vector<MTreeEntry>& group1,
-                      std::vector<MTreeEntry>& group2) const {
+                      std::vector<size_t>& group1,
+                      std::vector<size_t>& group2) const {
     
     if (entries.empty()) return;
     if (promote1 < 0 || promote1 >= static_cast<int>(entries.size())) promote1 = 0;
     if (promote2 < 0 || promote2 >= static_cast<int>(entries.size())) promote2 = (entries.size() > 1) ? 1 : 0;
     
-    const FeatureVector& center1 = entries[promote1].features;
-    const FeatureVector& center2 = entries[promote2].features;
+    const MTreeEntry& center1 = entries[promote1];
+    const MTreeEntry& center2 = entries[promote2];
     
     for (size_t i = 0; i < entries.size(); i++) {
-        double dist1 = calculateEuclideanDistance(entries[i].features, center1);
-        double dist2 = calculateEuclideanDistance(entries[i].features, center2);
+        double dist1 = distance(entries[i], center1);
+        double dist2 = distance(entries[i], center2);
         
         if (dist1 <= dist2) {
-            MTreeEntry e = entries[i];
-            e.distanceToParent = dist1;
-            group1.push_back(e);
+            group1.push_back(i);
         } else {
-            MTreeEntry e = entries[i];
-            e.distanceToParent = dist2;
-            group2.push_back(e);
+            group2.push_back(i);
         }
     }
     
@@ -267,22 +294,32 @@ void MTree::partition(const std::vector<MTreeEntry>& entries,
     }
 }
 
-int MTree::findNearest(const FeatureVector& query, int ignoreIndex, int& comparisons) const {
+template <typename Metric>
+int BasicMTree<Metric>::findNearest(const FeatureVector& query, int ignoreIndex, int& comparisons) const {
     comparisons = 0;
     
-    if (!root_ || root_->entries.empty()) {
+    EpochGuard guard;
+    const MTreeNode* root = published_.load(std::memory_order_acquire);
+    if (!root || root->entries.empty()) {
         return -1;
     }
     
+    // O store garante a mesma dimensão para todas as entradas
+    requireSameDimension(query.size(), store_->dimension());
+    
     double bestDist = std::numeric_limits<double>::max();
     int bestIndex = -1;
     
-    searchNearest(root_, query, ignoreIndex, bestDist, bestIndex, comparisons);
+    dispatchDimension(query.size(), [&](auto dim) {
+        searchNearest<decltype(dim)::value>(root, query, ignoreIndex, bestDist, bestIndex, comparisons);
+    });
     
     return bestIndex;
 }
 
-void MTree::searchNearest(const std::shared_ptr<MTreeNode>& node,
+template <typename Metric>
+template <size_t Dim>
+void BasicMTree<Metric>::searchNearest(const MTreeNode* node,
                           const FeatureVector& query,
                           int ignoreIndex,
                           double& bestDist,
@@ -292,15 +329,19 @@ void MTree::searchNearest(const std::shared_ptr<MTreeNode>& node,
     if (!node) return;
     
     if (node->isLeaf) {
-        // Nó folha: compara com todas as entradas
+        // Nó folha: compara com todas as entradas. O score da métrica com
+        // abandono antecipado basta aqui; a conversão para distância só é feita
+        // quando há melhora, pois bestDist também é usado na poda pelos raios de cobertura
+        double bestScore = Metric::toScore(bestDist);
         for (const auto& entry : node->entries) {
             if (entry.index == ignoreIndex) continue;
             
             comparisons++;
-            double dist = calculateEuclideanDistance(query, entry.features);
+            double score = Metric::template score<Dim>(query.data(), features(entry), query.size(), bestScore);
             
-            if (dist < bestDist) {
-                bestDist = dist;
+            if (score < bestScore) {
+                bestScore = score;
+                bestDist = Metric::toDistance(score);
                 bestIndex = entry.index;
             }
         }
@@ -309,7 +350,8 @@ void MTree::searchNearest(const std::shared_ptr<MTreeNode>& node,
         std::vector<std::pair<double, int>> candidates;
         
         for (size_t i = 0; i < node->entries.size(); i++) {
-            double distToRouting = calculateEuclideanDistance(query, node->entries[i].features);
+            double distToRouting = Metric::toDistance(
+                Metric::template score<Dim>(query.data(), features(node->entries[i]), query.size()));
             double radius = (i < node->coveringRadii.size()) ? node->coveringRadii[i] : 0.0;
             
             // Condição de poda
@@ -332,13 +374,113 @@ void MTree::searchNearest(const std::shared_ptr<MTreeNode>& node,
             double minPossibleDist = std::max(0.0, dist - radius);
             
             if (minPossibleDist < bestDist) {
-                searchNearest(node->children[idx], query, ignoreIndex, 
+                searchNearest<Dim>(node->children[idx].get(), query, ignoreIndex, 
                              bestDist, bestIndex, comparisons);
             }
         }
     }
 }
 
-const ImageData& MTree::getImage(int index) const {
-    return dataStore_[index];
+template <typename Metric>
+void BasicMTree<Metric>::findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out,
+                                      int ignoreIndex) const {
+    EpochGuard guard;
+    const MTreeNode* root = published_.load(std::memory_order_acquire);
+    NeighborHeap heap(out, std::min(k, size()));
+    if (!root || root->entries.empty()) return;
+    
+    requireSameDimension(query.size(), store_->dimension());
+    
+    dispatchDimension(query.size(), [&](auto dim) {
+        searchKNearest<decltype(dim)::value>(root, query, ignoreIndex, heap);
+    });
+    heap.finish([](double score) { return Metric::toDistance(score); });
 }
+
+template <typename Metric>
+template <size_t Dim>
+void BasicMTree<Metric>::searchKNearest(const MTreeNode* node, const FeatureVector& query,
+                                        int ignoreIndex, NeighborHeap& heap) const {
+    if (!node) return;
+    
+    if (node->isLeaf) {
+        for (const auto& entry : node->entries) {
+            if (entry.index == ignoreIndex) continue;
+            heap.push(entry.index,
+                      Metric::template score<Dim>(query.data(), features(entry), query.size(), heap.bound()));
+        }
+        return;
+    }
+    
+    // Mesma ordem de visita de searchNearest; o raio de poda é a distância do
+    // k-ésimo melhor, que só encolhe à medida que o heap melhora. Subárvores
+    // exatamente no limite ainda são visitadas (podem ter um empate de id menor)
+    std::vector<std::pair<double, int>> candidates;
+    for (size_t i = 0; i < node->entries.size() && i < node->children.size(); i++) {
+        double distToRouting = Metric::toDistance(
+            Metric::template score<Dim>(query.data(), features(node->entries[i]), query.size()));
+        candidates.push_back({distToRouting, static_cast<int>(i)});
+    }
+    std::sort(candidates.begin(), candidates.end());
+    
+    for (const auto& [dist, idx] : candidates) {
+        double radius = (idx < static_cast<int>(node->coveringRadii.size())) ? node->coveringRadii[idx] : 0.0;
+        double kth = heap.full() ? Metric::toDistance(heap.bound()) : std::numeric_limits<double>::infinity();
+        if (std::max(0.0, dist - radius) <= kth) {
+            searchKNearest<Dim>(node->children[idx].get(), query, ignoreIndex, heap);
+        }
+    }
+}
+
+template <typename Metric>
+void BasicMTree<Metric>::findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                                     int ignoreIndex) const {
+    EpochGuard guard;
+    const MTreeNode* root = published_.load(std::memory_order_acquire);
+    out.clear();
+    if (!root || root->entries.empty()) return;
+    
+    requireSameDimension(query.size(), store_->dimension());
+    
+    dispatchDimension(query.size(), [&](auto dim) {
+        searchRange<decltype(dim)::value>(root, query, ignoreIndex, radius, out);
+    });
+    sortNeighbors(out, [](double score) { return Metric::toDistance(score); });
+}
+
+template <typename Metric>
+template <size_t Dim>
+void BasicMTree<Metric>::searchRange(const MTreeNode* node, const FeatureVector& query,
+                                     int ignoreIndex, double radius, std::vector<Neighbor>& out) const {
+    if (!node) return;
+    
+    if (node->isLeaf) {
+        const double bound = Metric::toScore(radius);
+        for (const auto& entry : node->entries) {
+            if (entry.index == ignoreIndex) continue;
+            double score = Metric::template score<Dim>(query.data(), features(entry), query.size(), bound);
+            if (score <= bound) out.push_back({entry.index, score});
+        }
+        return;
+    }
+    
+    for (size_t i = 0; i < node->entries.size() && i < node->children.size(); i++) {
+        double distToRouting = Metric::toDistance(
+            Metric::template score<Dim>(query.data(), features(node->entries[i]), query.size()));
+        double covering = (i < node->coveringRadii.size()) ? node->coveringRadii[i] : 0.0;
+        
+        // Pela desigualdade triangular, nada na bola (routing, covering) fica a menos de distToRouting - covering
+        if (distToRouting - covering <= radius) {
+            searchRange<Dim>(node->children[i].get(), query, ignoreIndex, radius, out);
+        }
+    }
+}
+
+template <typename Metric>
+ImageRef BasicMTree<Metric>::getImage(int index) const {
+    return store_->image(static_cast<uint32_t>(index));
+}
+
+template class BasicMTree<EuclideanMetric>;
+template class BasicMTree<L1Metric>;
+template class BasicMTree<HellingerMetric>;
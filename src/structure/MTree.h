@@ -3,9 +3,14 @@
 #ifndef MTREE_H
 #define MTREE_H
 
+#include "../core/FeatureStore.h"
 #include "../core/Image.h"
+#include "../core/Metric.h"
+#include "../core/Neighbors.h"
 #include "../core/Vector.h"
 #include "List.h"
+#include <atomic>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 #include <limits>
@@ -25,21 +30,32 @@
  * 
  * Referência: Ciaccia, P., Patella, M., & Zezula, P. (1997). M-tree: An Efficient 
  * Access Method for Similarity Search in Metric Spaces.
+ *
+ * A distância é dada pela política `Metric` (veja Metric.h). A poda pelos
+ * raios de cobertura depende da desigualdade triangular, então métricas sem
+ * ela (qui-quadrado, interseção, cosseno) são recusadas na compilação.
+ *
+ * Uma thread pode inserir enquanto outras consultam. Os nós publicados nunca
+ * são alterados: a inserção copia o caminho da raiz até a folha (os demais
+ * nós são compartilhados pelos shared_ptr), faz os splits nas cópias e
+ * publica a raiz nova com um único store atômico. Cada consulta lê a raiz uma
+ * vez e percorre aquela versão; a anterior é entregue ao EpochDomain e os nós
+ * que só ela usava são liberados quando nenhum leitor pode mais alcançá-los.
+ * insertBatch() publica uma vez por lote: cada nó é copiado no máximo uma vez
+ * e as inserções seguintes alteram a cópia, que nenhum leitor alcança.
  */
 
 // Forward declaration
 class MTreeNode;
 
-// Entrada armazenada na M-Tree
+// Entrada armazenada na M-Tree (as características ficam no FeatureStore)
 struct MTreeEntry {
-    ImageData image;
-    FeatureVector features;
-    int index;              // índice global da imagem
+    int index;              // id da imagem no FeatureStore
     double distanceToParent; // distância ao objeto pai (routing object)
     
     MTreeEntry() : index(-1), distanceToParent(0.0) {}
-    MTreeEntry(const ImageData& img, int idx) 
-        : image(img), features(img.features), index(idx), distanceToParent(0.0) {}
+    explicit MTreeEntry(int idx) 
+        : index(idx), distanceToParent(0.0) {}
 };
 
 // Nó da M-Tree
@@ -53,80 +69,153 @@ public:
     MTreeNode(bool leaf = true) : isLeaf(leaf) {}
 };
 
-class MTree {
+template <typename Metric>
+class BasicMTree {
+    static_assert(Metric::isMetric, "A M-Tree exige uma métrica (desigualdade triangular)");
+
 private:
-    std::shared_ptr<MTreeNode> root_;
-    std::vector<ImageData> dataStore_;  // armazena todas as imagens
+    std::shared_ptr<MTreeNode> root_;     // versão atual (só o escritor usa)
+    std::atomic<const MTreeNode*> published_{nullptr}; // raiz lida pelas consultas
+    const FeatureStore* store_;          // imagens indexadas (compartilhadas)
     int capacity_;                       // capacidade máxima de cada nó
-    size_t count_;                       // total de elementos
+    std::atomic<size_t> count_;          // total de elementos
+    std::unordered_set<const MTreeNode*> fresh_; // nós criados no lote atual (ainda não publicados)
+    
+    const float* features(const MTreeEntry& entry) const { return store_->features(entry.index); }
+    
+    // Distância (da política Metric) entre duas entradas
+    double distance(const MTreeEntry& a, const MTreeEntry& b) const;
+    
+    // Funções auxiliares de inserção: devolve `node` com a entrada, copiado se
+    // for publicado (o original continua intacto para os leitores) ou alterado
+    // no lugar se foi criado no lote atual
+    std::shared_ptr<MTreeNode> insertRecursive(const std::shared_ptr<MTreeNode>& node, const MTreeEntry& entry);
+    std::shared_ptr<MTreeNode> writable(const std::shared_ptr<MTreeNode>& node);
+    std::shared_ptr<MTreeNode> markFresh(std::shared_ptr<MTreeNode> node);
+    
+    // Troca a raiz e aposenta a versão anterior
+    void publish(std::shared_ptr<MTreeNode> root);
     
-    // Funções auxiliares de inserção
-    void insertRecursive(std::shared_ptr<MTreeNode>& node, const MTreeEntry& entry);
+    // Metade de um nó dividido: objeto de roteamento, raio de cobertura e o novo nó
+    struct Half {
+        MTreeEntry routing;
+        double radius = 0.0;
+        std::shared_ptr<MTreeNode> node;
+    };
     
-    // Split da raiz
-    void splitRoot();
+    // Divide as entradas (e, em nós internos, os filhos) de `node` em duas metades
+    void splitNode(const MTreeNode& node, Half& first, Half& second) const;
+    Half makeHalf(const MTreeNode& node, const std::vector<size_t>& group, const MTreeEntry& routing) const;
     
-    // Split de um filho
-    void splitChild(std::shared_ptr<MTreeNode>& parent, int childIdx);
+    // Split da raiz: devolve a raiz nova, com as duas metades como filhos
+    std::shared_ptr<MTreeNode> splitRoot(const MTreeNode& root) const;
+    
+    // Split de um filho (parent é uma cópia ainda não publicada)
+    void splitChild(MTreeNode& parent, int childIdx) const;
     
     // Escolhe a melhor subárvore para inserção
-    int chooseBestSubtree(const std::shared_ptr<MTreeNode>& node, 
-                          const FeatureVector& features) const;
+    int chooseBestSubtree(const MTreeNode& node, 
+                          const MTreeEntry& entry) const;
     
-    // Busca recursiva do vizinho mais próximo
-    void searchNearest(const std::shared_ptr<MTreeNode>& node,
+    // Busca recursiva do vizinho mais próximo (Dim: veja dispatchDimension)
+    template <size_t Dim>
+    void searchNearest(const MTreeNode* node,
                        const FeatureVector& query,
                        int ignoreIndex,
                        double& bestDist,
                        int& bestIndex,
                        int& comparisons) const;
     
+    // Busca recursiva dos k mais próximos: poda contra o k-ésimo melhor do heap
+    template <size_t Dim>
+    void searchKNearest(const MTreeNode* node, const FeatureVector& query,
+                        int ignoreIndex, NeighborHeap& heap) const;
+    
+    // Busca recursiva por raio: poda as subárvores cuja bola não alcança `radius`
+    template <size_t Dim>
+    void searchRange(const MTreeNode* node, const FeatureVector& query,
+                     int ignoreIndex, double radius, std::vector<Neighbor>& out) const;
+    
     // Promoção de objetos para split (estratégia: mínima soma de raios)
     std::pair<int, int> promote(const std::vector<MTreeEntry>& entries) const;
     
-    // Partição de entradas após promoção
+    // Partição de entradas após promoção (índices em `entries`)
     void partition(const std::vector<MTreeEntry>& entries,
                    int promote1, int promote2,
-                   std::vector<MTreeEntry>& group1,
-                   std::vector<MTreeEntry>& group2) const;
+                   std::vector<size_t>& group1,
+                   std::vector<size_t>& group2) const;
 
 public:
     /**
      * Construtor da M-Tree
+     * @param store Imagens indexadas (deve viver mais que a árvore)
      * @param capacity Capacidade máxima de entradas por nó (recomendado: 4-50)
      */
-    explicit MTree(int capacity = 10);
+    explicit BasicMTree(const FeatureStore& store, int capacity = 10);
     
     /**
      * Insere uma imagem na M-Tree
-     * @param image Dados da imagem a ser inserida
-     * @param index Índice global da imagem
+     * @param id Id da imagem no FeatureStore
+     */
+    void insert(uint32_t id) { insertBatch(&id, 1); }
+    
+    /**
+     * Insere `count` imagens e publica a raiz uma única vez no final (as
+     * consultas concorrentes veem a árvore antes ou depois do lote inteiro).
+     * Para construir a árvore, evita copiar o caminho e aposentar a raiz a
+     * cada imagem.
      */
-    void insert(const ImageData& image, int index);
+    void insertBatch(const uint32_t* ids, size_t count);
     
     /**
      * Busca o vizinho mais próximo
      * @param query Vetor de características da consulta
      * @param ignoreIndex Índice a ser ignorado na busca (-1 para nenhum)
      * @param comparisons Contador de comparações realizadas (saída)
-     * @return Índice da imagem mais próxima, ou -1 se não encontrada
+     * @return Id da imagem mais próxima, ou -1 se não encontrada
      */
     int findNearest(const FeatureVector& query, int ignoreIndex, int& comparisons) const;
     
     /**
-     * Retorna a imagem pelo índice
+     * Busca os k vizinhos mais próximos (exata)
+     * @param out Resultados em ordem crescente de distância (empate: menor id);
+     *            reaproveitar o vetor entre consultas evita alocações
+     */
+    void findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out,
+                      int ignoreIndex = -1) const;
+    std::vector<Neighbor> findKNearest(const FeatureVector& query, size_t k, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findKNearest(query, k, out, ignoreIndex);
+        return out;
+    }
+    
+    /**
+     * Busca todas as imagens a distância <= radius (exata), na mesma ordem
      */
-    const ImageData& getImage(int index) const;
+    void findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                     int ignoreIndex = -1) const;
+    std::vector<Neighbor> findInRange(const FeatureVector& query, double radius, int ignoreIndex = -1) const {
+        std::vector<Neighbor> out;
+        findInRange(query, radius, out, ignoreIndex);
+        return out;
+    }
+    
+    /**
+     * Retorna a imagem pelo id
+     */
+    ImageRef getImage(int index) const;
     
     /**
      * Retorna o número de elementos na árvore
      */
-    size_t size() const { return count_; }
+    size_t size() const { return count_.load(std::memory_order_acquire); }
     
     /**
      * Verifica se a árvore está vazia
      */
-    bool empty() const { return count_ == 0; }
+    bool empty() const { return size() == 0; }
 };
 
+using MTree = BasicMTree<EuclideanMetric>;
+
 #endif // MTREE_H
@@ -0,0 +1,362 @@
+// src/structure/PQ.cpp
+
+#include "PQ.h"
+#include "../core/CpuFeatures.h"
+#include "../core/DistanceTile.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#if ANALISE_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Fast-scan: imagens por bloco (um registrador AVX2 de bytes) e entradas por
+// tabela de 4 bits (um registrador SSE, consultado com pshufb)
+const size_t kBlockImages = 32;
+const size_t kFastScanCentroids = 16;
+
+// Limite de subespaços com 4 bits: a soma de M bytes cabe em int16 com sinal
+const int kMaxFastScanSubspaces = 128;
+
+// Centróide mais próximo, com os centróides varridos como um bloco de linhas
+// com normas pré-calculadas (veja nearestInTile); empates ficam com o primeiro
+size_t nearestCentroid(const float* v, const float* centers, const float* norms, size_t count, size_t width) {
+    DistanceTile tile;
+    tile.base = centers;
+    tile.stride = width;
+    tile.norms = norms;
+    tile.ids = nullptr;
+    tile.count = count;
+
+    double bestDistance = std::numeric_limits<double>::infinity();
+    const size_t k = nearestInTile<DYNAMIC_DIMENSION>(v, squaredNorm(v, width), tile, width, bestDistance);
+    return k == TILE_NO_CANDIDATE ? 0 : k;
+}
+
+void computeNorms(const float* centers, size_t count, size_t width, float* norms) {
+    for (size_t k = 0; k < count; ++k) norms[k] = squaredNorm(centers + k * width, width);
+}
+
+// Máscara das imagens do bloco com soma das tabelas de bytes <= limit
+// (bit j = imagem j do bloco)
+using BlockFn = uint32_t (*)(const uint8_t*, const uint8_t*, size_t, int);
+
+uint32_t blockReference(const uint8_t* lut, const uint8_t* block, size_t subspaces, int limit) {
+    int sums[kBlockImages] = {};
+    for (size_t m = 0; m < subspaces; ++m) {
+        for (size_t j = 0; j < kBlockImages / 2; ++j) {
+            const uint8_t byte = block[m * 16 + j];
+            sums[j] += lut[m * 16 + (byte & 15)];
+            sums[j + 16] += lut[m * 16 + (byte >> 4)];
+        }
+    }
+    uint32_t mask = 0;
+    for (size_t j = 0; j < kBlockImages; ++j) {
+        if (sums[j] <= limit) mask |= 1u << j;
+    }
+    return mask;
+}
+
+#if ANALISE_X86_DISPATCH
+
+// Um pshufb consulta a tabela de 16 bytes do subespaço para as 32 imagens do
+// bloco (nibbles baixos na metade de baixo, altos na de cima); as somas são
+// acumuladas em 16 bits
+ANALISE_TARGET("avx2")
+uint32_t blockAvx2(const uint8_t* lut, const uint8_t* block, size_t subspaces, int limit) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m256i acc0 = _mm256_setzero_si256(); // imagens 0..15
+    __m256i acc1 = _mm256_setzero_si256(); // imagens 16..31
+    for (size_t m = 0; m < subspaces; ++m) {
+        const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lut + m * 16)));
+        const __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + m * 16));
+        const __m128i lo = _mm_and_si128(codes, nibble);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(codes, 4), nibble);
+        const __m256i d = _mm256_shuffle_epi8(table, _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1));
+        acc0 = _mm256_add_epi16(acc0, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d)));
+        acc1 = _mm256_add_epi16(acc1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d, 1)));
+    }
+    // acc <= limit  <=>  limit + 1 > acc (16 bits com sinal)
+    const __m256i bound = _mm256_set1_epi16(static_cast<short>(std::min(limit, 32766) + 1));
+    const __m256i in = _mm256_packs_epi16(_mm256_cmpgt_epi16(bound, acc0), _mm256_cmpgt_epi16(bound, acc1));
+    // packs intercala as metades de 128 bits: volta à ordem 0..31
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_permute4x64_epi64(in, 0xD8)));
+}
+
+#endif // ANALISE_X86_DISPATCH
+
+BlockFn blockFn() {
+#if ANALISE_X86_DISPATCH
+    if (cpuFeatures().avx2) return blockAvx2;
+#endif
+    return blockReference;
+}
+
+} // namespace
+
+PQ::PQ(const FeatureStore& store, int subspaces, int bits)
+    : store_(&store), subspaces_(subspaces), bits_(bits), centroids_(size_t(1) << bits),
+      dimension_(store.dimension()) {
+    if (bits != 4 && bits != 8) {
+        throw std::invalid_argument("PQ: bits deve ser 4 ou 8.");
+    }
+    if (subspaces < 1 || (dimension_ > 0 && static_cast<size_t>(subspaces) > dimension_)) {
+        throw std::invalid_argument("PQ: o número de subespaços deve estar entre 1 e a dimensão.");
+    }
+    if (bits == 4 && subspaces > kMaxFastScanSubspaces) {
+        throw std::invalid_argument("PQ: com 4 bits o número de subespaços é no máximo 128.");
+    }
+
+    // Subespaços de tamanhos quase iguais (dimensões não divisíveis por M)
+    offsets_.resize(subspaces_ + 1);
+    for (int m = 0; m <= subspaces_; ++m) {
+        offsets_[m] = m * dimension_ / subspaces_;
+    }
+}
+
+void PQ::train(size_t sampleSize, int iterations, unsigned seed, ThreadPool* pool) {
+    if (!ids_.empty()) {
+        throw std::logic_error("PQ::train deve ser chamado antes de addImage.");
+    }
+
+    std::vector<uint32_t> sample(store_->size());
+    std::iota(sample.begin(), sample.end(), 0u);
+    if (sample.size() > sampleSize) {
+        std::mt19937 gen(seed);
+        std::shuffle(sample.begin(), sample.end(), gen);
+        sample.resize(sampleSize);
+        std::sort(sample.begin(), sample.end()); // leitura em ordem no store
+    }
+
+    codebooks_.assign(dimension_ * centroids_, 0.0f);
+    centroidNorms_.assign(subspaces_ * centroids_, 0.0f);
+    auto body = [&](size_t m) { trainSubspace(static_cast<int>(m), sample, iterations, seed + static_cast<unsigned>(m)); };
+    if (pool) {
+        pool->parallelFor(subspaces_, body);
+    } else {
+        for (int m = 0; m < subspaces_; ++m) body(m);
+    }
+    trained_ = true;
+}
+
+void PQ::trainSubspace(int m, const std::vector<uint32_t>& sample, int iterations, unsigned seed) {
+    const size_t begin = offsets_[m];
+    const size_t width = offsets_[m + 1] - begin;
+    float* centers = codebooks_.data() + begin * centroids_;
+    float* norms = centroidNorms_.data() + m * centroids_;
+    if (sample.empty() || width == 0) return;
+
+    // Início: pontos sorteados da amostra (repetidos se houver menos pontos que centróides)
+    std::mt19937 gen(seed);
+    std::vector<uint32_t> order(sample);
+    std::shuffle(order.begin(), order.end(), gen);
+    for (size_t k = 0; k < centroids_; ++k) {
+        const float* f = store_->features(order[k % order.size()]) + begin;
+        std::copy(f, f + width, centers + k * width);
+    }
+
+    // Lloyd: atribui cada ponto ao centróide mais próximo e move os centróides para a média
+    std::vector<size_t> assignment(sample.size(), centroids_);
+    std::vector<double> sums(centroids_ * width);
+    std::vector<size_t> counts(centroids_);
+    for (int it = 0; it < iterations; ++it) {
+        computeNorms(centers, centroids_, width, norms);
+        bool changed = false;
+        for (size_t i = 0; i < sample.size(); ++i) {
+            const size_t k = nearestCentroid(store_->features(sample[i]) + begin, centers, norms, centroids_, width);
+            changed = changed || k != assignment[i];
+            assignment[i] = k;
+        }
+        if (!changed) break;
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < sample.size(); ++i) {
+            const float* f = store_->features(sample[i]) + begin;
+            double* sum = sums.data() + assignment[i] * width;
+            for (size_t d = 0; d < width; ++d) sum[d] += f[d];
+            counts[assignment[i]]++;
+        }
+        for (size_t k = 0; k < centroids_; ++k) {
+            if (counts[k] == 0) {
+                // Grupo vazio: recomeça em um ponto sorteado
+                const float* f = store_->features(sample[gen() % sample.size()]) + begin;
+                std::copy(f, f + width, centers + k * width);
+                continue;
+            }
+            for (size_t d = 0; d < width; ++d) {
+                centers[k * width + d] = static_cast<float>(sums[k * width + d] / counts[k]);
+            }
+        }
+    }
+    computeNorms(centers, centroids_, width, norms);
+}
+
+void PQ::addImage(uint32_t id) {
+    if (!trained_) {
+        throw std::logic_error("PQ::train deve ser chamado antes de addImage.");
+    }
+
+    const float* f = store_->features(id);
+    const size_t position = ids_.size();
+    ids_.push_back(id);
+
+    if (bits_ == 8) {
+        for (int m = 0; m < subspaces_; ++m) {
+            const size_t width = offsets_[m + 1] - offsets_[m];
+            codes_.push_back(static_cast<uint8_t>(
+                nearestCentroid(f + offsets_[m], centroid(m, 0), centroidNorms_.data() + m * centroids_, centroids_, width)));
+        }
+        return;
+    }
+
+    const size_t blockBytes = kFastScanCentroids * subspaces_;
+    if (position % kBlockImages == 0) codes_.resize(codes_.size() + blockBytes, 0);
+    uint8_t* block = codes_.data() + position / kBlockImages * blockBytes;
+    const size_t j = position % kBlockImages;
+    for (int m = 0; m < subspaces_; ++m) {
+        const size_t width = offsets_[m + 1] - offsets_[m];
+        const auto c = static_cast<uint8_t>(
+            nearestCentroid(f + offsets_[m], centroid(m, 0), centroidNorms_.data() + m * centroids_, centroids_, width));
+        block[m * 16 + j % 16] |= j < 16 ? c : static_cast<uint8_t>(c << 4);
+    }
+}
+
+uint8_t PQ::code(size_t position, int m) const {
+    if (bits_ == 8) return codes_[position * subspaces_ + m];
+    const uint8_t byte = codes_[position / kBlockImages * kFastScanCentroids * subspaces_ + m * 16 + position % 16];
+    return position % kBlockImages < 16 ? byte & 15 : byte >> 4;
+}
+
+FeatureVector PQ::reconstruct(size_t position) const {
+    FeatureVector v(dimension_);
+    for (int m = 0; m < subspaces_; ++m) {
+        const float* c = centroid(m, code(position, m));
+        std::copy(c, c + (offsets_[m + 1] - offsets_[m]), v.data() + offsets_[m]);
+    }
+    return v;
+}
+
+std::vector<float> PQ::distanceTable(const float* query) const {
+    // Subespaços curtos: um laço simples é mais rápido que uma chamada de kernel por centróide
+    std::vector<float> table(subspaces_ * centroids_);
+    for (int m = 0; m < subspaces_; ++m) {
+        const size_t width = offsets_[m + 1] - offsets_[m];
+        const float* q = query + offsets_[m];
+        for (size_t k = 0; k < centroids_; ++k) {
+            const float* c = centroid(m, k);
+            float sum = 0.0f;
+            for (size_t d = 0; d < width; ++d) sum += (q[d] - c[d]) * (q[d] - c[d]);
+            table[m * centroids_ + k] = sum;
+        }
+    }
+    return table;
+}
+
+int PQ::findNearest(const FeatureVector& query, int ignoreIndex, int* comparisons_out) const {
+    if (comparisons_out) *comparisons_out = static_cast<int>(ids_.size());
+    if (ids_.empty()) return -1;
+
+    requireSameDimension(query.size(), dimension_);
+
+    const std::vector<float> table = distanceTable(query.data());
+    return bits_ == 8 ? scanBytes(table, ignoreIndex) : fastScan(table, ignoreIndex);
+}
+
+int PQ::scanBytes(const std::vector<float>& table, int ignoreIndex) const {
+    // 4 imagens por vez: as somas são cadeias de adições dependentes, então
+    // intercalar 4 delas esconde a latência (a ordem de cada soma não muda)
+    const size_t group = 4;
+    int best = -1;
+    float bestDistance = std::numeric_limits<float>::infinity();
+    auto consider = [&](size_t position, float d) {
+        if (d < bestDistance && static_cast<int>(ids_[position]) != ignoreIndex) {
+            bestDistance = d;
+            best = static_cast<int>(ids_[position]);
+        }
+    };
+
+    size_t position = 0;
+    for (; position + group <= ids_.size(); position += group) {
+        const uint8_t* c = codes_.data() + position * subspaces_;
+        float d[group] = {};
+        for (int m = 0; m < subspaces_; ++m) {
+            const float* t = table.data() + m * centroids_;
+            for (size_t g = 0; g < group; ++g) d[g] += t[c[g * subspaces_ + m]];
+        }
+        for (size_t g = 0; g < group; ++g) consider(position + g, d[g]);
+    }
+    for (; position < ids_.size(); ++position) {
+        const uint8_t* c = codes_.data() + position * subspaces_;
+        float d = 0.0f;
+        for (int m = 0; m < subspaces_; ++m) d += table[m * centroids_ + c[m]];
+        consider(position, d);
+    }
+    return best;
+}
+
+int PQ::fastScan(const std::vector<float>& table, int ignoreIndex) const {
+    // Tabelas em bytes: floor((t - mínimo do subespaço) / passo), com o mesmo
+    // passo para todos os subespaços. Como cada byte subestima em menos de 1
+    // passo, a soma Q de uma imagem fica em ((D - base) / passo - M, (D - base) / passo]:
+    // uma imagem com distância D < melhor tem Q < (melhor - base) / passo.
+    std::vector<uint8_t> lut(subspaces_ * kFastScanCentroids);
+    std::vector<float> minimum(subspaces_);
+    double base = 0.0, span = 0.0;
+    for (int m = 0; m < subspaces_; ++m) {
+        const float* t = table.data() + m * kFastScanCentroids;
+        minimum[m] = *std::min_element(t, t + kFastScanCentroids);
+        span = std::max(span, static_cast<double>(*std::max_element(t, t + kFastScanCentroids) - minimum[m]));
+        base += minimum[m];
+    }
+    const double step = span > 0.0 ? span / 255.0 : 1.0;
+    for (int m = 0; m < subspaces_; ++m) {
+        for (size_t k = 0; k < kFastScanCentroids; ++k) {
+            const double q = std::floor((table[m * kFastScanCentroids + k] - minimum[m]) / step);
+            lut[m * kFastScanCentroids + k] = static_cast<uint8_t>(std::min(255.0, std::max(0.0, q)));
+        }
+    }
+
+    static const BlockFn scanBlock = blockFn();
+    const size_t blockBytes = kFastScanCentroids * subspaces_;
+    int best = -1;
+    float bestDistance = std::numeric_limits<float>::infinity();
+    int limit = std::numeric_limits<int>::max();
+
+    for (size_t first = 0; first < ids_.size(); first += kBlockImages) {
+        const uint8_t* block = codes_.data() + first / kBlockImages * blockBytes;
+        const uint32_t mask = scanBlock(lut.data(), block, subspaces_, limit);
+        if (mask == 0) continue;
+
+        // Candidatos conferidos com a tabela em float (mesma soma de scanBytes)
+        for (size_t j = 0; j < kBlockImages; ++j) {
+            const size_t position = first + j;
+            if (!((mask >> j) & 1) || position >= ids_.size() || static_cast<int>(ids_[position]) == ignoreIndex) {
+                continue;
+            }
+
+            float d = 0.0f;
+            for (int m = 0; m < subspaces_; ++m) {
+                const uint8_t byte = block[m * 16 + j % 16];
+                d += table[m * kFastScanCentroids + (j < 16 ? byte & 15 : byte >> 4)];
+            }
+            if (d < bestDistance) {
+                bestDistance = d;
+                best = static_cast<int>(ids_[position]);
+                // +1 passo de folga para os arredondamentos em float
+                limit = static_cast<int>(std::ceil((bestDistance - base) / step)) + 1;
+            }
+        }
+    }
+    return best;
+}
+
+ImageRef PQ::getImage(int index) const {
+    return store_->image(static_cast<uint32_t>(index));
+}
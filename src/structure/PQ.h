@@ -0,0 +1,112 @@
+// src/structure/PQ.h
+
+#ifndef PQ_H
+#define PQ_H
+
+#include "../core/FeatureStore.h"
+#include "../core/ThreadPool.h"
+#include "../core/Vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "List.h"
+
+/**
+ * Product Quantization (PQ): índice aproximado que guarda só códigos curtos.
+ *
+ * O vetor é dividido em M subespaços contíguos e cada subespaço é quantizado
+ * por um dicionário de 2^bits centróides treinado com k-means sobre uma
+ * amostra. Cada imagem vira M códigos (M bytes com 8 bits, M/2 com 4 bits),
+ * sem nenhuma cópia das características: 64 floats = 256 bytes viram 8.
+ *
+ * A busca é assimétrica (ADC): a consulta não é quantizada. Para cada consulta
+ * monta-se uma tabela com a distância ao quadrado de cada subvetor da consulta
+ * a cada centróide, e a distância a uma imagem é a soma de M consultas na
+ * tabela. Com 4 bits as tabelas de 16 entradas são reduzidas a bytes e cabem
+ * em um registrador, e a varredura ("fast-scan") avalia 32 imagens por
+ * instrução pshufb; os candidatos que ela não descarta são conferidos na
+ * tabela em float, então o resultado é o mesmo da ADC exata sobre os códigos.
+ *
+ * O resultado é aproximado (a distância é entre a consulta e a reconstrução da
+ * imagem pelos centróides). Os ids devolvidos são do FeatureStore, que deve
+ * viver mais que o índice (getImage lê o caminho e as características dele).
+ *
+ * Referência: Jégou, H., Douze, M., & Schmid, C. (2011). Product Quantization
+ * for Nearest Neighbor Search. André, F., Kermarrec, A.-M., & Le Scouarnec, N.
+ * (2015). Cache locality is not enough: High-Performance Nearest Neighbor
+ * Search with Product Quantization Fast Scan.
+ */
+class PQ {
+public:
+    /**
+     * @param store Imagens indexadas (deve viver mais que o índice)
+     * @param subspaces Número de subespaços (M), entre 1 e a dimensão; com 4 bits no máximo 128
+     * @param bits Bits por código: 8 (256 centróides) ou 4 (16 centróides, fast-scan)
+     */
+    PQ(const FeatureStore& store, int subspaces = 8, int bits = 8);
+
+    /**
+     * @brief Treina os dicionários com k-means sobre até `sampleSize` imagens
+     * do store sorteadas com `seed` (todas, se houver menos). Com `pool`, os
+     * subespaços são treinados em paralelo. Deve ser chamado antes de addImage.
+     */
+    void train(size_t sampleSize = 4096, int iterations = 16, unsigned seed = 42, ThreadPool* pool = nullptr);
+
+    void addImage(uint32_t id);
+
+    /**
+     * @brief Id da imagem com menor distância ADC (-1 se o índice estiver
+     * vazio); empates ficam com a primeira inserida. `ignoreIndex` é um id.
+     */
+    int findNearest(const FeatureVector& query, int ignoreIndex = -1, int* comparisons_out = nullptr) const;
+
+    /**
+     * @brief Vetor reconstruído pelos centróides da imagem na posição
+     * `position` (ordem de addImage). A distância ADC é a distância euclidiana
+     * ao quadrado entre a consulta e esta reconstrução.
+     */
+    FeatureVector reconstruct(size_t position) const;
+
+    ImageRef getImage(int index) const;
+
+    size_t size() const { return ids_.size(); }
+    bool trained() const { return trained_; }
+    int bits() const { return bits_; }
+    int subspaces() const { return subspaces_; }
+
+    /**
+     * @brief Bytes dos códigos (sem dicionários nem ids).
+     */
+    size_t codeBytes() const { return codes_.size(); }
+
+private:
+    const FeatureStore* store_;
+    int subspaces_;         // M
+    int bits_;              // 4 ou 8
+    size_t centroids_;      // 2^bits
+    size_t dimension_;
+    std::vector<size_t> offsets_;  // início de cada subespaço (M + 1 posições)
+    std::vector<float> codebooks_; // [M][centroids_][tamanho do subespaço], em sequência
+    std::vector<float> centroidNorms_; // [M][centroids_] ||c||², para nearestInTile
+    bool trained_ = false;
+
+    std::vector<uint32_t> ids_;
+    // 8 bits: M bytes por imagem. 4 bits: blocos de 32 imagens, 16 bytes por
+    // subespaço; o byte j guarda o código da imagem j (nibble baixo) e da j + 16 (alto)
+    std::vector<uint8_t> codes_;
+
+    const float* centroid(int m, size_t k) const {
+        return codebooks_.data() + offsets_[m] * centroids_ + k * (offsets_[m + 1] - offsets_[m]);
+    }
+
+    uint8_t code(size_t position, int m) const;
+    void trainSubspace(int m, const std::vector<uint32_t>& sample, int iterations, unsigned seed);
+
+    // Tabela ADC da consulta: [M][centroids_] distâncias ao quadrado
+    std::vector<float> distanceTable(const float* query) const;
+
+    int scanBytes(const std::vector<float>& table, int ignoreIndex) const;
+    int fastScan(const std::vector<float>& table, int ignoreIndex) const;
+};
+
+#endif // PQ_H
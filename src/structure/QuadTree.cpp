@@ -1,11 +1,13 @@
 // src/structure/QuadTree.cpp
 
 #include "QuadTree.h"
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <stdexcept>
 
-QuadTree::QuadTree(const BoundingBox& region, int capacity, int maxDepth)
-    : region(region), capacity(capacity), maxDepth(maxDepth),
+QuadTree::QuadTree(const FeatureStore& store, const BoundingBox& region, int capacity, int maxDepth)
+    : store(&store), region(region), capacity(capacity), maxDepth(maxDepth),
       count(0), divided(false) {
     for (int i = 0; i < 4; i++) children[i] = nullptr;
 }
@@ -24,27 +26,33 @@ void QuadTree::subdivide() {
     BoundingBox sw = {region.x_min, midX, region.y_min, midY};
     BoundingBox se = {midX, region.x_max, region.y_min, midY};
 
-    children[0] = new QuadTree(nw, capacity, maxDepth - 1);
-    children[1] = new QuadTree(ne, capacity, maxDepth - 1);
-    children[2] = new QuadTree(sw, capacity, maxDepth - 1);
-    children[3] = new QuadTree(se, capacity, maxDepth - 1);
+    children[0] = new QuadTree(*store, nw, capacity, maxDepth - 1);
+    children[1] = new QuadTree(*store, ne, capacity, maxDepth - 1);
+    children[2] = new QuadTree(*store, sw, capacity, maxDepth - 1);
+    children[3] = new QuadTree(*store, se, capacity, maxDepth - 1);
 
     divided = true;
 }
 
-void QuadTree::insert(const ImageData& image, const FeatureVector& position, int index) {
+void QuadTree::insert(uint32_t id, const FeatureVector& position) {
     if (!contains(position)) return;
 
     if (entries.size() < capacity || maxDepth == 0) {
-        entries.push_back({image, index});
+        entries.push_back({id});
         count++;
         return;
     }
 
     if (!divided) subdivide();
 
+    // Só no primeiro filho que contém a posição: um ponto na fronteira entre
+    // dois quadrantes não pode aparecer duas vezes nos resultados
     for (int i = 0; i < 4; i++) {
-        children[i]->insert(image, position, index);
+        if (children[i]->contains(position)) {
+            children[i]->insert(id, position);
+            count++;
+            return;
+        }
     }
 }
 
@@ -54,13 +62,14 @@ int QuadTree::findNearest(const FeatureVector& query, int ignoreIndex, int& comp
 
     // verifica entradas locais
     for (const auto& entry : entries) {
-        if (entry.index == ignoreIndex) continue;
+        if (static_cast<int>(entry.id) == ignoreIndex) continue;
 
-        double distance = calculateEuclideanDistance(query, entry.image.features);
+        requireSameDimension(query.size(), store->dimension());
+        double distance = euclideanDistance(query.data(), store->features(entry.id), query.size());
 
         if (distance < minDistance) {
             minDistance = distance;
-            nearestIndex = entry.index;
+            nearestIndex = static_cast<int>(entry.id);
         }
     }
 
@@ -69,7 +78,7 @@ int QuadTree::findNearest(const FeatureVector& query, int ignoreIndex, int& comp
         for (int i = 0; i < 4; i++) {
             int candidate = children[i]->findNearest(query, ignoreIndex, comparisons);
             if (candidate != -1) {
-                double distance = calculateEuclideanDistance(query, children[i]->getImage(candidate).features);
+                double distance = euclideanDistance(query.data(), store->features(candidate), query.size());
                 comparisons++;
                 if (distance < minDistance) {
                     minDistance = distance;
@@ -82,11 +91,45 @@ int QuadTree::findNearest(const FeatureVector& query, int ignoreIndex, int& comp
     return nearestIndex;
 }
 
+void QuadTree::findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out, int ignoreIndex) const {
+    NeighborHeap heap(out, std::min(k, count));
+    if (count == 0) return;
+
+    requireSameDimension(query.size(), store->dimension());
+
+    dispatchDimension(query.size(), [&](auto dim) {
+        forEachEntry([&](uint32_t id) {
+            if (static_cast<int>(id) == ignoreIndex) return;
+            heap.push(static_cast<int>(id), squaredEuclideanDistance<decltype(dim)::value>(
+                                                query.data(), store->features(id), query.size(), heap.bound()));
+        });
+    });
+    heap.finish([](double squared) { return std::sqrt(squared); });
+}
+
+void QuadTree::findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                           int ignoreIndex) const {
+    out.clear();
+    if (count == 0) return;
+
+    requireSameDimension(query.size(), store->dimension());
+
+    const double bound = radius * radius;
+    dispatchDimension(query.size(), [&](auto dim) {
+        forEachEntry([&](uint32_t id) {
+            if (static_cast<int>(id) == ignoreIndex) return;
+            const double squared = squaredEuclideanDistance<decltype(dim)::value>(query.data(), store->features(id),
+                                                                                  query.size(), bound);
+            if (squared <= bound) out.push_back({static_cast<int>(id), squared});
+        });
+    });
+    sortNeighbors(out, [](double squared) { return std::sqrt(squared); });
+}
 
-const ImageData& QuadTree::getImage(int index) const  {
+ImageRef QuadTree::getImage(int index) const  {
     for (const auto& entry : entries) {
-        if (entry.index == index) {
-            return entry.image;
+        if (static_cast<int>(entry.id) == index) {
+            return store->image(entry.id);
         }
     }
 
@@ -2,8 +2,11 @@
 
     #pragma once
 
+    #include <cstdint>
     #include <vector>
     #include <string>
+    #include "../core/FeatureStore.h"
+    #include "../core/Neighbors.h"
     #include "../core/Vector.h"
     #include "List.h"
 
@@ -13,22 +16,40 @@
     };
 
     struct QuadTreeEntry {
-        ImageData image;
-        int index; // índice global da imagem
+        uint32_t id; // id da imagem no FeatureStore
     };
 
     class QuadTree {
     public:
-        QuadTree(const BoundingBox& region, int capacity = 4, int maxDepth = 10);
+        QuadTree(const FeatureStore& store, const BoundingBox& region, int capacity = 4, int maxDepth = 10);
 
-        void insert(const ImageData& image, const FeatureVector& position, int index);
+        void insert(uint32_t id, const FeatureVector& position);
         int findNearest(const FeatureVector& query, int ignoreIndex = -1, int& comparisons = *(new int(0))) const;
-        const ImageData& getImage(int index) const;
+
+        // k mais próximos e busca por raio (veja ImageList::findKNearest). As
+        // posições são chaves 2D arbitrárias, sem relação garantida com a
+        // distância entre as características, então todos os nós são visitados
+        // (como em findNearest); só o abandono antecipado usa o k-ésimo melhor.
+        void findKNearest(const FeatureVector& query, size_t k, std::vector<Neighbor>& out, int ignoreIndex = -1) const;
+        std::vector<Neighbor> findKNearest(const FeatureVector& query, size_t k, int ignoreIndex = -1) const {
+            std::vector<Neighbor> out;
+            findKNearest(query, k, out, ignoreIndex);
+            return out;
+        }
+        void findInRange(const FeatureVector& query, double radius, std::vector<Neighbor>& out,
+                         int ignoreIndex = -1) const;
+        std::vector<Neighbor> findInRange(const FeatureVector& query, double radius, int ignoreIndex = -1) const {
+            std::vector<Neighbor> out;
+            findInRange(query, radius, out, ignoreIndex);
+            return out;
+        }
+        ImageRef getImage(int index) const;
 
         size_t size() const { return count; }
         bool empty() const { return count == 0; }
 
     private:
+        const FeatureStore* store;
         BoundingBox region;
         int capacity;
         int maxDepth;
@@ -40,4 +61,13 @@
 
         bool contains(const FeatureVector& pos) const;
         void subdivide();
+
+        // Chama fn(id) para cada entrada deste nó e dos descendentes
+        template <typename Fn>
+        void forEachEntry(Fn&& fn) const {
+            for (const auto& entry : entries) fn(entry.id);
+            if (divided) {
+                for (int i = 0; i < 4; i++) children[i]->forEachEntry(fn);
+            }
+        }
     };